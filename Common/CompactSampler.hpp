@@ -0,0 +1,209 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef COMPACTSAMPLER_HPP_
+#define COMPACTSAMPLER_HPP_
+
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <cassert>
+#include <stdint.h>
+
+namespace Helios {
+
+	/*
+	 * Class to sample objects with probabilities defined by a cross section, using an interpolation
+	 * factor (as the FactorSampler does). The accumulated table is stored in single precision, and
+	 * if it takes less memory (threshold reactions) each row only keeps the range of reactions where
+	 * the accumulated value changes. The memory is at most a half of the dense double table.
+	 *
+	 *   ---------> Accumulated cross section for each reaction
+	 * |          [r-0] [r-1] [r-2] [r-3] .... [r-n-1]
+	 * | [e-0]      -     -     -     -          -      <- zero, not stored
+	 * | [e-m0]    0.1   0.2   0.35  0.5  ....  0.98
+	 * |  ...
+	 * | [e-m1]     -     -    0.15  0.3   0.5    =     <- leading zeros and the trailing constant value are not stored
+	 * | [e-n]      -     -     -     -          -      <- zero, not stored
+	 *
+	 * The last reaction is not stored, it is sampled when the value is bigger than the
+	 * accumulated cross section of the reaction n-1. The rows are appended one by one (trimmed), so
+	 * the dense double matrix is never allocated. When all the rows are stored with all the reactions
+	 * the index of the rows is dropped.
+	 */
+	template<class TypeReaction>
+	class CompactSampler {
+
+		/* Number of reactions */
+		size_t nreaction;
+		/* Number of energies (total, not stored) */
+		size_t nenergy;
+		/* First energy index stored (the rows before it are zero) */
+		size_t emin;
+		/* Number of rows with some cross section different from zero (the rows after them are dropped) */
+		size_t nonzero_rows;
+		/* Number of rows stored */
+		size_t nrows;
+		/* All the reactions (but the last one) are stored on each row, without an index */
+		bool full_rows;
+
+		/* Container of reactions */
+		std::vector<TypeReaction> reactions;
+
+		/* Accumulated values of each stored row, one after the other */
+		std::vector<float> reaction_matrix;
+		/* Offset of each row on the matrix (plus the end of the last one), only with trimmed rows */
+		std::vector<uint32_t> row_offset;
+		/* First reaction stored on each row, only with trimmed rows */
+		std::vector<uint32_t> row_first;
+
+		/* Get an interpolated value on the matrix (zero outside of the stored range) */
+		double interpolate(size_t nerg, size_t nrea, double factor) const {
+			double low = getValue(nerg, nrea);
+			double high = getValue(nerg + 1, nrea);
+			return factor * (high - low) + low;
+		}
+
+		/* Get a value on the matrix */
+		double getValue(size_t nerg, size_t nrea) const {
+			if(nerg < emin || nerg >= emin + nrows) return 0.0;
+			size_t row = nerg - emin;
+			if(full_rows) return reaction_matrix[row * (nreaction - 1) + nrea];
+			size_t begin = row_offset[row];
+			size_t end = row_offset[row + 1];
+			if(nrea < row_first[row] || begin == end) return 0.0;
+			/* After the last stored reaction the accumulated value doesn't change */
+			return reaction_matrix[std::min(begin + (nrea - row_first[row]), end - 1)];
+		}
+
+	public:
+
+		/*
+		 * Create a sampler for <reactions> over a grid of <nenergy> points. The rows should be
+		 * set with setRow (on increasing energy index) and then trimmed with compact.
+		 */
+		CompactSampler(const std::vector<TypeReaction>& reactions, size_t nenergy) :
+			nreaction(reactions.size()), nenergy(nenergy), emin(0), nonzero_rows(0), nrows(0), full_rows(false),
+			reactions(reactions), row_offset(1, 0) {/* */}
+
+		/* Set the cross section of each reaction at some energy index (after the previous one) */
+		void setRow(size_t nerg, const std::vector<double>& xs) {
+			/* Sanity check */
+			assert(xs.size() == nreaction);
+			assert(nerg < nenergy);
+			/* Range of the reactions (but the last one) where the accumulated value changes */
+			size_t first = 0;
+			while(first < nreaction - 1 && xs[first] == 0.0) ++first;
+			size_t last = nreaction - 1;
+			while(last > first && xs[last - 1] == 0.0) --last;
+			double total = 0.0;
+			for(size_t nrea = 0 ; nrea < nreaction ; ++nrea)
+				total += xs[nrea];
+			/* The rows before the first one with a cross section are not stored */
+			if(nrows == 0) {
+				if(total <= 0.0) return;
+				emin = nerg;
+			}
+			assert(not full_rows);
+			assert(nerg == emin + nrows);
+			/* Accumulate in double precision, store in single precision */
+			double partial_sum = 0.0;
+			for(size_t nrea = 0 ; nrea < first ; ++nrea)
+				partial_sum += xs[nrea];
+			for(size_t nrea = first ; nrea < last ; ++nrea) {
+				partial_sum += xs[nrea];
+				reaction_matrix.push_back(partial_sum);
+			}
+			assert(reaction_matrix.size() <= std::numeric_limits<uint32_t>::max());
+			row_first.push_back(first);
+			row_offset.push_back(reaction_matrix.size());
+			nrows++;
+			if(total > 0.0) nonzero_rows = nrows;
+		}
+
+		/*
+		 * Remove the rows after the last one where the cross sections are different from zero, and
+		 * store all the reactions of each row if that takes less memory than the trimmed rows.
+		 */
+		void compact() {
+			if(full_rows) return;
+			nrows = nonzero_rows;
+			row_first.resize(nrows);
+			row_offset.resize(nrows + 1);
+			size_t trimmed = row_offset.back() * sizeof(float) + (row_offset.size() + row_first.size()) * sizeof(uint32_t);
+			if(nrows * (nreaction - 1) * sizeof(float) <= trimmed) {
+				std::vector<float> matrix(nrows * (nreaction - 1));
+				for(size_t row = 0 ; row < nrows ; ++row)
+					for(size_t nrea = 0 ; nrea < nreaction - 1 ; ++nrea)
+						matrix[row * (nreaction - 1) + nrea] = getValue(emin + row, nrea);
+				reaction_matrix.swap(matrix);
+				std::vector<uint32_t>().swap(row_first);
+				std::vector<uint32_t>().swap(row_offset);
+				full_rows = true;
+				return;
+			}
+			std::vector<uint32_t>(row_first).swap(row_first);
+			std::vector<uint32_t>(row_offset).swap(row_offset);
+			std::vector<float>(reaction_matrix.begin(), reaction_matrix.begin() + row_offset.back()).swap(reaction_matrix);
+		}
+
+		/*
+		 * Sample a reaction
+		 * index : row on the reaction matrix
+		 * value : number between 0.0 and the total cross section at this energy. <factor> is
+		 * used to get an interpolated value when doing the binary search.
+		 */
+		TypeReaction sample(size_t index, double value, double factor) const {
+			if(nreaction == 1) return reactions[0];
+			/* Binary search over the interpolated values */
+			size_t first = 0;
+			size_t len = nreaction - 1;
+			while (len > 0) {
+				size_t half = len >> 1;
+				size_t middle = first + half;
+				if (interpolate(index, middle, factor) < value) {
+					first = middle + 1;
+					len = len - half - 1;
+				} else len = half;
+			}
+			return reactions[first];
+		}
+
+		/* Get reaction container */
+		const std::vector<TypeReaction>& getReactions() const {return reactions;}
+
+		/* Memory used by the matrix and the index of its rows (in bytes) */
+		size_t size() const {
+			return reaction_matrix.size() * sizeof(float) + (row_offset.size() + row_first.size()) * sizeof(uint32_t);
+		}
+
+		~CompactSampler() {/* */};
+	};
+
+} /* namespace Helios */
+
+#endif /* COMPACTSAMPLER_HPP_ */
@@ -0,0 +1,17 @@
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// File        : config.h
+// Description : Configuration of Helios++
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#define PROJECT "Helios++"
+#define PROJECT_VERSION "0.1"
+#define BUILD_TYPE "release"
+#define COMPILER_NAME "/usr/bin/c++"
+#define COMPILER_FLAGS ""
+#define GIT_SHA1 "e8505619b428da4ce988dd0bff29b8e801bd1519"
+#define COMPILATION_DATE "10/18/2026 - 04:47:14 PM"
+
+#endif // CONFIG_H
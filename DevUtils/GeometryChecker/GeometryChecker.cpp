@@ -0,0 +1,172 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GeometryChecker.hpp"
+#include "../../Geometry/Cell.hpp"
+#include "../../Geometry/Surface.hpp"
+#include "../../Geometry/Universe.hpp"
+#include "../../Geometry/GeometryState.hpp"
+#include "../../Transport/Particle.hpp"
+
+using namespace std;
+using namespace Helios;
+
+/* Random numbers reserved for each ray */
+static const size_t max_rng_per_ray = 100;
+
+GeometryChecker::GeometryChecker(const Geometry* geometry, const Coordinate& lower, const Coordinate& upper,
+		                         size_t max_failures) :
+	geometry(geometry), lower(lower), upper(upper), max_failures(max_failures) {
+	for(size_t i = 0 ; i < NTYPES ; ++i)
+		errors[i] = 0;
+	outside = 0;
+}
+
+void GeometryChecker::addFailure(const Failure& failure) const {
+	size_t nerrors = errors[failure.type].fetch_and_increment();
+	if(nerrors < max_failures) {
+		tbb::spin_mutex::scoped_lock lock(failures_mutex);
+		failures.push_back(failure);
+	}
+}
+
+void GeometryChecker::checkUniverse(const Universe* universe, const Coordinate& point) const {
+	/* Get all the cells of the universe that contain the point */
+	const vector<Cell*>& cells = universe->getCells();
+	vector<const Cell*> claimed;
+	for(vector<Cell*>::const_iterator it = cells.begin() ; it != cells.end() ; ++it)
+		if((*it)->isInside(point))
+			claimed.push_back(*it);
+
+	if(claimed.size() == 0) {
+		/* The base universe doesn't have a parent, the point is just outside the geometry */
+		if(universe->getParent()) {
+			Failure failure(UNDEFINED, point);
+			failure.cells.push_back(universe->getParent());
+			addFailure(failure);
+		} else
+			outside.fetch_and_increment();
+		return;
+	}
+
+	if(claimed.size() > 1) {
+		Failure failure(OVERLAP, point);
+		failure.cells = claimed;
+		addFailure(failure);
+	}
+
+	/* Go down on each cell */
+	for(vector<const Cell*>::const_iterator it = claimed.begin() ; it != claimed.end() ; ++it)
+		if((*it)->getFill())
+			checkUniverse((*it)->getFill(), point);
+}
+
+void GeometryChecker::checkPoint(const Coordinate& point) const {
+	checkUniverse(geometry->getUniverses()[0], point);
+}
+
+void GeometryChecker::checkRay(const Coordinate& start, const Direction& direction, size_t max_crossings) const {
+	const Cell* cell = geometry->findCell(start);
+	if(!cell || (cell->getFlag() & Cell::DEADCELL)) {
+		outside.fetch_and_increment();
+		return;
+	}
+	Particle particle;
+	particle.pos() = start;
+	particle.dir() = direction;
+	GeometryState state(geometry->getFlatGeometry());
+	for(size_t ncross = 0 ; ncross < max_crossings ; ++ncross) {
+		Surface* surface(0);
+		bool sense(true);
+		double distance(0.0);
+		/* Get next surface */
+		cell->intersect(particle.pos(), particle.dir(), surface, sense, distance, &state);
+		if(!surface) {
+			Failure failure(UNBOUNDED, particle.pos());
+			failure.direction = particle.dir();
+			failure.cells.push_back(cell);
+			addFailure(failure);
+			return;
+		}
+		/* Transport the particle and cross the surface (checking boundary conditions) */
+		particle.pos() = particle.pos() + distance * particle.dir();
+		const Cell* leaving = cell;
+		bool inside = surface->cross(particle, sense, cell, &state);
+		if(!cell) {
+			Failure failure(LOST, particle.pos());
+			failure.direction = particle.dir();
+			failure.cells.push_back(leaving);
+			failure.surface = surface;
+			addFailure(failure);
+			return;
+		}
+		if(!inside) return;
+	}
+}
+
+void GeometryChecker::RayChecker::operator() (const tbb::blocked_range<size_t>& range) const {
+	for(size_t k = range.begin() ; k < range.end() ; ++k) {
+		/* Jump random number generator */
+		Random r_local(r);
+		r_local.jump(k * max_rng_per_ray);
+		Coordinate start = checker.samplePoint(r_local);
+		Direction direction;
+		isotropicDirection(direction, r_local);
+		checker.checkRay(start, direction, max_crossings);
+	}
+}
+
+void GeometryChecker::checkPoints(size_t npoints, const Random& r) {
+	tbb::parallel_for(tbb::blocked_range<size_t>(0,npoints),PointChecker(*this,r));
+}
+
+void GeometryChecker::checkRays(size_t nrays, size_t max_crossings, const Random& r) {
+	tbb::parallel_for(tbb::blocked_range<size_t>(0,nrays),RayChecker(*this,r,max_crossings));
+}
+
+size_t GeometryChecker::getErrors() const {
+	size_t total = 0;
+	for(size_t i = 0 ; i < NTYPES ; ++i)
+		total += errors[i];
+	return total;
+}
+
+void GeometryChecker::report() const {
+	static const string names[NTYPES] = {"Overlap", "Undefined region", "Lost particle", "Unbounded cell"};
+	for(vector<Failure>::const_iterator it = failures.begin() ; it != failures.end() ; ++it) {
+		ostream& out = Log::msg();
+		out << Log::ident(1) << " - " << names[it->type] << " at (" << it->position[0] << " , "
+			<< it->position[1] << " , " << it->position[2] << ")";
+		if(it->type == LOST || it->type == UNBOUNDED)
+			out << " with direction (" << it->direction[0] << " , " << it->direction[1] << " , " << it->direction[2] << ")";
+		out << Log::endl;
+		for(vector<const Cell*>::const_iterator it_cell = it->cells.begin() ; it_cell != it->cells.end() ; ++it_cell)
+			Log::msg() << Log::ident(2) << " cell    : " << geometry->getPath(*it_cell) << Log::endl;
+		if(it->surface)
+			Log::msg() << Log::ident(2) << " surface : " << geometry->getPath(it->surface) << Log::endl;
+	}
+}
@@ -0,0 +1,163 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GEOMETRYCHECKER_HPP_
+#define GEOMETRYCHECKER_HPP_
+
+#include <vector>
+#include <tbb/task_scheduler_init.h>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <tbb/spin_mutex.h>
+#include <tbb/atomic.h>
+
+#include "../../Common/Common.hpp"
+#include "../../Geometry/Geometry.hpp"
+
+/*
+ * Check a geometry with random points and rays. A point is wrong if it is claimed by more than one cell of
+ * the same universe (overlap) or by none of them (undefined region). A ray is wrong if the next cell cannot
+ * be found after crossing a surface (lost particle) or if it never hits a surface (unbounded cell).
+ */
+class GeometryChecker {
+
+public:
+
+	/* Kind of errors found on the geometry */
+	enum ErrorType {
+		OVERLAP = 0,    /* Point inside more than one cell of the same universe */
+		UNDEFINED = 1,  /* Point inside a filled cell but outside all the cells of the universe */
+		LOST = 2,       /* Next cell not found after a ray crossed a surface */
+		UNBOUNDED = 3,  /* A ray didn't find any surface to cross */
+		NTYPES = 4
+	};
+
+	/* Information about a point (or ray) where the geometry is not well defined */
+	struct Failure {
+		ErrorType type;
+		/* Point where the error was found */
+		Helios::Coordinate position;
+		/* Direction of the ray (not used with points) */
+		Helios::Direction direction;
+		/* Cells claiming the point, or the cell the ray was leaving */
+		std::vector<const Helios::Cell*> cells;
+		/* Surface crossed when the ray was lost (NULL if any) */
+		const Helios::Surface* surface;
+		Failure(ErrorType type, const Helios::Coordinate& position) :
+			type(type), position(position), direction(0,0,0), surface(0) {/* */}
+	};
+
+	GeometryChecker(const Helios::Geometry* geometry, const Helios::Coordinate& lower, const Helios::Coordinate& upper,
+			        size_t max_failures);
+
+	/* Sample random points uniformly on the box and check the cells that contain each point */
+	void checkPoints(size_t npoints, const Helios::Random& r);
+
+	/* Sample random rays on the box and track them until they leave the geometry (or after a number of crossings) */
+	void checkRays(size_t nrays, size_t max_crossings, const Helios::Random& r);
+
+	/* Number of errors of some type */
+	size_t getErrors(ErrorType type) const {return errors[type];}
+	/* Total number of errors */
+	size_t getErrors() const;
+	/* Points (or starting points of rays) sampled outside the geometry */
+	size_t getOutside() const {return outside;}
+
+	/* Print the failures saved (with the full path of each cell and surface involved) */
+	void report() const;
+
+	~GeometryChecker() {/* */}
+
+private:
+
+	/* Sample a point inside the box */
+	Helios::Coordinate samplePoint(Helios::Random& r) const {
+		double x = lower[0] + r.uniform() * (upper[0] - lower[0]);
+		double y = lower[1] + r.uniform() * (upper[1] - lower[1]);
+		double z = lower[2] + r.uniform() * (upper[2] - lower[2]);
+		return Helios::Coordinate(x,y,z);
+	}
+
+	/* Check a point on a universe, and go down on each cell filled with other universe */
+	void checkUniverse(const Helios::Universe* universe, const Helios::Coordinate& point) const;
+
+	/* Check a point starting from the base universe */
+	void checkPoint(const Helios::Coordinate& point) const;
+
+	/* Track a ray */
+	void checkRay(const Helios::Coordinate& start, const Helios::Direction& direction, size_t max_crossings) const;
+
+	/* Save a failure (only the first ones) */
+	void addFailure(const Failure& failure) const;
+
+	/* Check points in parallel */
+	class PointChecker {
+		const GeometryChecker& checker;
+		Helios::Random r;
+	public:
+		PointChecker(const GeometryChecker& checker, const Helios::Random& r) : checker(checker), r(r) {/* */}
+		void operator() (const tbb::blocked_range<size_t>& range) const {
+			/* Jump random number generator (3 numbers per point) */
+			Helios::Random r_local(r);
+			r_local.jump(3*range.begin());
+			for(size_t k = range.begin() ; k < range.end() ; ++k)
+				checker.checkPoint(checker.samplePoint(r_local));
+		}
+		~PointChecker() {/* */}
+	};
+
+	/* Check rays in parallel */
+	class RayChecker {
+		const GeometryChecker& checker;
+		Helios::Random r;
+		size_t max_crossings;
+	public:
+		RayChecker(const GeometryChecker& checker, const Helios::Random& r, size_t max_crossings) :
+			checker(checker), r(r), max_crossings(max_crossings) {/* */}
+		void operator() (const tbb::blocked_range<size_t>& range) const;
+		~RayChecker() {/* */}
+	};
+
+	/* Geometry */
+	const Helios::Geometry* geometry;
+	/* Box where the points are sampled */
+	Helios::Coordinate lower;
+	Helios::Coordinate upper;
+	/* Maximum number of failures saved (of each type) */
+	size_t max_failures;
+
+	/* Counters */
+	mutable tbb::atomic<size_t> errors[NTYPES];
+	mutable tbb::atomic<size_t> outside;
+
+	/* Failures saved */
+	mutable std::vector<Failure> failures;
+	mutable tbb::spin_mutex failures_mutex;
+
+};
+
+#endif /* GEOMETRYCHECKER_HPP_ */
@@ -0,0 +1,195 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <tbb/tick_count.h>
+
+#include "../../Parser/ParserTypes.hpp"
+#include "../../Geometry/Geometry.hpp"
+#include "../../Common/Common.hpp"
+#include "../../Environment/McEnvironment.hpp"
+#include "../../Geometry/VolumeCalculator.hpp"
+#include "GeometryChecker.hpp"
+
+using namespace std;
+using namespace Helios;
+namespace po = boost::program_options;
+
+int main(int argc, char **argv) {
+
+	/* Print header, always */
+	cout << endl;
+	Log::header();
+
+	/* Map of command line values */
+    po::variables_map vm;
+
+	/* Parse command line options */
+	double optFloat;
+	size_t optSize;
+	/* Generic options */
+	po::options_description generic("Generic options");
+	generic.add_options()
+		;
+
+	/* Declare a group of options that configure the checker */
+	po::options_description config("Configuration");
+	config.add_options()
+		("width,w", po::value<double>(&optFloat)->default_value(50.0),
+			  "half width of the box (x axis)")
+		("height,h", po::value<double>(&optFloat)->default_value(50.0),
+			   "half height of the box (y axis)")
+		("depth,d", po::value<double>(&optFloat)->default_value(50.0),
+			   "half depth of the box (z axis)")
+		("points,n", po::value<size_t>(&optSize)->default_value(1000000),
+			   "number of random points")
+		("rays,r", po::value<size_t>(&optSize)->default_value(100000),
+			   "number of random rays")
+		("crossings,c", po::value<size_t>(&optSize)->default_value(100),
+			   "maximum number of surfaces crossed by each ray")
+		("errors,e", po::value<size_t>(&optSize)->default_value(10),
+			   "maximum number of errors printed (of each type)")
+		("volume,v", po::value<double>(&optFloat)->default_value(0.0),
+			   "relative error of the stochastic volumes (zero to skip the calculation)")
+		("seed,s", po::value<size_t>(&optSize)->default_value(1),
+			   "seed of the random number generator")
+		;
+
+	/* Hidden options (input files) */
+	po::options_description hidden("Hidden options");
+	hidden.add_options()
+		("input-file", po::value< vector<string> >(), "input file")
+		;
+
+	po::options_description cmdline_options;
+	cmdline_options.add(generic).add(config).add(hidden);
+
+	po::options_description visible("Allowed options");
+	visible.add(generic).add(config);
+
+	po::positional_options_description p;
+	p.add("input-file", -1);
+
+	try {
+
+        store(po::command_line_parser(argc, argv).options(cmdline_options).positional(p).run(), vm);
+        po::notify(vm);
+
+        if (vm.size() == 0) {
+        	Log::msg() << visible << endl;
+            return 0;
+        }
+
+    }
+    catch(exception& e)
+    {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+	/* Container of filenames */
+    vector<string> input_files;
+    if(vm.count("input-file"))
+    	input_files = vm["input-file"].as< vector<string> >();
+    else {
+    	Log::msg() << visible << endl;
+    	return 1;
+    }
+
+	/* Parser (XML for now) */
+	Parser* parser = new XmlParser;
+
+	/* Environment */
+	McEnvironment environment(parser);
+	/* Parse files, to get the information to create the environment */
+	environment.parseFiles(input_files);
+	/* Setup the problem */
+	environment.setup();
+
+	/* Geometry */
+	Geometry* geometry = environment.getModule<Geometry>();
+
+	/* Box where the points are sampled */
+	double x = vm["width"].as<double>();
+	double y = vm["height"].as<double>();
+	double z = vm["depth"].as<double>();
+	size_t npoints = vm["points"].as<size_t>();
+	size_t nrays = vm["rays"].as<size_t>();
+
+	/* Initialization - Random number */
+	Random r(vm["seed"].as<size_t>());
+
+	GeometryChecker checker(geometry, Coordinate(-x,-y,-z), Coordinate(x,y,z), vm["errors"].as<size_t>());
+
+	Log::bok() << "Checking geometry " << Log::endl;
+	Log::msg() << Log::ident(1) << " - Box    = " << 2*x << " x " << 2*y << " x " << 2*z << Log::endl;
+
+	tbb::tick_count start = tbb::tick_count::now();
+	checker.checkPoints(npoints, r);
+	tbb::tick_count points_end = tbb::tick_count::now();
+	Log::msg() << Log::ident(1) << " - Points = " << npoints << " (" << (points_end - start).seconds() << " seconds)" << Log::endl;
+
+	/* Use another stream of numbers for the rays */
+	r.jump(3*npoints);
+	checker.checkRays(nrays, vm["crossings"].as<size_t>(), r);
+	tbb::tick_count rays_end = tbb::tick_count::now();
+	Log::msg() << Log::ident(1) << " - Rays   = " << nrays << " (" << (rays_end - points_end).seconds() << " seconds)" << Log::endl;
+
+	Log::msg() << Log::ident(1) << " - Outside the geometry : " << checker.getOutside() << Log::endl;
+	Log::msg() << Log::ident(1) << " - Overlaps             : " << checker.getErrors(GeometryChecker::OVERLAP) << Log::endl;
+	Log::msg() << Log::ident(1) << " - Undefined regions    : " << checker.getErrors(GeometryChecker::UNDEFINED) << Log::endl;
+	Log::msg() << Log::ident(1) << " - Lost particles       : " << checker.getErrors(GeometryChecker::LOST) << Log::endl;
+	Log::msg() << Log::ident(1) << " - Unbounded cells      : " << checker.getErrors(GeometryChecker::UNBOUNDED) << Log::endl;
+
+	size_t nerrors = checker.getErrors();
+	if(nerrors) {
+		Log::error() << "Geometry has " << nerrors << " errors " << Log::endl;
+		checker.report();
+	} else
+		Log::ok() << "No errors found on the geometry" << Log::endl;
+
+	/* Volumes of each region */
+	double relative_error = vm["volume"].as<double>();
+	if(relative_error > 0.0) {
+		Log::bok() << "Calculating volumes " << Log::endl;
+		/* Use another stream of numbers for the volumes */
+		r.jump(100*nrays);
+		VolumeCalculator volumes(geometry, Coordinate(-x,-y,-z), Coordinate(x,y,z));
+		tbb::tick_count volumes_start = tbb::tick_count::now();
+		volumes.calculate(r, relative_error);
+		tbb::tick_count volumes_end = tbb::tick_count::now();
+		Log::msg() << Log::ident(1) << " - Points = " << volumes.getPoints() << " (" << (volumes_end - volumes_start).seconds() << " seconds)" << Log::endl;
+		cout << endl;
+		volumes.print(cout);
+	}
+
+	delete parser;
+	return nerrors ? 1 : 0;
+}
@@ -27,6 +27,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <iostream>
 #include <string>
 #include <vector>
+#include <sstream>
 #include <boost/program_options.hpp>
 
 #include "../../Parser/ParserTypes.hpp"
@@ -39,6 +40,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../../Environment/McEnvironment.hpp"
 #include "pngwriter.hpp"
 #include "PngPlotter.hpp"
+#include "VoxelPlotter.hpp"
 
 using namespace std;
 using namespace Helios;
@@ -71,6 +73,19 @@ static string outputFile(const po::variables_map& vm) {
     return output;
 }
 
+/* Get the number of voxels on each axis from a string "nx,ny,nz" */
+static bool parseVoxels(const string& value, vector<int>& voxels) {
+	istringstream in(value);
+	for(int i = 0 ; i < 3 ; ++i) {
+		char comma;
+		if(i > 0 && (!(in >> comma) || comma != ',')) return false;
+		int n;
+		if(!(in >> n) || n <= 0) return false;
+		voxels.push_back(n);
+	}
+	return (in >> ws).eof();
+}
+
 int main(int argc, char **argv) {
 
 	/* Print header, always */
@@ -103,6 +118,11 @@ int main(int argc, char **argv) {
 			    "view (2 = xy ; 1 = xz ; 0 = yz)")
 		("output,o", po::value<string>(),
 		        "name of the output PNG file ")
+		("scanline,s", "walk each row of pixels as a ray (faster on big geometries)")
+		("depth,d", po::value<double>(&optFloat)->default_value(50.0),
+			   "depth of the voxel map")
+		("voxels,x", po::value<string>(),
+			   "number of voxels on each axis (nx,ny,nz) to dump a voxel map instead of the plot")
 		;
 
 	/* Hidden options (input files) */
@@ -178,6 +198,22 @@ int main(int argc, char **argv) {
 	/* Dimensions of the graph */
 	double x = vm["width"].as<double>();
 	double y = vm["height"].as<double>();
+
+	/* Voxel map of the geometry */
+	if(vm.count("voxels")) {
+		vector<int> voxels;
+		if(!parseVoxels(vm["voxels"].as<string>(),voxels)) {
+	    	Log::error() << "Invalid number of voxels (should be nx,ny,nz)" << endl;
+	    	return 1;
+		}
+		double z = vm["depth"].as<double>();
+		VoxelPlotter voxelPlotter(Coordinate(-x,-y,-z),Coordinate(x,y,z),voxels[0],voxels[1],voxels[2]);
+		voxelPlotter.plot(geometry);
+		voxelPlotter.dump(vm.count("output") ? vm["output"].as<string>() : "voxels.bin");
+		delete parser;
+		return 0;
+	}
+
 	/* Value where the plane intersect the axis */
 	double value = vm["value"].as<double>();
 	/* Pixel on the graph */
@@ -194,6 +230,7 @@ int main(int argc, char **argv) {
 
 	/* Initialize plotter */
 	PngPlotter pngPlotter(x,y,pixel,value);
+	pngPlotter.setScanline(vm.count("scanline"));
 
 	/* Initialization - Random number */
 	trng::lcg64 random;
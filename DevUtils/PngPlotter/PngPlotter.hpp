@@ -39,6 +39,7 @@
 #include "../../Geometry/Geometry.hpp"
 #include "../../Material/Materials.hpp"
 #include "pngwriter.hpp"
+#include "RowFinder.hpp"
 
 class PngPlotter {
 
@@ -52,6 +53,8 @@ class PngPlotter {
 	int pixel;
 	ColorMatrix colorMatrix;
 	double value;
+	/* Walk each row of pixels as a ray, instead of searching the cell of each pixel */
+	bool scanline;
 
 	/* Return a color is HSV format (tune the saturation value) */
 	Color colorFromCell(const int& cellId, const int& maxId) const {
@@ -82,40 +85,27 @@ class PngPlotter {
 		const double deltax;
 		const double deltay;
 
-		template<int uaxis>
-		static Helios::Coordinate setCoordinate(const double&x, const double&y, const double& value) {
-			switch(uaxis) {
-			case Helios::xaxis :
-				return Helios::Coordinate(value,x,y);
-				break;
-			case Helios::yaxis :
-				return Helios::Coordinate(y,value,x);
-				break;
-			case Helios::zaxis :
-				return Helios::Coordinate(x,y,value);
-				break;
-			}
-			return Helios::Coordinate();
-		}
+		/* Cells on each row */
+		const RowFinder<axis> rowFinder;
 
 	public:
 		MaterialFinder(const double& width, const double& height, const int& pixel,const double& value,
-				   const Helios::Geometry* geometry, ColorMatrix& colorMatrix) :
+				   const Helios::Geometry* geometry, ColorMatrix& colorMatrix, const bool& scanline) :
 				   pixel(pixel), geometry(geometry), colorMatrix(colorMatrix),
 				   xmin(-width), xmax(width), ymin(-height), ymax(height), value(value),
 				   deltax((xmax - xmin) / (double)(pixel)),
-				   deltay((ymax - ymin) / (double)(pixel)) {/* */}
+				   deltay((ymax - ymin) / (double)(pixel)),
+				   rowFinder(pixel,geometry,scanline,ymin,deltay,value) {/* */}
 
 		void operator() (const tbb::blocked_range<int>& r) const {
 			int matId = 0, oldId = 0;
-			for(int i = r.begin() ; i < r.end() ; ++i)
+			std::vector<const Helios::Cell*> cells(pixel);
+			for(int i = r.begin() ; i < r.end() ; ++i) {
+				double x = xmin + (double)i * deltax;
+				/* Find the cells on the row */
+				rowFinder(x,cells);
 				for(int j = 0 ; j < pixel ; ++j) {
-					double x = xmin + (double)i * deltax;
-					double y = ymin + (double)j * deltay;
-					/* Set point on the space */
-					Helios::Coordinate point(setCoordinate<axis>(x,y,value));
-					/* Find cell */
-					const Helios::Cell* findCell = geometry->findCell(point);
+					const Helios::Cell* findCell = cells[j];
 					if(findCell) {
 						/* Get material */
 						const Helios::Material* material = findCell->getMaterial();
@@ -127,6 +117,7 @@ class PngPlotter {
 						} else colorMatrix(i,j) = 0;
 					} else colorMatrix(i,j) = 0;
 				}
+			}
 			/* Now go backwards to set the black lines on the other side */
 			matId = 0, oldId = 0;
 			for(int j = 0 ; j < pixel ; ++j)
@@ -157,40 +148,27 @@ class PngPlotter {
 		const double deltax;
 		const double deltay;
 
-		template<int uaxis>
-		static Helios::Coordinate setCoordinate(const double&x, const double&y,const double& value) {
-			switch(uaxis) {
-			case Helios::xaxis :
-				return Helios::Coordinate(value,x,y);
-				break;
-			case Helios::yaxis :
-				return Helios::Coordinate(y,value,x);
-				break;
-			case Helios::zaxis :
-				return Helios::Coordinate(x,y,value);
-				break;
-			}
-			return Helios::Coordinate();
-		}
+		/* Cells on each row */
+		const RowFinder<axis> rowFinder;
 
 	public:
 		CellFinder(const double& width, const double& height, const int& pixel,const double& value,
-				   const Helios::Geometry* geometry, ColorMatrix& colorMatrix) :
+				   const Helios::Geometry* geometry, ColorMatrix& colorMatrix, const bool& scanline) :
 				   pixel(pixel), geometry(geometry), colorMatrix(colorMatrix),
 				   xmin(-width), xmax(width), ymin(-height), ymax(height), value(value),
 				   deltax((xmax - xmin) / (double)(pixel)),
-				   deltay((ymax - ymin) / (double)(pixel)) {/* */}
+				   deltay((ymax - ymin) / (double)(pixel)),
+				   rowFinder(pixel,geometry,scanline,ymin,deltay,value) {/* */}
 
 		void operator() (const tbb::blocked_range<int>& r) const {
 			int cellId = 0, oldId = 0;
-			for(int i = r.begin() ; i < r.end() ; ++i)
+			std::vector<const Helios::Cell*> cells(pixel);
+			for(int i = r.begin() ; i < r.end() ; ++i) {
+				double x = xmin + (double)i * deltax;
+				/* Find the cells on the row */
+				rowFinder(x,cells);
 				for(int j = 0 ; j < pixel ; ++j) {
-					double x = xmin + (double)i * deltax;
-					double y = ymin + (double)j * deltay;
-					/* Set point on the space */
-					Helios::Coordinate point(setCoordinate<axis>(x,y,value));
-					/* Find cell */
-					const Helios::Cell* findCell = geometry->findCell(point);
+					const Helios::Cell* findCell = cells[j];
 					if(findCell) {
 						cellId = findCell->getInternalId();
 						if(cellId != oldId) colorMatrix(i,j) = -1;
@@ -198,6 +176,7 @@ class PngPlotter {
 						oldId = cellId;
 					} else colorMatrix(i,j) = 0;
 				}
+			}
 		}
 
 		~CellFinder() {/* */}
@@ -285,6 +264,14 @@ public:
 		this->width = width;
 	}
 
+	bool getScanline() const {
+		return scanline;
+	}
+
+	void setScanline(bool scanline) {
+		this->scanline = scanline;
+	}
+
 	/* Function to plot a geometry */
 	template<int axis>
 	void plotMaterial(const Helios::Geometry* geometry);
@@ -303,13 +290,13 @@ public:
 template<int axis>
 void PngPlotter::plotMaterial(const Helios::Geometry* geometry) {
 	/* Get the color matrix */
-	tbb::parallel_for(tbb::blocked_range<int>(0,pixel),MaterialFinder<axis>(width,height,pixel,value,geometry,colorMatrix));
+	tbb::parallel_for(tbb::blocked_range<int>(0,pixel),MaterialFinder<axis>(width,height,pixel,value,geometry,colorMatrix,scanline));
 }
 
 template<int axis>
 void PngPlotter::plotCell(const Helios::Geometry* geometry) {
 	/* Get the color matrix */
-	tbb::parallel_for(tbb::blocked_range<int>(0,pixel),CellFinder<axis>(width,height,pixel,value,geometry,colorMatrix));
+	tbb::parallel_for(tbb::blocked_range<int>(0,pixel),CellFinder<axis>(width,height,pixel,value,geometry,colorMatrix,scanline));
 }
 
 template<int axis>
@@ -0,0 +1,130 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROWFINDER_HPP_
+#define ROWFINDER_HPP_
+
+#include <vector>
+
+#include "../../Common/Common.hpp"
+#include "../../Geometry/Geometry.hpp"
+#include "../../Geometry/GeometryState.hpp"
+
+/*
+ * Find the cell of each pixel on a row of the plot. On the scanline mode, the row is walked as a ray
+ * (intersecting and crossing surfaces) and the pixels between two crossings are filled with the same
+ * cell. Pixels too close to a crossing are searched from the base universe as the pixel sampling mode
+ * does (and the walk starts again from there), so both modes give the same plot.
+ */
+template<int axis>
+class RowFinder {
+
+	/* General information */
+	const int pixel;
+	const Helios::Geometry* geometry;
+	const bool scanline;
+
+	/* Coordinates of the pixels */
+	const double ymin;
+	const double deltay;
+	const double value;
+	/* Pixels closer than this value to a crossing are searched from the base universe */
+	const double tolerance;
+	/* Direction of the rows */
+	const Helios::Direction direction;
+
+public:
+	template<int uaxis>
+	static Helios::Coordinate setCoordinate(const double&x, const double&y, const double& value) {
+		switch(uaxis) {
+		case Helios::xaxis :
+			return Helios::Coordinate(value,x,y);
+			break;
+		case Helios::yaxis :
+			return Helios::Coordinate(y,value,x);
+			break;
+		case Helios::zaxis :
+			return Helios::Coordinate(x,y,value);
+			break;
+		}
+		return Helios::Coordinate();
+	}
+
+	RowFinder(const int& pixel, const Helios::Geometry* geometry, const bool& scanline,
+			  const double& ymin, const double& deltay, const double& value) :
+			  pixel(pixel), geometry(geometry), scanline(scanline), ymin(ymin), deltay(deltay), value(value),
+			  tolerance(1e-6 * deltay), direction(setCoordinate<axis>(0.0,1.0,0.0)) {/* */}
+
+	/* Get the cell of each pixel on the row with abscissa x (NULL if the pixel is outside the geometry) */
+	void operator() (const double& x, std::vector<const Helios::Cell*>& cells) const {
+		int j = 0;
+		bool walk = scanline;
+		while(j < pixel) {
+			/* Search the cell of this pixel */
+			Helios::Coordinate position(setCoordinate<axis>(x,ymin + (double)j * deltay,value));
+			const Helios::Cell* cell = geometry->findCell(position);
+			cells[j++] = cell;
+			if(!walk || !cell) continue;
+			/* Walk along the row until a pixel should be searched again */
+			Helios::GeometryState state(geometry->getFlatGeometry());
+			/*
+			 * The first pixel after the start of the walk and after each crossing is searched again. If the
+			 * cell is not the same, the walk started on a surface or the row runs along one; the rest of the
+			 * pixels are searched one by one.
+			 */
+			bool check = true;
+			while(j < pixel) {
+				Helios::Surface* surface(0);
+				bool sense(true);
+				double distance(0.0);
+				cell->intersect(position,direction,surface,sense,distance,&state);
+				double ycross = Helios::getOrdinate<axis>(position) + distance;
+				double y = ymin + (double)j * deltay;
+				if(check && y < ycross - tolerance) {
+					if(geometry->findCell(setCoordinate<axis>(x,y,value)) != cell) {
+						walk = false;
+						break;
+					}
+					check = false;
+				}
+				/* Fill the pixels until the crossing */
+				while(j < pixel && ymin + (double)j * deltay < ycross - tolerance)
+					cells[j++] = cell;
+				if(!surface || j == pixel || ymin + (double)j * deltay <= ycross + tolerance) break;
+				/* Cross the surface */
+				position = position + distance * direction;
+				surface->cross(position,sense,cell,&state);
+				if(!cell) break;
+				check = true;
+			}
+		}
+	}
+
+	~RowFinder() {/* */}
+};
+
+#endif /* ROWFINDER_HPP_ */
@@ -0,0 +1,151 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fstream>
+
+#include "VoxelPlotter.hpp"
+#include "RowFinder.hpp"
+#include "../../Geometry/Cell.hpp"
+#include "../../Material/Material.hpp"
+
+using namespace std;
+using namespace Helios;
+
+VoxelPlotter::VoxelPlotter(const Coordinate& lower, const Coordinate& upper, int nx, int ny, int nz) :
+	lower(lower), upper(upper), nx(nx), ny(ny), nz(nz), geometry(0) {
+
+	Log::bok() << "Initializing Voxel Plotter " << Log::endl;
+	Log::msg() << Log::ident(1) << " - Size   = " << upper[0] - lower[0] << " x " << upper[1] - lower[1]
+			   << " x " << upper[2] - lower[2] << Log::endl;
+	Log::msg() << Log::ident(1) << " - Voxels = " << nx << " x " << ny << " x " << nz << Log::endl;
+}
+
+void VoxelPlotter::RowPlotter::operator() (const tbb::blocked_range<size_t>& range) const {
+	double deltax = (plotter.upper[0] - plotter.lower[0]) / (double)plotter.nx;
+	double deltay = (plotter.upper[1] - plotter.lower[1]) / (double)plotter.ny;
+	double deltaz = (plotter.upper[2] - plotter.lower[2]) / (double)plotter.nz;
+	/* The value of each voxel is taken on its center */
+	double xmin = plotter.lower[0] + 0.5 * deltax;
+	vector<const Cell*> cells(plotter.nx);
+	for(size_t row = range.begin() ; row < range.end() ; ++row) {
+		int j = row % plotter.ny;
+		int k = row / plotter.ny;
+		double y = plotter.lower[1] + ((double)j + 0.5) * deltay;
+		double z = plotter.lower[2] + ((double)k + 0.5) * deltaz;
+		/* Walk along the x axis (the plane of the row is y = constant, and z is the abscissa) */
+		RowFinder<yaxis> rowFinder(plotter.nx,geometry,true,xmin,deltax,y);
+		rowFinder(z,cells);
+		/* Encode the row */
+		RunContainer& cell_runs = plotter.cell_rows[row];
+		RunContainer& material_runs = plotter.material_rows[row];
+		for(int i = 0 ; i < plotter.nx ; ++i) {
+			const Cell* cell = cells[i];
+			if(cell) {
+				push(cell_runs,cell->getInternalId());
+				const Material* material = cell->getMaterial();
+				push(material_runs,material ? (int)material->getInternalId() : -1);
+			} else {
+				push(cell_runs,-1);
+				push(material_runs,-1);
+			}
+		}
+	}
+}
+
+void VoxelPlotter::plot(const Geometry* geometry) {
+	this->geometry = geometry;
+	size_t nrows = (size_t)ny * (size_t)nz;
+	cell_rows.assign(nrows,RunContainer());
+	material_rows.assign(nrows,RunContainer());
+	tbb::parallel_for(tbb::blocked_range<size_t>(0,nrows),RowPlotter(*this,geometry));
+}
+
+template<class T>
+static void write(std::ostream& out, const T& value) {
+	out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void writeString(std::ostream& out, const std::string& value) {
+	write<int>(out,value.size());
+	out.write(value.c_str(), value.size());
+}
+
+void VoxelPlotter::dumpRuns(std::ostream& out, const std::vector<RunContainer>& rows) {
+	/* Join the runs of consecutive rows */
+	RunContainer runs;
+	for(vector<RunContainer>::const_iterator it = rows.begin() ; it != rows.end() ; ++it) {
+		RunContainer::const_iterator it_run = it->begin();
+		if(it_run != it->end() && runs.size() && runs.back().value == it_run->value) {
+			runs.back().length += it_run->length;
+			++it_run;
+		}
+		runs.insert(runs.end(), it_run, it->end());
+	}
+	write<long long>(out,runs.size());
+	for(RunContainer::const_iterator it = runs.begin() ; it != runs.end() ; ++it) {
+		write<long long>(out,it->length);
+		write<int>(out,it->value);
+	}
+}
+
+void VoxelPlotter::dump(const std::string& filename) const {
+	Log::msg() << "Dumping file " << Log::BOLDWHITE << filename << Log::endl;
+
+	ofstream out(filename.c_str(), ios::out | ios::binary);
+	if(!out)
+		throw Helios::GeneralError("Cannot open file " + filename);
+
+	/* Header */
+	out.write("HVOX",4);
+	write<int>(out,2);
+	write<int>(out,nx);
+	write<int>(out,ny);
+	write<int>(out,nz);
+	for(int i = 0 ; i < 3 ; ++i) write<double>(out,lower[i]);
+	for(int i = 0 ; i < 3 ; ++i) write<double>(out,upper[i]);
+
+	/* Cell table */
+	const vector<Cell*>& cells = geometry->getCells();
+	write<int>(out,cells.size());
+	for(vector<Cell*>::const_iterator it = cells.begin() ; it != cells.end() ; ++it)
+		writeString(out,geometry->getPath(*it));
+
+	/* Material table (the materials that are not used on the geometry have an empty name) */
+	vector<const Material*> materials;
+	for(vector<Cell*>::const_iterator it = cells.begin() ; it != cells.end() ; ++it) {
+		const Material* material = (*it)->getMaterial();
+		if(!material) continue;
+		if(material->getInternalId() >= materials.size()) materials.resize(material->getInternalId() + 1, 0);
+		materials[material->getInternalId()] = material;
+	}
+	write<int>(out,materials.size());
+	for(vector<const Material*>::const_iterator it = materials.begin() ; it != materials.end() ; ++it)
+		writeString(out,(*it) ? (*it)->getUserId() : "");
+
+	/* Maps */
+	dumpRuns(out,cell_rows);
+	dumpRuns(out,material_rows);
+}
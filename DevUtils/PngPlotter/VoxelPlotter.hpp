@@ -0,0 +1,111 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef VOXELPLOTTER_HPP_
+#define VOXELPLOTTER_HPP_
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#include "../../Common/Common.hpp"
+#include "../../Geometry/Geometry.hpp"
+
+/*
+ * Voxel map of the cells and materials of a geometry. The voxels are filled walking rays along the x axis
+ * (each row of voxels is found in parallel) and saved on a binary file with run-length encoding. The
+ * file is written with the native byte order :
+ *
+ *  - Header : "HVOX", version (int32), number of voxels on each axis (3 x int32), lower and upper
+ *    corners of the box (6 x double).
+ *  - Cell table : number of cells (int32), and the path of each cell (int32 length and the characters),
+ *    sorted by the internal ID of the cells.
+ *  - Material table : same for the user ID of the materials.
+ *  - Cell map and material map : number of runs (int64), and each run as the number of voxels (int64) and
+ *    the index on the table (int32). Voxels outside the geometry (or without material) have an index -1.
+ *
+ * The voxels are sorted with the x index running fastest, then y and z.
+ */
+class VoxelPlotter {
+
+	/* Voxels with the same value (runs are joined over the whole box, so the length could overflow an int) */
+	struct Run {
+		long long length;
+		int value;
+		Run(long long length, int value) : length(length), value(value) {/* */}
+	};
+	typedef std::vector<Run> RunContainer;
+
+	/* Find the cells of each row of voxels */
+	class RowPlotter {
+
+		VoxelPlotter& plotter;
+		const Helios::Geometry* geometry;
+
+	public:
+		RowPlotter(VoxelPlotter& plotter, const Helios::Geometry* geometry) : plotter(plotter), geometry(geometry) {/* */}
+		void operator() (const tbb::blocked_range<size_t>& range) const;
+		~RowPlotter() {/* */}
+	};
+
+	/* Add a voxel to the runs of a row */
+	static void push(RunContainer& runs, int value) {
+		if(runs.size() && runs.back().value == value) runs.back().length++;
+		else runs.push_back(Run(1,value));
+	}
+
+	/* Write the runs of all the rows (joining the runs with the same value) */
+	static void dumpRuns(std::ostream& out, const std::vector<RunContainer>& rows);
+
+	/* Box */
+	Helios::Coordinate lower;
+	Helios::Coordinate upper;
+	/* Number of voxels on each axis */
+	int nx, ny, nz;
+	/* Geometry plotted */
+	const Helios::Geometry* geometry;
+	/* Runs of cells and materials on each row (the row index is j + ny * k) */
+	std::vector<RunContainer> cell_rows;
+	std::vector<RunContainer> material_rows;
+
+public:
+
+	VoxelPlotter(const Helios::Coordinate& lower, const Helios::Coordinate& upper, int nx, int ny, int nz);
+
+	/* Find the cell and material of each voxel */
+	void plot(const Helios::Geometry* geometry);
+
+	/* Dump binary file */
+	void dump(const std::string& filename) const;
+
+	virtual ~VoxelPlotter() {/* */}
+
+};
+
+#endif /* VOXELPLOTTER_HPP_ */
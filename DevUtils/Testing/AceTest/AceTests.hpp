@@ -38,6 +38,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../../../Material/AceTable/AceReader/Ace.hpp"
 #include "../../../Material/AceTable/AceReader/AceUtils.hpp"
 #include "../../../Material/AceTable/AceReader/Conf.hpp"
+#include "../../../Environment/Settings/SettingsObject.hpp"
 #include "../../Utils.hpp"
 #include "../TestCommon.hpp"
 
@@ -393,6 +394,10 @@ protected:
 			double rel = fabs((mfp - expected_mfp) / mfp);
 
 			EXPECT_NEAR(0.0,rel,eps);
+
+			/* The cached value should be the same */
+			XsCache cache;
+			EXPECT_DOUBLE_EQ(expected_mfp,material->getXs(energy,cache).mfp);
 		}
 	}
 
@@ -652,4 +657,124 @@ TEST_F(AceSamplerTest, IsotopeSampler) {
 		checkIsotopeSampler(i * partition,(i + 1) * partition);
 }
 
+class AceOnTheFlyTest : public SimpleAceTest {
+protected:
+	AceOnTheFlyTest() {/* */}
+	virtual ~AceOnTheFlyTest() {/* */}
+
+	void SetUp() {/* */}
+	void TearDown() {/* */}
+
+	/* Create an environment with a material that contains the isotopes */
+	Helios::McEnvironment* createEnvironment(size_t begin, size_t end, const std::string& grid_type, size_t max_tabulated) {
+		using namespace Helios;
+		using namespace std;
+
+		Helios::McEnvironment* environment = new Helios::McEnvironment();
+
+		/* Settings of the material */
+		vector<McObject*> ace_objects;
+		ace_objects.push_back(new SettingsObject("energy_grid", grid_type));
+		ace_objects.push_back(new SettingsObject("max_tabulated_isotopes", toString(max_tabulated)));
+
+		/* Same fraction to all isotopes */
+		map<string,double> isotopes_fraction;
+		double fraction = 1.0 / (end - begin);
+		for(size_t i = begin ; i < end; ++i) {
+			isotopes_fraction[isotopes[i]] = fraction;
+			ace_objects.push_back(new AceObject(isotopes[i]));
+		}
+		ace_objects.push_back(new AceMaterialObject("test", 1.0, "atom/b-cm", "atom", isotopes_fraction));
+
+		/* Setup environment */
+		environment->pushObjects(ace_objects.begin(), ace_objects.end());
+		environment->setup();
+
+		return environment;
+	}
+
+	/* Check the material evaluated on the fly against the tabulated one */
+	void checkOnTheFly(size_t begin, size_t end, const std::string& grid_type) {
+		using namespace Helios;
+		using namespace Ace;
+		using namespace std;
+
+		Log::bok() << " - Checking material evaluated on the fly (" << grid_type << " grid)" << Log::endl;
+
+		/* Same material, tabulated and evaluated on the fly */
+		McEnvironment* tab_environment = createEnvironment(begin, end, grid_type, end - begin);
+		McEnvironment* otf_environment = createEnvironment(begin, end, grid_type, 0);
+		AceMaterial* tab_material = tab_environment->getObject<Materials,AceMaterial>("test")[0];
+		AceMaterial* otf_material = otf_environment->getObject<Materials,AceMaterial>("test")[0];
+
+		/* Relative tolerance on the cross sections */
+		double eps = 1e-12;
+
+		/* Get energy limits for this problem */
+		const MasterGrid* master_grid = tab_environment->getModule<AceModule>()->getMasterGrid();
+		double min_energy = (*master_grid)[0];
+		double max_energy = (*master_grid)[master_grid->size() - 1];
+
+		/* Number of random energies */
+		size_t nrandom = 200;
+
+		for(size_t i = 0 ; i < nrandom ; ++i) {
+			double energy_value = randomNumber(min_energy,max_energy);
+			Energy tab_energy(0,energy_value);
+			Energy otf_energy(0,energy_value);
+
+			double tab_mfp = tab_material->getMeanFreePath(tab_energy);
+			EXPECT_NEAR(tab_mfp, otf_material->getMeanFreePath(otf_energy), eps * tab_mfp);
+			double tab_nufission = tab_material->getNuFission(tab_energy);
+			EXPECT_NEAR(tab_nufission, otf_material->getNuFission(otf_energy), eps * tab_nufission);
+			double tab_nubar = tab_material->getNuBar(tab_energy);
+			EXPECT_NEAR(tab_nubar, otf_material->getNuBar(otf_energy), eps * tab_nubar);
+		}
+
+		/* Number of energies to sample isotopes */
+		size_t nenergies = 5;
+		/* Number of samples */
+		size_t samples = 1000000;
+		/* Tolerance on the frequency of each isotope */
+		double tolerance = 1e-4;
+
+		for(size_t i = 0 ; i < nenergies ; ++i) {
+			double energy_value = randomNumber(min_energy,max_energy);
+			Energy tab_energy(0,energy_value);
+			Energy otf_energy(0,energy_value);
+
+			/* Same random numbers on both materials (samples only differ close to the limits of each isotope) */
+			Random tab_random(i + 1);
+			Random otf_random(i + 1);
+			map<IsotopeId,double> tab_samples;
+			map<IsotopeId,double> otf_samples;
+			for(size_t j = 0 ; j < samples ; ++j) {
+				tab_samples[tab_material->getIsotope(tab_energy,tab_random)->getUserId()]++;
+				otf_samples[otf_material->getIsotope(otf_energy,otf_random)->getUserId()]++;
+			}
+
+			/* Compare the frequency of each isotope */
+			EXPECT_EQ(tab_samples.size(), otf_samples.size());
+			for(map<IsotopeId,double>::const_iterator it = tab_samples.begin() ; it != tab_samples.end() ; ++it)
+				EXPECT_NEAR((*it).second / (double)samples, otf_samples[(*it).first] / (double)samples, tolerance);
+		}
+
+		delete tab_environment;
+		delete otf_environment;
+	}
+
+};
+
+TEST_F(AceOnTheFlyTest, UnionizedGrid) {
+	size_t begin = 0;
+	size_t end = (1.0/10.0) * (double) isotopes.size();
+	checkOnTheFly(begin,end,"unionized");
+}
+
+TEST_F(AceOnTheFlyTest, HashedGrid) {
+	size_t begin = 0;
+	size_t end = (1.0/10.0) * (double) isotopes.size();
+	checkOnTheFly(begin,end,"hashed");
+}
+
 #endif /* ACETESTS_HPP_ */
@@ -32,6 +32,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../../../Common/Common.hpp"
 #include "../../../Parser/ParserTypes.hpp"
+#include "../../../Geometry/VolumeCalculator.hpp"
+#include "../../../Geometry/GeometryState.hpp"
 #include "../../Utils.hpp"
 #include "../TestCommon.hpp"
 
@@ -249,6 +251,214 @@ protected:
 	~LatticeYZConcentricTest() {/* */}
 };
 
+/* Non-convex cell defined with union and complement operators */
+class CsgXYTest : public ConcentricTest {
+protected:
+	CsgXYTest() : ConcentricTest("csg-xy.xml",Helios::Coordinate(-1,-1,0),50000) {/* */};
+	~CsgXYTest() {/* */}
+	/* Transport a particle on a fixed direction */
+	void track(const Helios::Coordinate& position, const Helios::Direction& direction,
+			   const std::vector<Helios::CellId>& expected_cells, const std::vector<Helios::SurfaceId>& expected_surfaces) const {
+		std::vector<Helios::CellId> cells;
+		std::vector<Helios::SurfaceId> surfaces;
+		transport(*geometry,position,direction,cells,surfaces);
+		ASSERT_EQ(expected_cells.size(),cells.size());
+		ASSERT_EQ(expected_surfaces.size(),surfaces.size());
+		for (size_t i = 0; i < expected_cells.size(); ++i)
+			EXPECT_EQ(expected_cells[i],cells[i]);
+		for (size_t i = 0; i < expected_surfaces.size(); ++i)
+			EXPECT_EQ(expected_surfaces[i],surfaces[i]);
+	}
+};
+
+/* Rotated universe and general surfaces (spheres, planes and quadrics) */
+class RotatedUniverseTest : public ConcentricTest {
+protected:
+	RotatedUniverseTest() : ConcentricTest("rot-univ.xml",Helios::Coordinate(0,0,0),50000) {/* */};
+	~RotatedUniverseTest() {/* */}
+};
+
+/* Rotated universe where the planes normal to the axes stay normal to some axis */
+class RotatedPlanesTest : public ConcentricTest {
+protected:
+	RotatedPlanesTest() : ConcentricTest("rot-planes.xml",Helios::Coordinate(0,0,0),50000) {/* */};
+	~RotatedPlanesTest() {/* */}
+	/* Check the type of the rotated surface and a point on it */
+	void plane(const Helios::SurfaceId& id, const std::string& expected, const Helios::Coordinate& point) const {
+		std::vector<Helios::Surface*> surfaces = geometry->getObject<Helios::Surface>(id);
+		ASSERT_EQ(1,surfaces.size());
+		EXPECT_EQ(expected,surfaces[0]->getName());
+		EXPECT_NEAR(0.0,surfaces[0]->function(point),1e-12);
+	}
+};
+
+/* Lattice rotated 180 degrees, the edges of the lattice are merged with the surfaces of the filled cell */
+class RotatedLatticeTest : public ConcentricTest {
+protected:
+	RotatedLatticeTest() : ConcentricTest("rot-latt.xml",Helios::Coordinate(0,0,0),50000) {/* */};
+	~RotatedLatticeTest() {/* */}
+};
+
+/* Features with a locator of their elements */
+class LocatorTest : public ConcentricTest {
+protected:
+	LocatorTest(const std::string& filename, const Helios::Coordinate& start_position) :
+		ConcentricTest(filename,start_position,50000) {/* */};
+	~LocatorTest() {/* */}
+	/* Compare the element found by the locator with a search over all the elements */
+	void locate(const Helios::Coordinate& lower, const Helios::Coordinate& upper) const {
+		const std::vector<Helios::Universe*>& universes = geometry->getUniverses();
+		size_t nlattices = 0;
+		for(size_t u = 0 ; u < universes.size() ; u++) {
+			const Helios::LatticeLocator* locator = universes[u]->getLocator();
+			if(!locator) continue;
+			nlattices++;
+			const std::vector<Helios::Cell*>& elements = universes[u]->getCells();
+			for(size_t h = 0 ; h < histories ; h++) {
+				Helios::Coordinate position(randomNumber(lower[0],upper[0]),randomNumber(lower[1],upper[1]),randomNumber(lower[2],upper[2]));
+				long expected = -1;
+				for(size_t i = 0 ; i < elements.size() ; i++)
+					if(elements[i]->isInside(position)) {expected = i; break;}
+				ASSERT_EQ(expected,locator->locate(position));
+			}
+		}
+		EXPECT_EQ(1,nlattices);
+	}
+};
+
+/* Hexagonal lattices, the elements are found with the lattice locator */
+class HexLatticeTest : public LocatorTest {
+protected:
+	HexLatticeTest(const std::string& filename) : LocatorTest(filename,Helios::Coordinate(0,0,0)) {/* */};
+	~HexLatticeTest() {/* */}
+};
+class HexPointyLatticeTest : public HexLatticeTest {
+protected:
+	HexPointyLatticeTest() : HexLatticeTest("hex-latt.xml") {/* */};
+	~HexPointyLatticeTest() {/* */}
+};
+class HexFlatLatticeTest : public HexLatticeTest {
+protected:
+	HexFlatLatticeTest() : HexLatticeTest("hex-latt-3d.xml") {/* */};
+	~HexFlatLatticeTest() {/* */}
+};
+
+/* Cells defined with macrobodies */
+class MacrobodyTest : public ConcentricTest {
+protected:
+	MacrobodyTest() : ConcentricTest("macro.xml",Helios::Coordinate(0,0,0),50000) {/* */};
+	~MacrobodyTest() {/* */}
+	/* Check the normal of a macrobody on some point of a facet */
+	void facet(const Helios::SurfaceId& id, const Helios::Coordinate& point, const Helios::Direction& expected) const {
+		std::vector<Helios::Surface*> surfaces = geometry->getObject<Helios::Surface>(id);
+		ASSERT_EQ(1,surfaces.size());
+		EXPECT_NEAR(0.0,surfaces[0]->function(point),1e-12);
+		Helios::Direction vnormal;
+		surfaces[0]->normal(point,vnormal);
+		for(size_t i = 0 ; i < 3 ; ++i)
+			EXPECT_NEAR(expected[i],vnormal[i],1e-12);
+	}
+};
+
+/* Periodic boundaries on a quarter of a pin */
+class PeriodicTest : public GeometryTest {
+protected:
+	PeriodicTest() : GeometryTest("periodic.xml") {/* */};
+	~PeriodicTest() {/* */}
+	/* Cross a periodic surface and check where the particle ends */
+	void cross(const Helios::SurfaceId& surface_id, const Helios::CellId& cell_id, const Helios::Coordinate& position,
+			   const Helios::Direction& direction, const Helios::CellId& expected_cell, const Helios::Coordinate& expected_position,
+			   const Helios::Direction& expected_direction) const {
+		Helios::Surface* surface = geometry->getObject<Helios::Surface>(surface_id)[0];
+		const Helios::Cell* cell = geometry->getObject<Helios::Cell>(cell_id)[0];
+		Helios::Particle particle(position,direction,Helios::Energy(0,1.0),1.0);
+		/* Sense of the cell we are leaving */
+		bool sense = surface->function(position - 1e-6 * direction) >= 0;
+		EXPECT_TRUE(surface->cross(particle,sense,cell));
+		ASSERT_TRUE(cell);
+		EXPECT_EQ(expected_cell,cell->getUserId());
+		for(size_t i = 0 ; i < 3 ; ++i) {
+			EXPECT_NEAR(expected_position[i],particle.pos()[i],1e-12);
+			EXPECT_NEAR(expected_direction[i],particle.dir()[i],1e-12);
+		}
+	}
+};
+
+/* Periodic boundaries on a box filled with a lattice */
+class PeriodicLatticeTest : public GeometryTest {
+protected:
+	PeriodicLatticeTest() : GeometryTest("periodic-latt.xml") {/* */};
+	~PeriodicLatticeTest() {/* */}
+	void SetUp() {
+		parser = new Helios::XmlParser;
+		environment = new Helios::McEnvironment(parser);
+		std::vector<std::string> input;
+		input.push_back(InputPath::access().getPath() + "/GeometryTest/" + filename);
+		input.push_back(InputPath::access().getPath() + "/GeometryTest/material.xml");
+		environment->parseFiles(input);
+		environment->setup();
+		geometry = environment->getModule<Helios::Geometry>();
+	}
+};
+
+/* Cell replicated on a lattice, with materials and temperatures defined for each instance */
+class DistributedCellTest : public GeometryTest {
+protected:
+	DistributedCellTest() : GeometryTest("distributed.xml") {/* */};
+	~DistributedCellTest() {/* */}
+	void SetUp() {
+		parser = new Helios::XmlParser;
+		environment = new Helios::McEnvironment(parser);
+		/* Parse the materials too, to check the material of each instance */
+		std::vector<std::string> input;
+		input.push_back(InputPath::access().getPath() + "/GeometryTest/" + filename);
+		input.push_back(InputPath::access().getPath() + "/GeometryTest/material.xml");
+		environment->parseFiles(input);
+		environment->setup();
+		geometry = environment->getModule<Helios::Geometry>();
+	}
+};
+
+/* Box filled with a mesh of tetrahedrons */
+class MeshTest : public LocatorTest {
+protected:
+	MeshTest() : LocatorTest("mesh.xml",Helios::Coordinate(1.3,0.2,-0.1)) {/* */};
+	MeshTest(const std::string& filename, const Helios::Coordinate& start_position) : LocatorTest(filename,start_position) {/* */};
+	~MeshTest() {/* */}
+	void SetUp() {
+		parser = new Helios::XmlParser;
+		environment = new Helios::McEnvironment(parser);
+		/* Parse the materials too, to check the material of each element */
+		std::vector<std::string> input;
+		input.push_back(InputPath::access().getPath() + "/GeometryTest/" + filename);
+		input.push_back(InputPath::access().getPath() + "/GeometryTest/material.xml");
+		environment->parseFiles(input);
+		environment->setup();
+		geometry = environment->getModule<Helios::Geometry>();
+	}
+};
+
+/* Box macrobody filled with a mesh with some noise on its nodes */
+class MacrobodyMeshTest : public MeshTest {
+protected:
+	MacrobodyMeshTest() : MeshTest("mesh-box.xml",Helios::Coordinate(1.3,0.2,-0.1)) {/* */};
+	~MacrobodyMeshTest() {/* */}
+};
+
+/* Rotated mesh filling a box bounded by general planes */
+class TiltedMeshTest : public MeshTest {
+protected:
+	TiltedMeshTest() : MeshTest("mesh-tilted.xml",Helios::Coordinate(0.3,0.2,-0.1)) {/* */};
+	~TiltedMeshTest() {/* */}
+};
+
+/* L-shaped cell (non-convex) filled with a mesh, the particle leaves the mesh through the surfaces of the cell */
+class NonConvexMeshTest : public MeshTest {
+protected:
+	NonConvexMeshTest() : MeshTest("mesh-lshape.xml",Helios::Coordinate(-0.5,-0.3,0.1)) {/* */};
+	~NonConvexMeshTest() {/* */}
+};
+
 /* Simple x-y lattice with *a lot* of pins. To checkout the random transport on heavy lattices */
 class HugeLatticeXYConcentricTest : public ConcentricTest {
 protected:
@@ -290,5 +500,224 @@ TEST_F(CylinderXZConcentricTranslaUniverseTest, RandomTransport) {random();}
 
 TEST_F(LatticeXYConcentricTest, RandomTransport) {random();}
 TEST_F(HugeLatticeXYConcentricTest, RandomTransport) {random();}
+TEST_F(CsgXYTest, RandomTransport) {random();}
+TEST_F(RotatedUniverseTest, RandomTransport) {random();}
+TEST_F(RotatedPlanesTest, RandomTransport) {random();}
+TEST_F(RotatedLatticeTest, RandomTransport) {random();}
+TEST_F(RotatedLatticeTest, MergedEdges) {
+	/* 5 surfaces on the global level, the 2 planes inside the lattice and the 4 pins */
+	EXPECT_EQ(11,geometry->getSurfaces().size());
+}
+TEST_F(RotatedPlanesTest, AxisPlanes) {
+	plane("2","py",Helios::Coordinate(0.7,0.4,-0.3));
+	plane("4","pz",Helios::Coordinate(-0.2,0.6,0.1));
+	/* The normal of the plane y = 0.2 now points to -x, it's a plane x = 0.3 with the opposite sense */
+	plane("3","px",Helios::Coordinate(0.3,-0.5,0.8));
+	const Helios::Cell* cell = geometry->getObject<Helios::Cell>("1")[0];
+	EXPECT_TRUE(cell->isInside(Helios::Coordinate(0.6,0.2,0.0)));
+	EXPECT_FALSE(cell->isInside(Helios::Coordinate(0.2,0.2,0.0)));
+}
+TEST_F(HexPointyLatticeTest, RandomTransport) {random();}
+TEST_F(HexFlatLatticeTest, RandomTransport) {random();}
+TEST_F(MacrobodyTest, RandomTransport) {random();}
+TEST_F(MacrobodyTest, FacetNormal) {
+	facet("1",Helios::Coordinate(3.0,0.5,-1.0),Helios::Direction(1,0,0));
+	facet("1",Helios::Coordinate(0.1,0.2,-3.0),Helios::Direction(0,0,-1));
+	facet("2",Helios::Coordinate(0.0,1.0,0.5),Helios::Direction(0,1,0));
+	facet("2",Helios::Coordinate(0.2,0.0,2.0),Helios::Direction(0,0,1));
+	facet("3",Helios::Coordinate(1.5,0.0,0.0),Helios::Direction(1,0,0));
+	facet("3",Helios::Coordinate(-0.75,-1.5*std::sqrt(3.0)/2.0,1.0),Helios::Direction(-0.5,-std::sqrt(3.0)/2.0,0));
+	facet("4",Helios::Coordinate(1.0,1.0,2.9),Helios::Direction(0,0,1));
+	/* Rotated cylinder, now along the y axis */
+	facet("7",Helios::Coordinate(0.0,-1.0,-2.75),Helios::Direction(0,-1,0));
+	facet("7",Helios::Coordinate(0.1,0.5,-2.75),Helios::Direction(1,0,0));
+}
+TEST_F(PeriodicTest, RotationalBoundary) {
+	cross("1","10",Helios::Coordinate(0.0,0.3,0.2),Helios::Direction(-0.6,0.8,0.0),
+		  "10",Helios::Coordinate(0.3,0.0,0.2),Helios::Direction(0.8,0.6,0.0));
+	cross("2","11",Helios::Coordinate(0.7,0.0,0.5),Helios::Direction(0.6,-0.8,0.0),
+		  "11",Helios::Coordinate(0.0,0.7,0.5),Helios::Direction(0.8,0.6,0.0));
+}
+TEST_F(PeriodicTest, TranslationalBoundary) {
+	cross("7","10",Helios::Coordinate(0.2,0.2,1.0),Helios::Direction(0.0,0.6,0.8),
+		  "10",Helios::Coordinate(0.2,0.2,-1.0),Helios::Direction(0.0,0.6,0.8));
+	cross("6","11",Helios::Coordinate(0.8,0.1,-1.0),Helios::Direction(0.0,0.0,-1.0),
+		  "11",Helios::Coordinate(0.8,0.1,1.0),Helios::Direction(0.0,0.0,-1.0));
+}
+TEST_F(PeriodicLatticeTest, TrackBetweenCrossings) {
+	/* The particle goes around the box without touching the pins */
+	Helios::Direction direction(0.6,0.0,0.8);
+	Helios::Particle particle(Helios::Coordinate(-0.9,0.95,0.0),direction,Helios::Energy(0,1.0),1.0);
+	const Helios::Cell* cell = geometry->findCell(particle.pos());
+	ASSERT_TRUE(cell);
+	Helios::GeometryState state(geometry->getFlatGeometry());
+	Helios::Surface* surface(0);
+	bool sense(true);
+	double distance(0.0);
+	/* Distance to the first crossing and between crossings of the periodic boundary */
+	double expected = 1.9 / 0.6;
+	double track = 0.0;
+	for(size_t crossings = 0 ; crossings < 3 ; ) {
+		cell->intersect(particle.pos(),particle.dir(),surface,sense,distance,&state);
+		ASSERT_TRUE(surface);
+		particle.pos() = particle.pos() + distance * particle.dir();
+		track += distance;
+		bool periodic = (surface->getUserId() == "6");
+		ASSERT_TRUE(surface->cross(particle,sense,cell,&state));
+		ASSERT_TRUE(cell);
+		EXPECT_EQ("101",cell->getUserId());
+		if(periodic) {
+			EXPECT_NEAR(expected,track,1e-10);
+			EXPECT_NEAR(-1.0,particle.pos()[0],1e-10);
+			expected = 2.0 / 0.6;
+			track = 0.0;
+			++crossings;
+		}
+	}
+}
+TEST_F(DistributedCellTest, Instances) {
+	static const std::string materials[4] = {"fuel", "water", "water", "fuel"};
+	static const double temperatures[4] = {600.0, 900.0, 1200.0, 1500.0};
+	ASSERT_EQ(4,geometry->getInstances("100"));
+	std::vector<Helios::Cell*> fuel = geometry->getObject<Helios::Cell>("100");
+	std::vector<Helios::Cell*> water = geometry->getObject<Helios::Cell>("101");
+	ASSERT_EQ(4,fuel.size());
+	ASSERT_EQ(4,water.size());
+	for(size_t i = 0 ; i < fuel.size() ; ++i) {
+		EXPECT_EQ(i,fuel[i]->getInstance());
+		EXPECT_EQ(materials[i],fuel[i]->getMaterial()->getUserId());
+		EXPECT_DOUBLE_EQ(temperatures[i],fuel[i]->getTemperature());
+		/* The same value for all the instances */
+		EXPECT_EQ(i,water[i]->getInstance());
+		EXPECT_EQ("water",water[i]->getMaterial()->getUserId());
+		EXPECT_DOUBLE_EQ(550.0,water[i]->getTemperature());
+	}
+	EXPECT_EQ(0,geometry->getObject<Helios::Cell>("1")[0]->getTemperature());
+}
+TEST_F(DistributedCellTest, Paths) {
+	/* Each instance is found again from its full path */
+	std::vector<Helios::Cell*> fuel = geometry->getObject<Helios::Cell>("100");
+	for(size_t i = 0 ; i < fuel.size() ; ++i) {
+		Helios::CellId path = geometry->getPath(fuel[i]);
+		ASSERT_NE(std::string::npos,path.find("<1"));
+		EXPECT_EQ(fuel[i],geometry->getObject<Helios::Cell>(path)[0]);
+	}
+	std::vector<Helios::Surface*> surfaces = geometry->getObject<Helios::Surface>("1");
+	ASSERT_EQ(4,surfaces.size());
+	for(size_t i = 0 ; i < surfaces.size() ; ++i)
+		EXPECT_EQ(surfaces[i],geometry->getObject<Helios::Surface>(geometry->getPath(surfaces[i]))[0]);
+	EXPECT_EQ("1",geometry->getPath(geometry->getObject<Helios::Cell>("1")[0]));
+}
+TEST_F(DistributedCellTest, Volumes) {
+	/* Pins of radius 0.4 on a 2x2 lattice (the box is 1 cm high) */
+	Helios::VolumeCalculator volumes(geometry,Helios::Coordinate(-1.0,-1.0,-0.5),Helios::Coordinate(1.0,1.0,0.5));
+	volumes.calculate(Helios::Random(1),0.005);
+	double pin = M_PI * 0.4 * 0.4;
+	EXPECT_EQ(0,volumes.getOutside());
+	std::vector<Helios::Cell*> fuel = geometry->getObject<Helios::Cell>("100");
+	for(size_t i = 0 ; i < fuel.size() ; ++i) {
+		Helios::VolumeCalculator::Volume volume = volumes.getVolume(fuel[i]);
+		EXPECT_GT(0.005,volume.relative());
+		EXPECT_NEAR(pin,volume.value,4*volume.error);
+	}
+	Helios::VolumeCalculator::Volume fuel_volume = volumes.getCellVolume("100");
+	EXPECT_NEAR(4*pin,fuel_volume.value,4*fuel_volume.error);
+	Helios::VolumeCalculator::Volume water_volume = volumes.getCellVolume("101");
+	EXPECT_NEAR(4 - 4*pin,water_volume.value,4*water_volume.error);
+	/* Two instances of the fuel cell are filled with water */
+	Helios::VolumeCalculator::Volume material_volume = volumes.getMaterialVolume(fuel[0]->getMaterial());
+	EXPECT_NEAR(2*pin,material_volume.value,4*material_volume.error);
+	material_volume = volumes.getMaterialVolume(fuel[1]->getMaterial());
+	EXPECT_NEAR(4 - 2*pin,material_volume.value,4*material_volume.error);
+}
+TEST_F(HexPointyLatticeTest, LocateElement) {locate(Helios::Coordinate(-5,-5,0),Helios::Coordinate(5,5,0));}
+TEST_F(HexFlatLatticeTest, LocateElement) {locate(Helios::Coordinate(-5,-5,-2),Helios::Coordinate(5,5,2));}
+TEST_F(MeshTest, LocateElement) {locate(Helios::Coordinate(0,-1,-1),Helios::Coordinate(2,1,1));}
+TEST_F(MeshTest, RandomTransport) {random();}
+TEST_F(MeshTest, Materials) {
+	/* Each octant of the box is split in 6 elements (the octants on the x < 0 half of the mesh are even) */
+	std::vector<Helios::Cell*> box = geometry->getObject<Helios::Cell>("1");
+	ASSERT_EQ(1,box.size());
+	const std::vector<Helios::Cell*>& elements = box[0]->getFill()->getCells();
+	ASSERT_EQ(48,elements.size());
+	for(size_t i = 0 ; i < elements.size() ; ++i) {
+		std::string material = ((i / 6) % 2 == 0) ? "fuel" : "water";
+		EXPECT_EQ(material,elements[i]->getMaterial()->getUserId());
+	}
+	/* Elements found on each half of the box */
+	for(size_t h = 0 ; h < histories ; h++) {
+		Helios::Coordinate position(randomNumber(0.0,2.0),randomNumber(-1.0,1.0),randomNumber(-1.0,1.0));
+		const Helios::Cell* cell = geometry->findCell(position);
+		ASSERT_TRUE(cell);
+		std::string material = (position[0] < 1.0) ? "fuel" : "water";
+		EXPECT_EQ(material,cell->getMaterial()->getUserId());
+	}
+}
+TEST_F(MacrobodyMeshTest, LocateElement) {locate(Helios::Coordinate(0,-1,-1),Helios::Coordinate(2,1,1));}
+TEST_F(MacrobodyMeshTest, RandomTransport) {random();}
+TEST_F(TiltedMeshTest, LocateElement) {locate(Helios::Coordinate(-1.4,-1.4,-1),Helios::Coordinate(1.4,1.4,1));}
+TEST_F(TiltedMeshTest, RandomTransport) {random();}
+TEST_F(NonConvexMeshTest, LocateElement) {locate(Helios::Coordinate(-1,-1,-1),Helios::Coordinate(1,1,1));}
+TEST_F(NonConvexMeshTest, RandomTransport) {random();}
+TEST_F(NonConvexMeshTest, Materials) {
+	/* The box of water on the corner x > 0, y > 0 is out of the mesh (fuel on y < 0 and water on the other half) */
+	for(size_t h = 0 ; h < histories ; h++) {
+		Helios::Coordinate position(randomNumber(-1.0,1.0),randomNumber(-1.0,1.0),randomNumber(-1.0,1.0));
+		const Helios::Cell* cell = geometry->findCell(position);
+		ASSERT_TRUE(cell);
+		bool corner = (position[0] > 0.0 && position[1] > 0.0);
+		EXPECT_EQ(corner,cell->getUserId() == "2");
+		std::string material = (position[1] < 0.0) ? "fuel" : "water";
+		EXPECT_EQ(material,cell->getMaterial()->getUserId());
+	}
+}
+TEST_F(NonConvexMeshTest, LeaveMesh) {
+	/* The particle leaves the mesh through the plane x = 0 of the L-shaped cell */
+	std::vector<Helios::CellId> cells;
+	std::vector<Helios::SurfaceId> surfaces;
+	transport(*geometry,Helios::Coordinate(-0.7,0.6,0.1),Helios::Direction(1,0,0),cells,surfaces);
+	ASSERT_LT(2,cells.size());
+	ASSERT_EQ(cells.size() - 1,surfaces.size());
+	EXPECT_EQ("2",cells[cells.size() - 2]);
+	EXPECT_EQ("3",cells[cells.size() - 1]);
+	EXPECT_EQ("11",surfaces[surfaces.size() - 2]);
+	EXPECT_EQ("6",surfaces[surfaces.size() - 1]);
+	for(size_t i = 0 ; i < cells.size() - 2 ; ++i)
+		EXPECT_EQ(0,cells[i].find("10["));
+}
+TEST_F(CsgXYTest, ExplicitSense) {
+	/* The square is defined with explicit positive senses, "+3 -2 +6 -5" */
+	const Helios::Cell* cell = geometry->getObject<Helios::Cell>("1")[0];
+	EXPECT_TRUE(cell->isInside(Helios::Coordinate(1,1,0)));
+	EXPECT_FALSE(cell->isInside(Helios::Coordinate(-1,1,0)));
+	EXPECT_FALSE(cell->isInside(Helios::Coordinate(1,-1,0)));
+}
+TEST_F(CsgXYTest, NonConvexTransport) {
+	/* The plane x = 0 is inside the L-shaped cell when y < 0 */
+	double norm = std::sqrt(1.0 + 0.2 * 0.2);
+	std::vector<Helios::CellId> cells;
+	std::vector<Helios::SurfaceId> surfaces;
+	cells.push_back("2"); cells.push_back("3");
+	surfaces.push_back("2");
+	track(Helios::Coordinate(-1,-1,0),Helios::Direction(1.0/norm,0.2/norm,0),cells,surfaces);
+	/* Going into the square */
+	cells.clear(); surfaces.clear();
+	cells.push_back("2"); cells.push_back("1"); cells.push_back("3");
+	surfaces.push_back("3"); surfaces.push_back("2");
+	track(Helios::Coordinate(-1,1,0),Helios::Direction(1,0,0),cells,surfaces);
+	/* Leaving the square through the L-shaped cell */
+	cells.clear(); surfaces.clear();
+	cells.push_back("1"); cells.push_back("2"); cells.push_back("3");
+	surfaces.push_back("6"); surfaces.push_back("4");
+	track(Helios::Coordinate(1,1,0),Helios::Direction(0,-1,0),cells,surfaces);
+}
+
+/* Same tracks after sorting the cells by the hits on the first transport */
+TEST_F(CylinderXYConcentricUniverseTest, FrozenOrderTransport) {
+	straight(genVector<Helios::CellId>("1","10"),genVector<Helios::SurfaceId>("1","9"));
+	geometry->freezeCellOrder();
+	straight(genVector<Helios::CellId>("1","10"),genVector<Helios::SurfaceId>("1","9"));
+}
+TEST_F(LatticeXYConcentricTest, FrozenOrderTransport) {random(); geometry->freezeCellOrder(); random();}
 
 #endif /* GEOMETRYTESTS_HPP_ */
@@ -255,4 +255,64 @@ TEST_F(ChildGridTest, LinearInterpolation) {
 	}
 }
 
+TEST_F(ChildGridTest, HashedLookup) {
+	/* Same child grids, looked up with the hash tables */
+	Helios::MasterGrid hashed_grid(Helios::MasterGrid::HASHED);
+	std::vector<Helios::ChildGrid*> hashed_childs;
+	for(size_t j = 0 ; j < child_grids.size() ; ++j) {
+		std::vector<double> user_grid(child_grids[j]->size());
+		for(size_t i = 0 ; i < user_grid.size() ; ++i)
+			user_grid[i] = (*child_grids[j])[i];
+		hashed_childs.push_back(hashed_grid.pushGrid(user_grid.begin(), user_grid.end()));
+	}
+	hashed_grid.setup();
+
+	for(size_t j = 0 ; j < child_grids.size() ; ++j) {
+		/* Both lookups should give the same index and interpolation factor */
+		for(size_t i = 0 ; i < random_values.size() ; ++i) {
+			double factor = 0.0;
+			double hashed_factor = 0.0;
+			std::pair<size_t,double> pair_value(0,random_values[i]);
+			std::pair<size_t,double> hashed_value(0,random_values[i]);
+			size_t idx = child_grids[j]->index(pair_value,factor);
+			size_t hashed_idx = hashed_childs[j]->index(hashed_value,hashed_factor);
+			EXPECT_EQ(idx,hashed_idx);
+			EXPECT_DOUBLE_EQ(factor,hashed_factor);
+		}
+	}
+}
+
+TEST_F(ChildGridTest, GridSetLookup) {
+	for(size_t type = 0 ; type < 2 ; ++type) {
+		/* Same child grids, on a master grid of each type */
+		Helios::MasterGrid master_grid((Helios::MasterGrid::GridType)type);
+		std::vector<Helios::ChildGrid*> childs;
+		for(size_t j = 0 ; j < child_grids.size() ; ++j) {
+			std::vector<double> user_grid(child_grids[j]->size());
+			for(size_t i = 0 ; i < user_grid.size() ; ++i)
+				user_grid[i] = (*child_grids[j])[i];
+			childs.push_back(master_grid.pushGrid(user_grid.begin(), user_grid.end()));
+		}
+		master_grid.setup();
+
+		Helios::ChildGridSet grid_set;
+		for(size_t j = 0 ; j < childs.size() ; ++j)
+			grid_set.push(childs[j]);
+
+		/* The lookup on the set should be the same as the one on each grid */
+		std::vector<size_t> idx(grid_set.size());
+		std::vector<double> factor(grid_set.size());
+		for(size_t i = 0 ; i < random_values.size() ; ++i) {
+			std::pair<size_t,double> pair_value(0,random_values[i]);
+			size_t key = grid_set.key(pair_value);
+			grid_set.index(key, pair_value.second, 0, grid_set.size(), &idx[0], &factor[0]);
+			for(size_t j = 0 ; j < childs.size() ; ++j) {
+				double child_factor = 0.0;
+				EXPECT_EQ(childs[j]->index(pair_value,child_factor),idx[j]);
+				EXPECT_DOUBLE_EQ(child_factor,factor[j]);
+			}
+		}
+	}
+}
+
 #endif /* GRIDTEST_HPP_ */
@@ -33,6 +33,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../../../Common/Common.hpp"
 #include "../../../Parser/ParserTypes.hpp"
 #include "../../../Common/Sampler.hpp"
+#include "../../../Common/FactorSampler.hpp"
+#include "../../../Common/CompactSampler.hpp"
 #include "../../Utils.hpp"
 #include "../TestCommon.hpp"
 
@@ -286,4 +288,114 @@ TEST_F(HeavyIntOddZeroedSamplerCpyTest, SamplingIntegers) {checkZeroedSamples();
 TEST_F(MaterialsIntOddZeroedSamplerCpyTest, SamplingIntegers) {checkZeroedSamples();}
 TEST_F(OneIntOddZeroedSamplerCpyTest, SamplingIntegers) {checkZeroedSamples();}
 
+/* The compact sampler should sample the same reactions as the factor sampler */
+class CompactSamplerTest : public ::testing::Test {
+protected:
+	CompactSamplerTest() : nreactions(50), nenergies(1000), histories(1000000) {/* */}
+	virtual ~CompactSamplerTest() {/* */}
+
+	void SetUp() {
+		/* Random cross sections, zero at the edges of the grid */
+		reactions = genVector<size_t>(0,nreactions-1);
+		xs = std::vector<std::vector<double> >(nreactions, std::vector<double>(nenergies,0.0));
+		for(size_t r = 0 ; r < nreactions ; ++r)
+			for(size_t e = nenergies / 10 ; e < 9 * nenergies / 10 ; ++e)
+				xs[r][e] = randomNumber();
+	}
+
+	/* Fraction of the samples where both samplers are different */
+	double countMismatches(Helios::FactorSampler<size_t>& factor_sampler, const Helios::CompactSampler<size_t>& compact_sampler) const {
+		size_t mismatch = 0;
+		for(size_t h = 0 ; h < histories ; h++) {
+			size_t e = nenergies / 10 + rand()%(8 * nenergies / 10 - 1);
+			double factor = randomNumber();
+			double total = 0.0;
+			for(size_t r = 0 ; r < nreactions ; ++r)
+				total += factor * (xs[r][e + 1] - xs[r][e]) + xs[r][e];
+			double value = total * randomNumber();
+			if(factor_sampler.sample(e,value,factor) != compact_sampler.sample(e,value,factor))
+				mismatch++;
+		}
+		/* Single precision could only change the samples very close to the boundaries */
+		return (double)mismatch / (double)histories;
+	}
+
+	size_t nreactions;
+	size_t nenergies;
+	size_t histories;
+	std::vector<size_t> reactions;
+	std::vector<std::vector<double> > xs;
+};
+
+TEST_F(CompactSamplerTest, SameAsFactorSampler) {
+	Helios::FactorSampler<size_t> factor_sampler(reactions, xs, false);
+	Helios::CompactSampler<size_t> compact_sampler(reactions, nenergies);
+	std::vector<double> row(nreactions);
+	for(size_t e = 0 ; e < nenergies ; ++e) {
+		for(size_t r = 0 ; r < nreactions ; ++r)
+			row[r] = xs[r][e];
+		compact_sampler.setRow(e, row);
+	}
+	compact_sampler.compact();
+
+	/* Only the non zero rows are kept (nothing is trimmed, so the rows are stored without an index) */
+	size_t nrows = 8 * nenergies / 10;
+	EXPECT_EQ(compact_sampler.size(), nrows * (nreactions - 1) * sizeof(float));
+	EXPECT_LE(countMismatches(factor_sampler,compact_sampler), 1e-5);
+}
+
+TEST_F(CompactSamplerTest, TwoReactions) {
+	/* Materials with a couple of isotopes (e.g. water) */
+	nreactions = 2;
+	SetUp();
+	Helios::FactorSampler<size_t> factor_sampler(reactions, xs, false);
+	Helios::CompactSampler<size_t> compact_sampler(reactions, nenergies);
+	std::vector<double> row(nreactions);
+	for(size_t e = 0 ; e < nenergies ; ++e) {
+		for(size_t r = 0 ; r < nreactions ; ++r)
+			row[r] = xs[r][e];
+		compact_sampler.setRow(e, row);
+	}
+	compact_sampler.compact();
+
+	/* A single precision value on each row, a half of the dense double table */
+	size_t nrows = 8 * nenergies / 10;
+	EXPECT_EQ(compact_sampler.size(), nrows * sizeof(float));
+	EXPECT_LE(2 * compact_sampler.size(), nenergies * (nreactions - 1) * sizeof(double));
+	EXPECT_LE(countMismatches(factor_sampler,compact_sampler), 1e-5);
+}
+
+TEST_F(CompactSamplerTest, ThresholdReactions) {
+	/* Each reaction is zero below some threshold (and the first ones are zero at high energies) */
+	size_t stored = 0;
+	for(size_t r = 0 ; r < nreactions ; ++r) {
+		size_t threshold = nenergies / 10 + r * (nenergies / (2 * nreactions));
+		for(size_t e = nenergies / 10 ; e < threshold ; ++e)
+			xs[r][e] = 0.0;
+		if(r < nreactions / 2)
+			for(size_t e = 8 * nenergies / 10 ; e < 9 * nenergies / 10 ; ++e)
+				xs[r][e] = 0.0;
+	}
+	Helios::FactorSampler<size_t> factor_sampler(reactions, xs, false);
+	Helios::CompactSampler<size_t> compact_sampler(reactions, nenergies);
+	std::vector<double> row(nreactions);
+	for(size_t e = 0 ; e < nenergies ; ++e) {
+		for(size_t r = 0 ; r < nreactions ; ++r)
+			row[r] = xs[r][e];
+		compact_sampler.setRow(e, row);
+		/* Values between the first and the last reaction (but the last one) with a cross section */
+		size_t first = 0, last = nreactions - 1;
+		while(first < last && row[first] == 0.0) ++first;
+		while(last > first && row[last - 1] == 0.0) --last;
+		stored += last - first;
+	}
+	compact_sampler.compact();
+
+	/* Only the reactions with a cross section on each row are kept (with the offset and the first reaction of each one) */
+	size_t nrows = 8 * nenergies / 10;
+	EXPECT_EQ(compact_sampler.size(), stored * sizeof(float) + (2 * nrows + 1) * sizeof(uint32_t));
+	EXPECT_LT(stored, nrows * (nreactions - 1));
+	EXPECT_LE(countMismatches(factor_sampler,compact_sampler), 1e-5);
+}
+
 #endif /* REACTIONTESTS_HPP_ */
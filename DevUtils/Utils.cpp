@@ -26,6 +26,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "Utils.hpp"
+#include "../Geometry/GeometryState.hpp"
 
 using namespace std;
 using namespace Helios;
@@ -39,13 +40,14 @@ void transport(const Helios::Geometry& geometry, const Helios::Coordinate& start
 	Surface* surface(0);
 	bool sense(true);
 	double distance(0.0);
+	GeometryState state(geometry.getFlatGeometry());
 	while(cell) {
 		/* Get next surface and distance */
-		cell->intersect(pos,start_dir,surface,sense,distance);
+		cell->intersect(pos,start_dir,surface,sense,distance,&state);
 		/* Transport the particle */
 		pos = pos + distance * start_dir;
 		/* Now get next cell */
-		surface->cross(pos,sense,cell);
+		surface->cross(pos,sense,cell,&state);
 		if(!cell) {
 				cout << pos << endl;
 				cout << *surface << endl;
@@ -67,16 +69,17 @@ double randomTransport(const Helios::Geometry& geometry, const Helios::Coordinat
 	Surface* surface(0);
 	bool sense(true);
 	double distance(0.0);
+	GeometryState state(geometry.getFlatGeometry());
 	while(cell) {
 		Direction start_dir(randomDirection());
 		/* Get next surface and distance */
-		cell->intersect(pos,start_dir,surface,sense,distance);
+		cell->intersect(pos,start_dir,surface,sense,distance,&state);
 		if(surface->getFlags() & Surface::VACUUM) break;
 		/* Transport the particle */
 		pos = pos + distance * start_dir;
 		max_eval = std::max(max_eval,surface->function(pos));
 		/* Now get next cell */
-		surface->cross(pos,sense,cell);
+		surface->cross(pos,sense,cell,&state);
 		if(!cell) {
 				cout << pos << endl;
 				cout << *surface << endl;
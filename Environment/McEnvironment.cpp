@@ -61,6 +61,8 @@ McEnvironment::McEnvironment(int argc, char **argv, Parser* parser) : parser(par
 	pushObject(new SettingsObject("seed", "10"));
 	pushObject(new SettingsObject("energy_freegas_threshold", "400.0"));
 	pushObject(new SettingsObject("awr_freegas_threshold", "1.0"));
+	pushObject(new SettingsObject("energy_grid", "unionized"));
+	pushObject(new SettingsObject("max_tabulated_isotopes", "100"));
 }
 
 McEnvironment::McEnvironment(Parser* parser) : parser(parser) {
@@ -78,6 +80,8 @@ McEnvironment::McEnvironment(Parser* parser) : parser(parser) {
 	pushObject(new SettingsObject("seed", "10"));
 	pushObject(new SettingsObject("energy_freegas_threshold", "400.0"));
 	pushObject(new SettingsObject("awr_freegas_threshold", "1.0"));
+	pushObject(new SettingsObject("energy_grid", "unionized"));
+	pushObject(new SettingsObject("max_tabulated_isotopes", "100"));
 }
 
 void McEnvironment::parseFile(const std::string& filename) {
@@ -42,10 +42,13 @@ static std::map<UserId,std::set<std::string> > setValidSettings() {
 	setSingleValue(settings, "max_source_samples");
 	setSingleValue(settings, "max_rng_per_history");
 	setSingleValue(settings, "xs_data");
+	setSingleValue(settings, "xs_cache");
 	setSingleValue(settings, "multithread");
 	setSingleValue(settings, "seed");
 	setSingleValue(settings, "energy_freegas_threshold");
 	setSingleValue(settings, "awr_freegas_threshold");
+	setSingleValue(settings, "energy_grid");
+	setSingleValue(settings, "max_tabulated_isotopes");
 
 	/* KEFF simulation data */
 	settings["criticality"].insert("batches");
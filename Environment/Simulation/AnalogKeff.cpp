@@ -38,7 +38,8 @@ AnalogKeff::AnalogKeff(const McEnvironment* environment) :
 	SimulationBase(environment, environment->getSetting<size_t>("criticality","particles"),
 			       environment->getSetting<size_t>("criticality","batches"),
 			       environment->getSetting<size_t>("criticality","inactive")), keff(1.0),
-			       particles_number(nparticles), fission_bank(local_particles) {
+			       particles_number(nparticles), fission_bank(local_particles),
+			       flat_geometry(environment->getModule<Geometry>()->getFlatGeometry()) {
 
 	/* Population counter */
 	inactive_tallies.pushTally(new CounterTally("population"));
@@ -71,7 +72,7 @@ void AnalogKeff::source(size_t nbank) {
 	fission_bank[nbank] = source_particle;
 }
 
-bool AnalogKeff::voidTransport(const Material*& material, Particle& particle, const Cell*& cell) {
+bool AnalogKeff::voidTransport(const Material*& material, Particle& particle, const Cell*& cell, GeometryState& state) {
 	/* Check the material pointer */
 	while(not material) {
 		/* Initialize some auxiliary variables */
@@ -80,13 +81,13 @@ bool AnalogKeff::voidTransport(const Material*& material, Particle& particle, co
 		double distance(0.0); /* Distance to closest surface */
 
 		/* Get next surface's distance */
-		cell->intersect(particle.pos(), particle.dir(), surface, sense, distance);
+		cell->intersect(particle.pos(), particle.dir(), surface, sense, distance, &state);
 
 		/* Transport the particle to the surface */
 		particle.pos() = particle.pos() + distance * particle.dir();
 
 		/*  Cross the surface (checking boundary conditions) */
-		bool outside = not surface->cross(particle,sense,cell);
+		bool outside = not surface->cross(particle,sense,cell,&state);
 		assert(cell != 0);
 		/* Particle is outside the system */
 		if(outside) return false;
@@ -117,6 +118,10 @@ void AnalogKeff::history(size_t nbank, const std::vector<ChildTally*>& tally_con
 	CellParticle& pc = fission_bank[nbank];
 	const Cell* cell = pc.first;
 	Particle& particle = pc.second;
+	/* Geometric state of the particle */
+	GeometryState state(flat_geometry);
+	/* Cross sections seen by the particle (updated only when the material or the energy change) */
+	XsCache xs;
 
 	while(true) {
 
@@ -124,17 +129,17 @@ void AnalogKeff::history(size_t nbank, const std::vector<ChildTally*>& tally_con
 		const Material* material = cell->getMaterial();
 
 		/* Transport the particle until a non-void cell is found (checking boundary conditions) */
-		outside = not voidTransport(material, particle, cell);
+		outside = not voidTransport(material, particle, cell, state);
 		if(outside) {
 			estimate<LEAK>(tally_container, particle.wgt());
 			break;
 		}
 
 		/* 3. ---- Get next surface's distance */
-		cell->intersect(particle.pos(), particle.dir(), surface, sense, distance);
+		cell->intersect(particle.pos(), particle.dir(), surface, sense, distance, &state);
 
 		/* 4. ---- Get collision distance */
-		double mfp = material->getMeanFreePath(particle.erg());
+		double mfp = material->getXs(particle.erg(), xs).mfp;
 		double collision_distance = -log(r.uniform())*mfp;
 
 		/* 5. ---- Check sampled distance against closest surface distance */
@@ -143,27 +148,27 @@ void AnalogKeff::history(size_t nbank, const std::vector<ChildTally*>& tally_con
 			particle.pos() = particle.pos() + distance * particle.dir();
 			/* Accumulate track length estimation of the KEFF */
 			if(material->isFissile())
-				estimate<KEFF_TRK>(tally_container, particle.wgt() * distance * material->getNuFission(particle.erg()));
+				estimate<KEFF_TRK>(tally_container, particle.wgt() * distance * material->getXs(particle.erg(), xs).nu_fission);
 
 			/* 5.2 ---- Cross the surface (checking boundary conditions) */
-			outside = not surface->cross(particle,sense,cell);
+			outside = not surface->cross(particle,sense,cell,&state);
 			assert(cell != 0);
 			if(outside) break;
 
 			/* 5.3 ---- Get material of the current cell (after crossing the surface) */
 			const Material* new_material = cell->getMaterial();
 			/* Transport the particle until a non-void cell is found (checking boundary conditions) */
-			outside = not voidTransport(new_material, particle, cell);
+			outside = not voidTransport(new_material, particle, cell, state);
 			if(outside) break;
 
 			/* 5.4 ---- Get next surface's distance */
 			double new_distance(0.0);
-			cell->intersect(particle.pos(), particle.dir(), surface, sense, new_distance);
+			cell->intersect(particle.pos(), particle.dir(), surface, sense, new_distance, &state);
 
 			/* Check if there is a change on the material */
 			if(new_material != material) {
 				/* Mean free path (the particle didn't change the energy) */
-				mfp = new_material->getMeanFreePath(particle.erg());
+				mfp = new_material->getXs(particle.erg(), xs).mfp;
 				/* 5.5 ---- Get collision distance */
 				collision_distance = -log(r.uniform())*mfp;
 				/* Update distance */
@@ -190,19 +195,20 @@ void AnalogKeff::history(size_t nbank, const std::vector<ChildTally*>& tally_con
 		particle.pos() = particle.pos() + collision_distance * particle.dir();
 		/* Accumulate track length estimation of the KEFF */
 		if(material->isFissile())
-			estimate<KEFF_TRK>(tally_container, particle.wgt() * collision_distance * material->getNuFission(particle.erg()));
+			estimate<KEFF_TRK>(tally_container, particle.wgt() * collision_distance * material->getXs(particle.erg(), xs).nu_fission);
 
 		/* 7. ---- Sample isotope */
-		const Isotope* isotope = material->getIsotope(particle.erg(),r);
+		const Isotope* isotope = material->getIsotope(particle.erg(), r, material->getXs(particle.erg(), xs));
 
 		/* Accumulate collision estimation of the KEFF */
 		if(material->isFissile())
-			estimate<KEFF_COL>(tally_container, particle.wgt() * material->getNuBar(particle.erg()));
+			estimate<KEFF_COL>(tally_container, particle.wgt() * material->getXs(particle.erg(), xs).nu_bar);
 
 		/* 8. ---- Sample reaction with the isotope */
 
 		/* 8.1 ---- Check the type of reaction reaction */
-		double absorption = isotope->getAbsorptionProb(particle.erg());
+		const XsCache& micro = isotope->getXs(particle.erg(), xs);
+		double absorption = micro.absorption;
 		double prob = r.uniform();
 
 		if(prob < absorption) {
@@ -212,9 +218,9 @@ void AnalogKeff::history(size_t nbank, const std::vector<ChildTally*>& tally_con
 			/* 8.2 ---- Absorption reaction , we should check if this is a fission reaction */
 			if(isotope->isFissile()) {
 				/* Fission data for the isotope */
-				double fission = isotope->getFissionProb(particle.erg());
+				double fission = micro.fission;
 				/* Get total NU */
-				double nubar = isotope->getNuBar(particle.erg());
+				double nubar = micro.isotope_nu_bar;
 
 				/* Accumulate absorption estimation of the KEFF */
 				estimate<KEFF_ABS>(tally_container, fission / absorption * particle.wgt() * nubar);
@@ -243,7 +249,7 @@ void AnalogKeff::history(size_t nbank, const std::vector<ChildTally*>& tally_con
 			break;
 		} else {
 			/* Get elastic probability */
-			double elastic = isotope->getElasticProb(particle.erg());
+			double elastic = micro.elastic;
 			/* 8.2 ---- Sample between inelastic and elastic scattering */
 			if((prob - absorption) <= elastic) {
 				/* Elastic reaction */
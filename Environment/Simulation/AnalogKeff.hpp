@@ -29,6 +29,7 @@
 #define ANALOGKEFF_HPP_
 
 #include "Simulation.hpp"
+#include "../../Geometry/GeometryState.hpp"
 
 namespace Helios {
 
@@ -41,9 +42,11 @@ class AnalogKeff: public Helios::SimulationBase {
 	std::vector<CellParticle> fission_bank;
 	/* Local bank on a cycle simulation */
 	vector<vector<CellParticle> > local_bank;
+	/* Compiled geometry used on the tracking */
+	const FlatGeometry* flat_geometry;
 
 	/* Transport a particle through void cells until a material is found or the particle get out of the system */
-	bool voidTransport(const Material*& material, Particle& particle, const Cell*& cell);
+	bool voidTransport(const Material*& material, Particle& particle, const Cell*& cell, GeometryState& state);
 
 	/* Estimators inside the cycle */
 	enum Estimator {
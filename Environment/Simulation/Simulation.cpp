@@ -149,6 +149,9 @@ void SimulationBase::launch() {
 		batch(INACTIVE);
 	}
 
+	/* Freeze the order of the cell searches learned on the inactive batches */
+	environment->getModule<Geometry>()->freezeCellOrder();
+
 	/* Get number of active nactive */
 	size_t nactive = nbatches - ninactive;
 
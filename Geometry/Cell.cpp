@@ -26,11 +26,16 @@
  */
 
 #include <limits>
+#include <cmath>
+#include <algorithm>
 
 #include "Cell.hpp"
 #include "Universe.hpp"
 #include "Surface.hpp"
 #include "Geometry.hpp"
+#include "GeometryState.hpp"
+#include "FlatGeometry.hpp"
+#include "CellExpression.hpp"
 #include <boost/tokenizer.hpp>
 
 using namespace std;
@@ -38,19 +43,54 @@ using namespace boost;
 
 namespace Helios {
 
-Cell::Cell(const CellObject* definition, const std::vector<SenseSurface>& surfaces) :
+Cell::Cell(const CellObject* definition, const std::vector<SenseSurface>& surfaces, CellExpression* expression) :
 	surfaces(surfaces),
+	expression(expression),
+	surface_block(surfaces),
 	flag(definition->getFlags()),
 	fill(0),
 	material(0),
 	parent(0),
+	instance(0),
+	temperature(0.0),
 	internal_id(0),
 	user_id(definition->getUserCellId())
 	{
     /* Set the new cell on surfaces neighbor container */
     vector<Cell::SenseSurface>::const_iterator it_sur = surfaces.begin();
-	for(; it_sur != surfaces.end() ; ++it_sur)
+	for(; it_sur != surfaces.end() ; ++it_sur) {
 		(*it_sur).first->addNeighborCell((*it_sur).second,this);
+		neighbor_cache.push_back(new NeighborCache);
+	}
+}
+
+Cell::~Cell() {
+	purgePointers(neighbor_cache);
+	delete expression;
+}
+
+void Cell::NeighborCache::push(const Cell* cell) {
+	PushMutex::scoped_lock lock(push_mutex);
+	size_t ncells = count;
+	/* Check if we already know this cell */
+	for(size_t i = 0 ; i < ncells ; ++i)
+		if(cells[i] == cell) return;
+	/* No more room, the caller will keep doing the full search for other cells */
+	if(ncells == capacity) return;
+	/* Write the cell before publishing it to the readers */
+	cells[ncells] = cell;
+	count = ncells + 1;
+}
+
+Cell::NeighborCache* Cell::getNeighborCache(const Surface* surface) const {
+	const Cell* cell = this;
+	while(cell) {
+		for(size_t i = 0 ; i < cell->surfaces.size() ; ++i)
+			if(cell->surfaces[i].first == surface) return cell->neighbor_cache[i];
+		/* Go to the upper level */
+		cell = cell->parent->getParent();
+	}
+	return 0;
 }
 
 void Cell::setFill(Universe* universe) {
@@ -71,6 +111,10 @@ std::ostream& operator<<(std::ostream& out, const Cell& q) {
 	/* Print material */
 	if(q.material) out << " ; material = " << q.material->getUserId();
 
+	/* Print instance and temperature */
+	out << " ; instance = " << q.getInstance();
+	if(q.getTemperature() > 0.0) out << " ; temperature = " << q.getTemperature() << " K";
+
 	/* Print flags */
 	out << " ; flags = " << q.getFlag(); out << endl;
 
@@ -87,11 +131,33 @@ std::ostream& operator<<(std::ostream& out, const Cell& q) {
 	return out;
 }
 
-bool Cell::isInside(const Coordinate& position, const Surface* skip) const {
+/* Sense of a point respect to the surfaces of an expression */
+class PointSense {
+	const vector<Surface*>& surfaces;
+	const Coordinate& position;
+	const GeometryState* state;
+public:
+	PointSense(const vector<Surface*>& surfaces, const Coordinate& position, const GeometryState* state) :
+		surfaces(surfaces), position(position), state(state) {/* */}
+	bool operator()(size_t index) const {
+		return state ? state->sense(surfaces[index],position) : surfaces[index]->sense(position);
+	}
+};
+
+bool Cell::isInside(const Coordinate& position, const Surface* skip, GeometryState* state) const {
+	if(expression) {
+		/*
+		 * A surface could be on the expression with both senses, so the skipped surface can't be
+		 * assumed to be on the right side. The state knows the sense of the surface just crossed.
+		 */
+		PointSense point_sense(expression->getSurfaces(),position,state);
+		return expression->evaluate(point_sense);
+	}
 	vector<SenseSurface>::const_iterator it;
 	for (it = surfaces.begin(); it != surfaces.end(); ++it) {
 		if (it->first != skip) {
-			if (it->first->sense(position) != it->second)
+			bool point_sense = state ? state->sense(it->first,position) : it->first->sense(position);
+			if (point_sense != it->second)
 			/* The sense of the point isn't the same the same sense as we know this cell is defined... */
 			return false;
 		}
@@ -99,19 +165,25 @@ bool Cell::isInside(const Coordinate& position, const Surface* skip) const {
 	return true;
 }
 
-const Cell* Cell::findCell(const Coordinate& position, const Surface* skip) const {
+const Cell* Cell::findCell(const Coordinate& position, const Surface* skip, GeometryState* state) const {
+	/* Search on the compiled geometry */
+	if(state && state->getFlatGeometry()) return state->getFlatGeometry()->findCell(this,position,skip,state);
 	/* Check if the point is inside this cell */
-	if(!isInside(position,skip)) return 0;
+	if(!isInside(position,skip,state)) return 0;
     /* If we get here, we are inside the cell :-) */
-	if(fill) return fill->findCell(position,skip);
+	if(fill) return fill->findCell(position,skip,state);
 	else return this;
 }
 
-void Cell::intersect(const Coordinate& position, const Direction& direction, Surface*& surface, bool& sense, double& distance) const {
+void Cell::intersect(const Coordinate& position, const Direction& direction, Surface*& surface, bool& sense, double& distance,
+		             GeometryState* state) const {
 
     /* If we have a parent "cell" we should check first on upper levels first */
     const Cell* parent_cell = parent->getParent();
-    if(parent_cell){
+    if(state) {
+    	/* Distances to upper levels are cached on the state */
+    	state->intersectParents(this,position,direction,surface,sense,distance);
+    } else if(parent_cell){
     	parent_cell->intersect(position,direction,surface,sense,distance);
     } else {
         surface = 0;
@@ -119,22 +191,82 @@ void Cell::intersect(const Coordinate& position, const Direction& direction, Sur
         distance = std::numeric_limits<double>::infinity();
     }
 
-    /* Loop over surfaces */
-	vector<SenseSurface>::const_iterator it;
-	for (it = surfaces.begin() ; it != surfaces.end(); ++it) {
-		/* Distance to the surface */
-        double newDistance;
-        /* Check the intersection with each surface */
-		if(it->first->intersect(position,direction,it->second,newDistance)) {
-			if (newDistance < distance) {
-				/* Update data */
-				distance = newDistance;
-				surface = it->first;
-				sense = it->second;
+    /* Now check the surfaces of this cell */
+    intersectSurfaces(position,direction,surface,sense,distance);
+}
+
+void Cell::intersectSurfaces(const Coordinate& position, const Direction& direction, Surface*& surface, bool& sense, double& distance) const {
+	/* The region could be non-convex, the particle doesn't leave the cell on each surface */
+	if(expression) {
+		intersectExpression(position,direction,surface,sense,distance);
+		return;
+	}
+	/* Distances are calculated on batches of surfaces of the same type */
+	surface_block.intersect(position,direction,surface,sense,distance);
+}
+
+/* Points closer than this (on the value of the surface function) are considered on the surface */
+static const double on_surface = 1e-10;
+
+/* Sense of a point respect to a surface, if the point is on the surface take the side where the particle is going */
+static inline bool trackSense(const Surface* surface, const Coordinate& position, const Direction& direction) {
+	double value = surface->function(position);
+	if(std::abs(value) > on_surface) return (value >= 0);
+	Direction vnormal;
+	surface->normal(position,vnormal);
+	return (dot(vnormal,direction) >= 0);
+}
+
+/* Senses known along the track */
+class TrackSense {
+	const vector<bool>& senses;
+public:
+	TrackSense(const vector<bool>& senses) : senses(senses) {/* */}
+	bool operator()(size_t index) const {return senses[index];}
+};
+
+void Cell::intersectExpression(const Coordinate& position, const Direction& direction, Surface*& surface, bool& sense, double& distance) const {
+	const vector<Surface*>& expression_surfaces = expression->getSurfaces();
+	size_t nsurfaces = expression_surfaces.size();
+
+	/* Sense of the particle respect to each surface */
+	vector<bool> senses(nsurfaces);
+	for(size_t i = 0 ; i < nsurfaces ; ++i)
+		senses[i] = trackSense(expression_surfaces[i],position,direction);
+
+	/*
+	 * Walk along the track crossing the surfaces, until the expression is false. A line crosses a
+	 * quadric at most twice, so there is a limited number of crossings to check.
+	 */
+	double traveled = 0.0;
+	Coordinate point(position);
+	for(size_t crossing = 0 ; crossing < 2 * nsurfaces ; ++crossing) {
+		/* Next surface along the track */
+		size_t next = nsurfaces;
+		double next_distance = std::numeric_limits<double>::infinity();
+		for(size_t i = 0 ; i < nsurfaces ; ++i) {
+			double new_distance;
+			if(expression_surfaces[i]->intersect(point,direction,senses[i],new_distance) && new_distance < next_distance) {
+				next_distance = new_distance;
+				next = i;
 			}
 		}
+		/* The particle doesn't leave the region, or there is a closer surface */
+		if(next == nsurfaces) return;
+		traveled += next_distance;
+		if(traveled >= distance) return;
+		/* Cross the surface */
+		point = position + traveled * direction;
+		senses[next] = not senses[next];
+		TrackSense track_sense(senses);
+		if(not expression->evaluate(track_sense)) {
+			/* Out of the cell */
+			distance = traveled;
+			surface = expression_surfaces[next];
+			sense = not senses[next];
+			return;
+		}
 	}
-
 }
 
 static inline bool getSign(const SurfaceId& value) {
@@ -143,8 +275,8 @@ static inline bool getSign(const SurfaceId& value) {
 }
 
 static inline SurfaceId getAbsId(const SurfaceId& sense_id) {
-	char_separator<char> sep("- ");
-	/* Get user ID */
+	char_separator<char> sep("+- ");
+	/* Get user ID (the sense could be explicit, "+3") */
 	tokenizer<char_separator<char> > tok(sense_id,sep);
 	return (*tok.begin());
 }
@@ -160,19 +292,53 @@ static inline vector<string> getUniqueTokens(const char_separator<char>& sep, co
 }
 
 std::vector<SurfaceId> CellFactory::getSurfacesIds(const string& surface_expresion) {
-	return getUniqueTokens(char_separator<char>("():- "),surface_expresion);
+	return getUniqueTokens(char_separator<char>("():-+# "),surface_expresion);
+}
+
+void CellObject::parse() const {
+	if(parsed) return;
+	surfaces_ids = CellFactory::getSurfacesIds(surfaces_expression);
+	complex = CellExpression::isComplex(surfaces_expression);
+	/* Only groups are complemented, "#3" (the complement of cell 3 on MCNP) is not a surface */
+	for(size_t hash = surfaces_expression.find('#') ; hash != string::npos ; hash = surfaces_expression.find('#',hash + 1)) {
+		size_t next = surfaces_expression.find_first_not_of(" \t\n",hash + 1);
+		if(next == string::npos || surfaces_expression[next] != '(')
+			throw Cell::BadCellCreation(user_cell_id,"Only a group can be complemented, #( ... ) (the complement of a cell is not supported)");
+	}
+	if(not complex) {
+		vector<string> tokens = getUniqueTokens(char_separator<char>("() "),surfaces_expression);
+		for(vector<string>::const_iterator it = tokens.begin() ; it != tokens.end() ; ++it)
+			half_spaces.push_back(make_pair(getAbsId(*it),getSign(*it)));
+	}
+	parsed = true;
 }
 
-Cell* CellFactory::createCell(const CellObject* definition, std::map<SurfaceId,Surface*>& cell_surfaces) const {
-	/* Get surface expression */
-	string surface_expresion = definition->getSurfacesExpression();
-	vector<string> tokens = getUniqueTokens(char_separator<char>("() "),surface_expresion);;
+Cell* CellFactory::createCell(const CellObject* definition, std::map<SurfaceId,Surface*>& cell_surfaces,
+		                      const std::set<SurfaceId>& flipped_surfaces) const {
+	/* Cells with unions or complements are defined with an expression of half-spaces */
+	if(definition->isComplex()) {
+		CellExpression* expression = 0;
+		try {
+			expression = new CellExpression(definition->getSurfacesExpression(),cell_surfaces,flipped_surfaces);
+		} catch(CellExpression::BadExpression& error) {
+			throw Cell::BadCellCreation(definition->getUserCellId(),error.what());
+		}
+		return new Cell(definition,expression->getHalfSpaces(),expression);
+	}
 
-	/* Now get the tokens and craft a container with surfaces and senses */
+	/* Now get the half-spaces and craft a container with surfaces and senses */
+	const vector<pair<SurfaceId,bool> >& half_spaces = definition->getHalfSpaces();
 	vector<Cell::SenseSurface> sense_surfaces_container;
-	for(vector<string>::const_iterator it = tokens.begin() ; it != tokens.end() ; ++it) {
-		Cell::SenseSurface sense_surface(cell_surfaces[getAbsId(*it)],getSign(*it));
-		sense_surfaces_container.push_back(sense_surface);
+	sense_surfaces_container.reserve(half_spaces.size());
+	for(vector<pair<SurfaceId,bool> >::const_iterator it = half_spaces.begin() ; it != half_spaces.end() ; ++it) {
+		map<SurfaceId,Surface*>::const_iterator it_sur = cell_surfaces.find((*it).first);
+		if(it_sur == cell_surfaces.end() || not (*it_sur).second)
+			throw Cell::BadCellCreation(definition->getUserCellId(),"Surface " + (*it).first + " doesn't exist");
+		bool flipped = (flipped_surfaces.find((*it).first) != flipped_surfaces.end());
+		Cell::SenseSurface sense_surface((*it_sur).second,(*it).second != flipped);
+		/* Different half-spaces could be on the same surface (faces of a feature merged with the parent surfaces) */
+		if(find(sense_surfaces_container.begin(),sense_surfaces_container.end(),sense_surface) == sense_surfaces_container.end())
+			sense_surfaces_container.push_back(sense_surface);
 	}
 
 	return new Cell(definition,sense_surfaces_container);
@@ -31,16 +31,22 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <set>
+#include <tbb/atomic.h>
+#include <tbb/spin_mutex.h>
 
 #include "../Common/Common.hpp"
 #include "../Material/Material.hpp"
 #include "Transformation.hpp"
 #include "GeometryObject.hpp"
+#include "Surfaces/SurfaceBlock.hpp"
 
 namespace Helios {
 
 	class Universe;
 	class CellObject;
+	class GeometryState;
+	class CellExpression;
 
 	class Cell {
 
@@ -74,8 +80,40 @@ namespace Helios {
 			~BadCellCreation() throw() {/* */};
 		};
 
-		/* Get container of bounding surfaces. */
+		/*
+		 * Cells reached when a particle leaves this cell through one of its bounding surfaces.
+		 * The container is filled lazily during the transport (append-only) and is safe to read
+		 * while other threads are adding cells on it.
+		 */
+		class NeighborCache {
+		public:
+			/* Maximum number of learned neighbors on each face */
+			static const size_t capacity = 8;
+			NeighborCache() {count = 0;}
+			/* Number of cells learned */
+			size_t size() const {return count;}
+			/* Get a learned cell */
+			const Cell* operator[](size_t i) const {return cells[i];}
+			/* Learn a new neighbor (nothing is done if the cell is already here or the container is full) */
+			void push(const Cell* cell);
+			~NeighborCache() {/* */}
+		private:
+			/* Prevent copy */
+			NeighborCache(const NeighborCache& other);
+			NeighborCache& operator= (const NeighborCache& other);
+			/* Cells reached through this face */
+			const Cell* cells[capacity];
+			/* Number of cells, published after the cell is written */
+			tbb::atomic<size_t> count;
+			/* Mutex to add a new cell */
+			typedef tbb::spin_mutex PushMutex;
+			PushMutex push_mutex;
+		};
+
+		/* Get container of bounding surfaces (all the half-spaces, if the cell is defined with an expression) */
 		const std::vector<SenseSurface>& getBoundingSurfaces() const { return surfaces;}
+		/* Get the expression of the cell region (NULL if the cell is an intersection of half-spaces) */
+		const CellExpression* getExpression() const {return expression;}
 
 		/* Return the internal ID associated with this cell. */
 		const CellId& getUserId() const {return user_id;}
@@ -100,6 +138,19 @@ namespace Helios {
 		/* Get the material that is filling this cell (NULL if any) */
 		const Material* getMaterial() const {return material;}
 
+		/*
+		 * Set the instance of the cell. Each time an universe fills a cell, the cells inside are replicated; the
+		 * instance is a dense index (starting at zero) of this replica among all the replicas of the same user cell.
+		 */
+		void setInstance(size_t cell_instance) {instance = cell_instance;}
+		/* Get the instance of this cell */
+		size_t getInstance() const {return instance;}
+
+		/* Set the temperature of this instance of the cell (in Kelvin) */
+		void setTemperature(double cell_temperature) {temperature = cell_temperature;}
+		/* Get the temperature of this instance of the cell (zero if not defined by the user) */
+		double getTemperature() const {return temperature;}
+
 		/* Set the parent universe of this cell */
 		void setParent(Universe* parent_universe) {parent = parent_universe;}
 		/* Get the universe where this cell is */
@@ -109,30 +160,58 @@ namespace Helios {
 		 * Check if the cell contains the point and return a reference to the cell that the point is contained.
 		 * The cell could be at other level (universe) on the geometry (a recursive search is done).
 		 * A NULL pointer is returned if the point is not inside this cell.
-		 * Optionally skip checking one surface if we know we've crossed it.
+		 * Optionally skip checking one surface if we know we've crossed it, and reuse the senses
+		 * already known on the geometry state of the particle.
 		 */
-		const Cell* findCell(const Coordinate& position, const Surface* skip = 0) const;
+		const Cell* findCell(const Coordinate& position, const Surface* skip = 0, GeometryState* state = 0) const;
 
 		/*
 		 * Check if the cell contains the point.
 		 * Optionally skip checking one surface if we know we've crossed it.
 		 */
-		bool isInside(const Coordinate& position, const Surface* skip = 0) const;
+		bool isInside(const Coordinate& position, const Surface* skip = 0, GeometryState* state = 0) const;
 
-		/* Get the nearest surface to a point in a given direction */
-		void intersect(const Coordinate& position, const Direction& direction, Surface*& surface, bool& sense, double& distance) const;
+		/*
+		 * Get the nearest surface to a point in a given direction. If a geometry state is provided, the
+		 * distances to the boundaries of the parent cells are taken from there.
+		 */
+		void intersect(const Coordinate& position, const Direction& direction, Surface*& surface, bool& sense, double& distance,
+				       GeometryState* state = 0) const;
 
-		virtual ~Cell() {/* */};
+		/*
+		 * Get the nearest surface of this cell (parents are not checked). The surface, sense and distance are
+		 * only updated if the intersection is closer than the distance passed.
+		 */
+		void intersectSurfaces(const Coordinate& position, const Direction& direction, Surface*& surface, bool& sense, double& distance) const;
+
+		/*
+		 * Get the learned neighbors when leaving this cell through a surface. If the surface
+		 * does not bound this cell, the parent cells are checked (the surface could be on
+		 * an upper level). A NULL pointer is returned if the surface is not found.
+		 */
+		NeighborCache* getNeighborCache(const Surface* surface) const;
+
+		virtual ~Cell();
 
 	protected:
 
-		Cell(const CellObject* definition, const std::vector<SenseSurface>& surfaces);
+		/* The cell takes the ownership of the expression (if any) */
+		Cell(const CellObject* definition, const std::vector<SenseSurface>& surfaces, CellExpression* expression = 0);
 		/* Prevent copy */
 		Cell(const Cell& cell);
 		Cell& operator= (const Cell& other);
 
+		/* Nearest point where the particle leaves the region defined by the expression */
+		void intersectExpression(const Coordinate& position, const Direction& direction, Surface*& surface, bool& sense, double& distance) const;
+
 		/* A vector of surfaces and senses that define this cell */
 		std::vector<SenseSurface> surfaces;
+		/* Region of the cell, if is not an intersection of the surfaces */
+		CellExpression* expression;
+		/* Learned neighbors for each bounding surface (same order as the surfaces container) */
+		std::vector<NeighborCache*> neighbor_cache;
+		/* Bounding surfaces grouped by type, to calculate distances */
+		SurfaceBlock surface_block;
 		/* Other information about this cell */
 		CellInfo flag;
 		/* Reference to the universe that is filling this cell, NULL if any (material cell). */
@@ -144,6 +223,10 @@ namespace Helios {
 		 * always has a parent (even in the base universe)
 		 */
 		Universe* parent;
+		/* Instance of the user cell (dense index of this replica) */
+		size_t instance;
+		/* Temperature of this instance */
+		double temperature;
 		/* Internal identification of this cell */
 		InternalCellId internal_id;
 		/* cCell id choose by the user */
@@ -158,25 +241,52 @@ namespace Helios {
 		Cell::CellInfo flags;
 		UniverseId universe;
 		UniverseId fill;
-		MaterialId matId;
+		std::vector<MaterialId> materials; /* One for all the instances, or one for each instance */
+		std::vector<double> temperatures;  /* Same, empty if the temperature is not defined */
 		Transformation transformation;
 		std::string surfaces_expression;   /* IDs of the surfaces */
+		/*
+		 * The expression is parsed once for all the instances of the cell : IDs of the surfaces
+		 * (without duplicates), and half-spaces of the cell (only if the cell is an intersection)
+		 */
+		mutable bool parsed;
+		mutable bool complex;
+		mutable std::vector<SurfaceId> surfaces_ids;
+		mutable std::vector<std::pair<SurfaceId,bool> > half_spaces;
+		/* Parse the expression (if it wasn't parsed before) */
+		void parse() const;
 		friend class Cell;
 	public:
 
-		CellObject() : GeometryObject(Cell::name()) {/* */}
+		CellObject() : GeometryObject(Cell::name()), parsed(false), complex(false) {/* */}
 		CellObject(const CellId& userCellId, const std::string& surfaces_expression, const Cell::CellInfo flags,
 				   const UniverseId& universe, const UniverseId& fill,const MaterialId& matId, const Transformation& transformation) :
 				   GeometryObject(Cell::name()), user_cell_id(userCellId), flags(flags),universe(universe), fill(fill),
-				   matId(matId), transformation(transformation),surfaces_expression(surfaces_expression) {/* */}
+				   materials(1,matId), temperatures(), transformation(transformation),surfaces_expression(surfaces_expression),
+				   parsed(false), complex(false) {/* */}
+		CellObject(const CellId& userCellId, const std::string& surfaces_expression, const Cell::CellInfo flags,
+				   const UniverseId& universe, const UniverseId& fill, const std::vector<MaterialId>& materials,
+				   const std::vector<double>& temperatures, const Transformation& transformation) :
+				   GeometryObject(Cell::name()), user_cell_id(userCellId), flags(flags),universe(universe), fill(fill),
+				   materials(materials), temperatures(temperatures), transformation(transformation),surfaces_expression(surfaces_expression),
+				   parsed(false), complex(false) {/* */}
 		Cell::CellInfo getFlags() const {return flags;}
 		CellId getUserCellId() const {return user_cell_id;}
 		UniverseId getUniverse() const {return universe;}
 		UniverseId getFill() const {return fill;}
-		MaterialId getMatId() const {return matId;}
+		/* Materials of the cell (one for each instance, or the same for all of them) */
+		const std::vector<MaterialId>& getMaterials() const {return materials;}
+		/* Temperatures of the cell (one for each instance, or the same for all of them) */
+		const std::vector<double>& getTemperatures() const {return temperatures;}
 		Transformation getTransformation() const {return transformation;}
 		/* Getting surfaces */
 		std::string getSurfacesExpression() const {return surfaces_expression;}
+		/* IDs of the surfaces on the expression (without duplicates) */
+		const std::vector<SurfaceId>& getSurfacesIds() const {parse(); return surfaces_ids;}
+		/* Check if the cell is defined with unions or complements */
+		bool isComplex() const {parse(); return complex;}
+		/* Half-spaces (surface ID and sense) of a cell that is an intersection */
+		const std::vector<std::pair<SurfaceId,bool> >& getHalfSpaces() const {parse(); return half_spaces;}
 		~CellObject() {/* */}
 	};
 
@@ -192,7 +302,8 @@ namespace Helios {
 		/* Prevent construction or copy */
 		CellFactory() {/* */};
 		/* Create a new surface */
-		Cell* createCell(const CellObject* definition, std::map<SurfaceId,Surface*>& cell_surfaces) const;
+		Cell* createCell(const CellObject* definition, std::map<SurfaceId,Surface*>& cell_surfaces,
+				         const std::set<SurfaceId>& flipped_surfaces) const;
 		virtual ~CellFactory() {/* */}
 	};
 
@@ -0,0 +1,231 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cctype>
+
+#include "CellExpression.hpp"
+#include "Surfaces/SurfaceTypes.hpp"
+
+using namespace std;
+
+namespace Helios {
+
+/* Relative cost of evaluating a surface (planes are the cheapest ones) */
+static size_t surfaceCost(const Surface* surface) {
+	if(dynamic_cast<const PlaneNormal<xaxis>*>(surface) || dynamic_cast<const PlaneNormal<yaxis>*>(surface) ||
+	   dynamic_cast<const PlaneNormal<zaxis>*>(surface) || dynamic_cast<const Plane*>(surface))
+		return 1;
+	return 2;
+}
+
+class CellExpression::Parser {
+
+	/* Node of the tree while parsing */
+	struct ParseNode {
+		ParseNode(Node::Type type = Node::HALFSPACE) : type(type), surface(0), sense(true), cost(0) {/* */}
+		Node::Type type;
+		std::vector<ParseNode> children;
+		size_t surface;
+		bool sense;
+		size_t cost;
+		/* Add an operand (nested operators of the same type are merged) */
+		void push(const ParseNode& child) {
+			if(child.type == type)
+				children.insert(children.end(), child.children.begin(), child.children.end());
+			else
+				children.push_back(child);
+		}
+		/* Operators with only one operand are replaced by the operand */
+		ParseNode reduce() const {
+			if(type != Node::HALFSPACE && children.size() == 1) return children[0];
+			return *this;
+		}
+	};
+
+	/* Compare nodes by cost */
+	static bool cheaper(const ParseNode& left, const ParseNode& right) {return left.cost < right.cost;}
+
+	/* Original expression */
+	std::string expression;
+	/* Tokens of the expression */
+	std::vector<std::string> tokens;
+	/* Current token */
+	size_t current;
+	/* Surfaces referenced on the expression */
+	const std::map<SurfaceId,Surface*>& user_surfaces;
+	/* Surfaces with the opposite sense of the one used on the expression */
+	const std::set<SurfaceId>& flipped_surfaces;
+	/* Expression being constructed */
+	CellExpression& cell_expression;
+
+	void tokenize() {
+		string token;
+		for(string::const_iterator it = expression.begin() ; it != expression.end() ; ++it) {
+			char c = *it;
+			if(isspace(c) || c == '(' || c == ')' || c == ':' || c == '#') {
+				if(token.size()) tokens.push_back(token);
+				token.clear();
+				if(not isspace(c)) tokens.push_back(string(1,c));
+			} else
+				token += c;
+		}
+		if(token.size()) tokens.push_back(token);
+	}
+
+	bool isToken(const std::string& value) const {
+		return (current < tokens.size()) && (tokens[current] == value);
+	}
+
+	/* Get the index of a surface on the expression */
+	size_t getSurface(const std::string& id) {
+		map<SurfaceId,Surface*>::const_iterator it = user_surfaces.find(id);
+		if(it == user_surfaces.end())
+			throw BadExpression(expression,"Surface " + id + " doesn't exist");
+		vector<Surface*>& surfaces = cell_expression.surfaces;
+		vector<Surface*>::const_iterator it_sur = find(surfaces.begin(), surfaces.end(), it->second);
+		if(it_sur != surfaces.end()) return it_sur - surfaces.begin();
+		surfaces.push_back(it->second);
+		return surfaces.size() - 1;
+	}
+
+	/* Union of intersections (with the complement, is an intersection of unions) */
+	ParseNode parseUnion(bool complement) {
+		ParseNode node(complement ? Node::INTERSECTION : Node::UNION);
+		node.push(parseIntersection(complement));
+		while(isToken(":")) {
+			current++;
+			node.push(parseIntersection(complement));
+		}
+		return node.reduce();
+	}
+
+	/* Intersection of half-spaces or groups */
+	ParseNode parseIntersection(bool complement) {
+		ParseNode node(complement ? Node::UNION : Node::INTERSECTION);
+		while(current < tokens.size() && not isToken(")") && not isToken(":"))
+			node.push(parseFactor(complement));
+		if(node.children.size() == 0)
+			throw BadExpression(expression,"Empty region");
+		return node.reduce();
+	}
+
+	/* Half-space, group or complement */
+	ParseNode parseFactor(bool complement) {
+		if(current >= tokens.size())
+			throw BadExpression(expression,"Unexpected end of the expression");
+		if(isToken("#")) {
+			current++;
+			if(not isToken("("))
+				throw BadExpression(expression,"Only a group can be complemented, #( ... ) (the complement of a cell is not supported)");
+			return parseFactor(not complement);
+		}
+		if(isToken("(")) {
+			current++;
+			ParseNode node = parseUnion(complement);
+			if(not isToken(")"))
+				throw BadExpression(expression,"Missing closing parenthesis");
+			current++;
+			return node;
+		}
+		if(isToken(")") || isToken(":"))
+			throw BadExpression(expression,"Unexpected token " + tokens[current]);
+		/* Half-space */
+		string id = tokens[current++];
+		bool sense = true;
+		if(id[0] == '-' || id[0] == '+') {
+			sense = (id[0] == '+');
+			id = id.substr(1);
+		}
+		if(id.size() == 0)
+			throw BadExpression(expression,"Missing surface after sign");
+		ParseNode node;
+		node.surface = getSurface(id);
+		bool flipped = (flipped_surfaces.find(id) != flipped_surfaces.end());
+		node.sense = ((sense != complement) != flipped);
+		/* Save the half-space */
+		SenseSurface half_space(cell_expression.surfaces[node.surface],node.sense);
+		vector<SenseSurface>& half_spaces = cell_expression.half_spaces;
+		if(find(half_spaces.begin(), half_spaces.end(), half_space) == half_spaces.end())
+			half_spaces.push_back(half_space);
+		return node;
+	}
+
+	/* Sort the operands (cheaper first) and calculate the cost of each node */
+	void sort(ParseNode& node) const {
+		if(node.type == Node::HALFSPACE) {
+			node.cost = surfaceCost(cell_expression.surfaces[node.surface]);
+			return;
+		}
+		node.cost = 0;
+		for(vector<ParseNode>::iterator it = node.children.begin() ; it != node.children.end() ; ++it) {
+			sort(*it);
+			node.cost += it->cost;
+		}
+		stable_sort(node.children.begin(), node.children.end(), cheaper);
+	}
+
+	/* Put the tree on prefix order */
+	void flatten(const ParseNode& node) {
+		vector<Node>& nodes = cell_expression.nodes;
+		size_t index = nodes.size();
+		nodes.push_back(Node(node.type, 1, node.surface, node.sense));
+		for(vector<ParseNode>::const_iterator it = node.children.begin() ; it != node.children.end() ; ++it)
+			flatten(*it);
+		nodes[index].size = nodes.size() - index;
+	}
+
+public:
+
+	Parser(const std::string& expression, const std::map<SurfaceId,Surface*>& user_surfaces,
+		   const std::set<SurfaceId>& flipped_surfaces, CellExpression& cell_expression) :
+		   expression(expression), current(0), user_surfaces(user_surfaces), flipped_surfaces(flipped_surfaces),
+		   cell_expression(cell_expression) {/* */}
+
+	void parse() {
+		tokenize();
+		ParseNode root = parseUnion(false);
+		if(current != tokens.size())
+			throw BadExpression(expression,"Unexpected token " + tokens[current]);
+		sort(root);
+		flatten(root);
+	}
+
+	~Parser() {/* */}
+};
+
+CellExpression::CellExpression(const std::string& expression, const std::map<SurfaceId,Surface*>& user_surfaces,
+		                       const std::set<SurfaceId>& flipped_surfaces) {
+	Parser parser(expression,user_surfaces,flipped_surfaces,*this);
+	parser.parse();
+}
+
+bool CellExpression::isComplex(const std::string& expression) {
+	return (expression.find(':') != string::npos) || (expression.find('#') != string::npos);
+}
+
+} /* namespace Helios */
@@ -0,0 +1,143 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CELLEXPRESSION_HPP_
+#define CELLEXPRESSION_HPP_
+
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <exception>
+
+#include "../Common/Common.hpp"
+
+namespace Helios {
+
+	class Surface;
+
+	/*
+	 * Region of a cell defined with a boolean expression of half-spaces. The syntax is the same
+	 * used on MCNP :
+	 *
+	 *  - A surface ID with a sign is a half-space ("-1" is the negative side of surface 1).
+	 *  - Half-spaces separated by blanks are intersected.
+	 *  - The colon is the union operator (with lower precedence than the intersection).
+	 *  - Parentheses group expressions, and '#' is the complement of the next group, "#( ... )".
+	 *
+	 * The complement of a cell ("#3" is the complement of cell 3 on MCNP) is not supported.
+	 *
+	 * Complements are removed when the expression is parsed (applying De Morgan's laws), so the
+	 * expression is stored as a tree of unions and intersections of half-spaces. The tree is saved
+	 * on prefix order on a contiguous container, and the operands of each operator are sorted
+	 * to check first the surfaces that are cheaper to evaluate.
+	 */
+	class CellExpression {
+
+	public:
+
+		/* Pair of surface and sense */
+		typedef std::pair<Surface*, bool> SenseSurface;
+
+		/* Exception */
+		class BadExpression : public std::exception {
+			std::string reason;
+		public:
+			BadExpression(const std::string& expression, const std::string& msg) {
+				reason = "Bad surface expression (" + expression + ") : " + msg;
+			}
+			const char *what() const throw() {
+				return reason.c_str();
+			}
+			~BadExpression() throw() {/* */};
+		};
+
+		/* Parse an expression, with the surfaces referenced on it (and the ones with the opposite sense) */
+		CellExpression(const std::string& expression, const std::map<SurfaceId,Surface*>& surfaces,
+				       const std::set<SurfaceId>& flipped_surfaces);
+
+		/* Check if the expression has union or complement operators */
+		static bool isComplex(const std::string& expression);
+
+		/* Distinct surfaces on the expression */
+		const std::vector<Surface*>& getSurfaces() const {return surfaces;}
+		/* Distinct half-spaces (pairs of surface and sense) on the expression */
+		const std::vector<SenseSurface>& getHalfSpaces() const {return half_spaces;}
+
+		/*
+		 * Evaluate the expression. The functor receives the index of a surface (on the container of
+		 * distinct surfaces) and should return the sense of the point respect to that surface. The
+		 * evaluation stops as soon as the result of an operator is known.
+		 */
+		template<class SenseFunction>
+		bool evaluate(SenseFunction& sense) const {
+			return evaluate(sense,0);
+		}
+
+		~CellExpression() {/* */}
+
+	private:
+
+		/* Node of the expression tree */
+		struct Node {
+			enum Type {HALFSPACE, INTERSECTION, UNION};
+			Node(Type type, size_t size, size_t surface, bool sense) : type(type), size(size), surface(surface), sense(sense) {/* */}
+			/* Type of node */
+			Type type;
+			/* Number of nodes on this sub-tree (including this one) */
+			size_t size;
+			/* Half-space surface (index on the container of surfaces) and sense */
+			size_t surface;
+			bool sense;
+		};
+
+		template<class SenseFunction>
+		bool evaluate(SenseFunction& sense, size_t index) const {
+			const Node& node = nodes[index];
+			if(node.type == Node::HALFSPACE) return (sense(node.surface) == node.sense);
+			bool intersection = (node.type == Node::INTERSECTION);
+			size_t end = index + node.size;
+			for(size_t child = index + 1 ; child < end ; child += nodes[child].size) {
+				/* Short-circuit the evaluation */
+				if(evaluate(sense,child) != intersection) return not intersection;
+			}
+			return intersection;
+		}
+
+		/* Tree on prefix order */
+		std::vector<Node> nodes;
+		/* Distinct surfaces */
+		std::vector<Surface*> surfaces;
+		/* Distinct half-spaces */
+		std::vector<SenseSurface> half_spaces;
+
+		/* Auxiliary class used to parse the expression */
+		class Parser;
+	};
+
+} /* namespace Helios */
+#endif /* CELLEXPRESSION_HPP_ */
@@ -0,0 +1,255 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include "FlatGeometry.hpp"
+#include "Surfaces/SurfaceTypes.hpp"
+#include "Cell.hpp"
+#include "Universe.hpp"
+
+using namespace std;
+
+namespace Helios {
+
+const FlatGeometry::Index FlatGeometry::none = std::numeric_limits<FlatGeometry::Index>::max();
+
+/* Coefficients of a surface on the compiled geometry */
+struct FlatCoefficients {
+	FlatCoefficients() : u(0.0), v(0.0), radius2(0.0) {/* */}
+	double u, v, radius2;
+};
+
+/* Check if the surface is a plane normal to some axis */
+template<int axis>
+static bool flatPlane(const Surface* surface, FlatCoefficients& coeffs) {
+	if(const PlaneNormal<axis>* plane = dynamic_cast<const PlaneNormal<axis>*>(surface)) {
+		coeffs.u = plane->getCoordinate();
+		return true;
+	}
+	return false;
+}
+
+/* Check if the surface is a cylinder parallel to some axis */
+template<int axis>
+static bool flatCylinder(const Surface* surface, FlatCoefficients& coeffs) {
+	/* Axis perpendicular to the cylinder (same order used on dotProduct) */
+	const int iu = (axis == xaxis) ? yaxis : xaxis;
+	const int iv = (axis == zaxis) ? yaxis : zaxis;
+	if(const CylinderOnAxis<axis>* cyl = dynamic_cast<const CylinderOnAxis<axis>*>(surface)) {
+		coeffs.u = cyl->getPoint()[iu];
+		coeffs.v = cyl->getPoint()[iv];
+		coeffs.radius2 = cyl->getRadius() * cyl->getRadius();
+		return true;
+	}
+	if(const CylinderOnAxisOrigin<axis>* cyl = dynamic_cast<const CylinderOnAxisOrigin<axis>*>(surface)) {
+		coeffs.radius2 = cyl->getRadius() * cyl->getRadius();
+		return true;
+	}
+	return false;
+}
+
+/* Check if the surface is a sphere */
+static bool flatSphere(const Surface* surface, FlatCoefficients& coeffs) {
+	if(const SphereOnOrigin* sph = dynamic_cast<const SphereOnOrigin*>(surface)) {
+		coeffs.radius2 = sph->getRadius() * sph->getRadius();
+		return true;
+	}
+	return false;
+}
+
+FlatGeometry::FlatGeometry(const std::vector<Surface*>& surfaces, const std::vector<Cell*>& cells, const std::vector<Universe*>& universes) :
+		cells(cells.begin(), cells.end()), thread_hits(std::vector<unsigned long long>(cells.size(), 0)),
+		cell_hits(cells.size(), 0), learning(true) {
+
+	/* ---- Surfaces */
+	size_t nsurfaces = surfaces.size();
+	vector<Kind> kinds(nsurfaces);
+	vector<FlatCoefficients> coeffs(nsurfaces);
+	for(size_t i = 0 ; i < nsurfaces ; ++i) {
+		const Surface* surface = surfaces[i];
+		FlatCoefficients& c = coeffs[i];
+		if(flatPlane<xaxis>(surface,c)) kinds[i] = xplane;
+		else if(flatPlane<yaxis>(surface,c)) kinds[i] = yplane;
+		else if(flatPlane<zaxis>(surface,c)) kinds[i] = zplane;
+		else if(flatCylinder<xaxis>(surface,c)) kinds[i] = xcylinder;
+		else if(flatCylinder<yaxis>(surface,c)) kinds[i] = ycylinder;
+		else if(flatCylinder<zaxis>(surface,c)) kinds[i] = zcylinder;
+		else if(flatSphere(surface,c)) kinds[i] = sphere;
+		else kinds[i] = generic;
+	}
+
+	/* Sort the surfaces by kind (keeping the original order inside each kind) */
+	surface_index.resize(nsurfaces);
+	for(int kind = xplane ; kind <= generic ; ++kind) {
+		for(size_t i = 0 ; i < nsurfaces ; ++i) {
+			if(kinds[i] != kind) continue;
+			surface_index[surfaces[i]->getInternalId()] = surface_kind.size();
+			surface_kind.push_back(kind);
+			surface_u.push_back(coeffs[i].u);
+			surface_v.push_back(coeffs[i].v);
+			surface_radius2.push_back(coeffs[i].radius2);
+			surface_object.push_back(surfaces[i]);
+		}
+	}
+
+	/* ---- Cells */
+	cell_span.push_back(0);
+	for(vector<Cell*>::const_iterator it = cells.begin() ; it != cells.end() ; ++it) {
+		const vector<Cell::SenseSurface>& bounding = (*it)->getBoundingSurfaces();
+		for(vector<Cell::SenseSurface>::const_iterator it_sur = bounding.begin() ; it_sur != bounding.end() ; ++it_sur) {
+			size_t bit = cell_surface.size();
+			if(bit % 32 == 0) cell_sense.push_back(0);
+			if(it_sur->second) cell_sense.back() |= (1u << (bit % 32));
+			cell_surface.push_back(surface_index[it_sur->first->getInternalId()]);
+		}
+		cell_span.push_back(cell_surface.size());
+		const Universe* fill = (*it)->getFill();
+		cell_fill.push_back(fill ? fill->getInternalId() : none);
+		cell_expression.push_back((*it)->getExpression() != 0);
+	}
+
+	/* ---- Universes */
+	universe_span.push_back(0);
+	for(vector<Universe*>::const_iterator it = universes.begin() ; it != universes.end() ; ++it) {
+		const vector<Cell*>& universe_cells = (*it)->getCells();
+		for(vector<Cell*>::const_iterator it_cell = universe_cells.begin() ; it_cell != universe_cells.end() ; ++it_cell)
+			universe_cell.push_back((*it_cell)->getInternalId());
+		universe_span.push_back(universe_cell.size());
+		/* Elements of the lattice (the order of the universe cells could change) */
+		universe_locator.push_back((*it)->getLocator());
+		universe_lattice.push_back(lattice_cell.size());
+		if((*it)->getLocator())
+			for(vector<Cell*>::const_iterator it_cell = universe_cells.begin() ; it_cell != universe_cells.end() ; ++it_cell)
+				lattice_cell.push_back((*it_cell)->getInternalId());
+	}
+}
+
+bool FlatGeometry::sense(Index surface, const Coordinate& position) const {
+	/* Same evaluation done by the function of each surface */
+	switch(surface_kind[surface]) {
+	case xplane :
+		return (position[xaxis] - surface_u[surface]) >= 0;
+	case yplane :
+		return (position[yaxis] - surface_u[surface]) >= 0;
+	case zplane :
+		return (position[zaxis] - surface_u[surface]) >= 0;
+	case xcylinder : {
+		double tu = position[yaxis] - surface_u[surface];
+		double tv = position[zaxis] - surface_v[surface];
+		return (tu * tu + tv * tv - surface_radius2[surface]) >= 0;
+	}
+	case ycylinder : {
+		double tu = position[xaxis] - surface_u[surface];
+		double tv = position[zaxis] - surface_v[surface];
+		return (tu * tu + tv * tv - surface_radius2[surface]) >= 0;
+	}
+	case zcylinder : {
+		double tu = position[xaxis] - surface_u[surface];
+		double tv = position[yaxis] - surface_v[surface];
+		return (tu * tu + tv * tv - surface_radius2[surface]) >= 0;
+	}
+	case sphere :
+		return (dot(position,position) - surface_radius2[surface]) >= 0;
+	default :
+		return surface_object[surface]->sense(position);
+	}
+}
+
+bool FlatGeometry::isInside(Index cell, const Coordinate& position, Index skip, GeometryState* state) const {
+	if(cell_expression[cell]) return cells[cell]->isInside(position,(skip != none) ? surface_object[skip] : 0,state);
+	for(Index i = cell_span[cell] ; i < cell_span[cell + 1] ; ++i) {
+		Index surface = cell_surface[i];
+		if(surface == skip) continue;
+		bool cell_sense_bit = (cell_sense[i / 32] >> (i % 32)) & 1u;
+		if(sense(surface,position) != cell_sense_bit) return false;
+	}
+	return true;
+}
+
+FlatGeometry::Index FlatGeometry::findCell(Index cell, const Coordinate& position, Index skip, GeometryState* state) const {
+	if(not isInside(cell,position,skip,state)) return none;
+	if(learning) ++thread_hits.local()[cell];
+	/* We are inside the cell, check the universe that fills it */
+	if(cell_fill[cell] != none) return findUniverseCell(cell_fill[cell],position,skip,state);
+	return cell;
+}
+
+FlatGeometry::Index FlatGeometry::findUniverseCell(Index universe, const Coordinate& position, Index skip, GeometryState* state) const {
+	/* Try first with the element of the lattice that contains the point */
+	if(const LatticeLocator* locator = universe_locator[universe]) {
+		long element = locator->locate(position);
+		if(element >= 0) {
+			Index in_cell = findCell(lattice_cell[universe_lattice[universe] + element],position,skip,state);
+			if(in_cell != none) return in_cell;
+		}
+	}
+	for(Index i = universe_span[universe] ; i < universe_span[universe + 1] ; ++i) {
+		Index in_cell = findCell(universe_cell[i],position,skip,state);
+		if(in_cell != none) return in_cell;
+	}
+	return none;
+}
+
+/* Compare cells on the compiled geometry by the number of hits */
+class MoreHitsIndex {
+	const std::vector<unsigned long long>& hits;
+public:
+	MoreHitsIndex(const std::vector<unsigned long long>& hits) : hits(hits) {/* */}
+	bool operator()(FlatGeometry::Index left, FlatGeometry::Index right) const {
+		return hits[left] > hits[right];
+	}
+};
+
+void FlatGeometry::freezeOrder() {
+	/* Merge the hits counted on each thread */
+	for(ThreadHits::const_iterator it = thread_hits.begin() ; it != thread_hits.end() ; ++it)
+		for(size_t i = 0 ; i < cell_hits.size() ; ++i)
+			cell_hits[i] += (*it)[i];
+	thread_hits.clear();
+	/* Sort the cells of each universe (cells with the same hits keep the input order) */
+	for(size_t i = 0 ; i + 1 < universe_span.size() ; ++i)
+		stable_sort(universe_cell.begin() + universe_span[i], universe_cell.begin() + universe_span[i + 1], MoreHitsIndex(cell_hits));
+	learning = false;
+}
+
+bool FlatGeometry::MoreHits::operator()(const Cell* left, const Cell* right) const {
+	return flat.getHits(left->getInternalId()) > flat.getHits(right->getInternalId());
+}
+
+const Cell* FlatGeometry::findCell(const Cell* cell, const Coordinate& position, const Surface* skip, GeometryState* state) const {
+	Index in_cell = findCell(cell->getInternalId(),position,skip ? surface_index[skip->getInternalId()] : none,state);
+	return (in_cell != none) ? cells[in_cell] : 0;
+}
+
+const Cell* FlatGeometry::findCell(const Coordinate& position) const {
+	/* Start from the base universe */
+	Index in_cell = findUniverseCell(0,position);
+	return (in_cell != none) ? cells[in_cell] : 0;
+}
+
+} /* namespace Helios */
@@ -0,0 +1,173 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FLATGEOMETRY_HPP_
+#define FLATGEOMETRY_HPP_
+
+#include <vector>
+#include <limits>
+#include <tbb/enumerable_thread_specific.h>
+
+#include "../Common/Common.hpp"
+
+namespace Helios {
+
+	class Surface;
+	class Cell;
+	class Universe;
+	class GeometryState;
+	class LatticeLocator;
+
+	/*
+	 * Compiled version of the geometry used on the tracking routines. The cells, surfaces and
+	 * universes are stored on contiguous arrays indexed with 32 bits integers (the internal ID
+	 * of each object), so the cell search doesn't have to chase pointers through the objects:
+	 *
+	 *  - Each cell has a span on the container of bounding surfaces and a bit mask with the
+	 *    sense of each one of them.
+	 *  - Surfaces are sorted by type and the coefficients are stored on structure of arrays.
+	 *  - Universes have a span on the container of cells, and each cell the universe that fills it.
+	 *  - Lattice universes find the element that contains a point with arithmetic, before
+	 *    checking the rest of the cells.
+	 *
+	 * Cells defined with an expression of half-spaces (unions or complements) are evaluated with
+	 * the cell object, using the senses known on the geometry state of the particle.
+	 *
+	 * The object model (Cell, Surface and Universe) is still used to setup the problem and on
+	 * any other query about the geometry.
+	 *
+	 * Until the order is frozen, the compiled geometry counts how many times each cell contains
+	 * the point searched. When the order is frozen, the cells of each universe are sorted with the
+	 * most visited ones first (the cell found on a search doesn't depend on the order).
+	 */
+	class FlatGeometry {
+
+	public:
+
+		/* Index used on the compiled geometry */
+		typedef InternalId Index;
+
+		/* Value used for a null index */
+		static const Index none;
+
+		FlatGeometry(const std::vector<Surface*>& surfaces, const std::vector<Cell*>& cells, const std::vector<Universe*>& universes);
+
+		/* Check if a point is inside a cell (skipping the sense of some surface) */
+		bool isInside(Index cell, const Coordinate& position, Index skip = none, GeometryState* state = 0) const;
+
+		/* Find the cell (on the deepest level) that contains a point, starting from a cell */
+		Index findCell(Index cell, const Coordinate& position, Index skip = none, GeometryState* state = 0) const;
+
+		/* Find the cell (on the deepest level) that contains a point, starting from an universe */
+		Index findUniverseCell(Index universe, const Coordinate& position, Index skip = none, GeometryState* state = 0) const;
+
+		/* Same searches with the objects of the geometry (return NULL if the point is not inside) */
+		const Cell* findCell(const Cell* cell, const Coordinate& position, const Surface* skip = 0, GeometryState* state = 0) const;
+		const Cell* findCell(const Coordinate& position) const;
+
+		/* Get the cell object of some index */
+		const Cell* getCell(Index cell) const {return cells[cell];}
+
+		/* Number of times a point was found inside a cell (merged from all the threads when the order is frozen) */
+		unsigned long long getHits(Index cell) const {return cell_hits[cell];}
+
+		/* Sort the cells of each universe by the number of hits and stop counting */
+		void freezeOrder();
+
+		/* Compare cells by the number of hits (most visited first) */
+		class MoreHits {
+			const FlatGeometry& flat;
+		public:
+			MoreHits(const FlatGeometry& flat) : flat(flat) {/* */}
+			bool operator()(const Cell* left, const Cell* right) const;
+		};
+
+		~FlatGeometry() {/* */}
+
+	private:
+
+		/* Prevent copy */
+		FlatGeometry(const FlatGeometry& flat);
+		FlatGeometry& operator=(const FlatGeometry& flat);
+
+		/* Type of each surface (surfaces are sorted with this order) */
+		enum Kind {xplane, yplane, zplane, xcylinder, ycylinder, zcylinder, sphere, generic};
+
+		/* Sense of a point respect to a surface (on the compiled index) */
+		bool sense(Index surface, const Coordinate& position) const;
+
+		/* ---- Surfaces (sorted by kind) */
+
+		/* Kind of each surface */
+		std::vector<unsigned char> surface_kind;
+		/* Coefficients of each surface (plane coordinate or axis of the cylinder, and squared radius) */
+		std::vector<double> surface_u;
+		std::vector<double> surface_v;
+		std::vector<double> surface_radius2;
+		/* Surface object (only used on surfaces without specialized evaluation) */
+		std::vector<const Surface*> surface_object;
+		/* Position of the surfaces on the compiled container (indexed with the internal ID) */
+		std::vector<Index> surface_index;
+
+		/* ---- Cells */
+
+		/* Span of the bounding surfaces of each cell : [cell_span[i], cell_span[i+1]) */
+		std::vector<Index> cell_span;
+		/* Bounding surfaces of all the cells */
+		std::vector<Index> cell_surface;
+		/* Sense of each bounding surface (bit mask on 32 bits words) */
+		std::vector<unsigned int> cell_sense;
+		/* Universe that fills each cell */
+		std::vector<Index> cell_fill;
+		/* Flag for cells defined with an expression */
+		std::vector<bool> cell_expression;
+		/* Cell objects */
+		std::vector<const Cell*> cells;
+		/* Number of times a point was found inside each cell, counted on each thread (no shared cache lines) */
+		typedef tbb::enumerable_thread_specific<std::vector<unsigned long long> > ThreadHits;
+		mutable ThreadHits thread_hits;
+		/* Hits of all the threads, merged when the order is frozen */
+		std::vector<unsigned long long> cell_hits;
+		/* Flag to count the hits on each cell */
+		bool learning;
+
+		/* ---- Universes */
+
+		/* Span of the cells of each universe : [universe_span[i], universe_span[i+1]) */
+		std::vector<Index> universe_span;
+		/* Cells of all the universes */
+		std::vector<Index> universe_cell;
+		/* Locator of the elements of each universe (NULL if the universe is not a lattice) */
+		std::vector<const LatticeLocator*> universe_locator;
+		/* Position of the first element of each lattice on the container of elements */
+		std::vector<Index> universe_lattice;
+		/* Cells of each lattice, on the order of the elements */
+		std::vector<Index> lattice_cell;
+	};
+
+} /* namespace Helios */
+#endif /* FLATGEOMETRY_HPP_ */
@@ -25,9 +25,12 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cmath>
+
 #include "GeometricFeature.hpp"
 #include "Universe.hpp"
 #include "Surfaces/PlaneNormal.hpp"
+#include "Surfaces/Plane.hpp"
 
 using namespace std;
 
@@ -39,6 +42,8 @@ GeometricFeature::GeometricFeature(const FeatureObject* definition) : feature(de
 GeometricFeature* FeatureFactory::createFeature(const FeatureObject* definition) const {
 	if(definition->getFeature() == "lattice")
 		return new Lattice(definition);
+	if(definition->getFeature() == "mesh")
+		return new Mesh(definition);
 	return 0;
 }
 
@@ -217,11 +222,117 @@ static void gen2DLattice(const LatticeObject& new_lat,std::vector<SurfaceObject*
 	}
 }
 
+/* Name of each family of faces of an hexagonal lattice */
+static const char hex_family[3] = {'u','v','w'};
+
+template<int orientation>
+/*
+ * Generation of an hexagonal lattice on the x-y plane (stacked along the z axis). Each element is
+ * defined with the 6 planes of the faces of the hexagon. The faces of a row of elements are on the
+ * same plane, so each plane is created once and shared by all the elements on the row.
+ */
+static void genHexLattice(const LatticeObject& new_lat,std::vector<SurfaceObject*>& sur_def,
+		                  std::vector<CellObject*>& cell_def) {
+
+	/* Get dimension and pitch */
+	vector<int> dimension = new_lat.getDimension();
+	vector<double> pitch = new_lat.getWidth();
+	/* Get universes to fill each cell */
+	vector<UniverseId> universes = new_lat.getUniverses();
+	/* Get lattice id */
+	UniverseId latt_id = new_lat.getUserFeatureId();
+
+	long n1 = dimension[0];
+	long n2 = dimension[1];
+	long nz = (dimension.size() > 2) ? dimension[2] : 1;
+	double height = (pitch.size() > 1) ? pitch[1] : 0.0;
+	HexagonalLocator lattice((HexagonalLocator::Orientation)orientation,n1,n2,pitch[0],nz,height);
+
+	/* Normals of the faces (pointing to the neighbors along each axis of the lattice) */
+	Direction normal[3];
+	normal[0] = lattice.getFirstAxis() / pitch[0];
+	normal[1] = lattice.getSecondAxis() / pitch[0];
+	normal[2] = (lattice.getSecondAxis() - lattice.getFirstAxis()) / pitch[0];
+	/* Center of the element (0,0) */
+	Coordinate origin = lattice.getCenter(0,0,0);
+
+	/*
+	 * The faces of each family are on the planes : normal * (x - origin) = key * pitch / 2. The
+	 * key of the center of an element is an integer between -n1 and 2 * (n1 + n2).
+	 */
+	long shift = n1 + 1;
+	vector<map<long,SurfaceObject*> > faces(3);
+	for(long j = 0 ; j < n2 ; j++) {
+		for(long i = 0 ; i < n1 ; i++) {
+			Coordinate relative = lattice.getCenter(i,j,0) - origin;
+			for(int f = 0 ; f < 3 ; f++) {
+				long key = (long) floor(2.0 * dot(normal[f], relative) / pitch[0] + 0.5);
+				for(long side = key - 1 ; side <= key + 1 ; side += 2) {
+					if(faces[f].find(side) != faces[f].end()) continue;
+					vector<double> coeff;
+					coeff.push_back(normal[f][0]);
+					coeff.push_back(normal[f][1]);
+					coeff.push_back(0.0);
+					coeff.push_back(dot(normal[f], origin) + side * pitch[0] / 2.0);
+					SurfaceId face_id = toString(latt_id) + "[" + hex_family[f] + "," + toString(side + shift) + "]";
+					SurfaceObject* new_surface = new SurfaceObject(face_id,Plane().getName(),coeff);
+					faces[f][side] = new_surface;
+					sur_def.push_back(new_surface);
+				}
+			}
+		}
+	}
+
+	/* Planes between layers */
+	vector<SurfaceObject*> z_surfaces;
+	if(height > 0.0) {
+		for(long k = 0 ; k <= nz ; k++) {
+			vector<double> coeff;
+			coeff.push_back(-nz * height / 2.0 + k * height);
+			SurfaceId layer_id = toString(latt_id) + "[z," + toString(k) + "]";
+			SurfaceObject* new_surface = new SurfaceObject(layer_id,PlaneNormal<zaxis>().getName(),coeff);
+			z_surfaces.push_back(new_surface);
+			sur_def.push_back(new_surface);
+		}
+	}
+
+	size_t uni_count = 0;
+	/* Now create each cell of the lattice (left to right, top to bottom and then each layer from the bottom) */
+	for(long k = 0 ; k < nz ; k++) {
+		for(long j = n2 - 1 ; j >= 0 ; j--) {
+			for(long i = 0 ; i < n1 ; i++) {
+				Coordinate center = lattice.getCenter(i,j,k);
+				Coordinate relative = lattice.getCenter(i,j,0) - origin;
+				std::string surfs = "";
+				for(int f = 0 ; f < 3 ; f++) {
+					long key = (long) floor(2.0 * dot(normal[f], relative) / pitch[0] + 0.5);
+					surfs += faces[f][key - 1]->getUserSurfaceId() + " ";
+					surfs += "-" + faces[f][key + 1]->getUserSurfaceId() + " ";
+				}
+				if(height > 0.0) {
+					surfs += z_surfaces[k]->getUserSurfaceId() + " ";
+					surfs += "-" + z_surfaces[k + 1]->getUserSurfaceId() + " ";
+				}
+
+				/* Translate the cell to the center of the element */
+				Transformation transf(center);
+				CellId lattice_id = toString(latt_id) + "[" + toString(i) + "," + toString(j) + "," + toString(k) + "]";
+				cell_def.push_back(new CellObject(lattice_id,surfs,Cell::NONE,latt_id,universes[uni_count],Material::NONE,transf));
+
+				/* Get next universe */
+				uni_count++;
+			}
+		}
+	}
+}
+
 static map<string,Lattice::Constructor> initLatticeConstructorTable() {
 	map<string,Lattice::Constructor> m;
 	m["x-y"] = gen2DLattice<zaxis>;
 	m["y-z"] = gen2DLattice<xaxis>;
 	m["x-z"] = gen2DLattice<yaxis>;
+	m["hex-flat"] = genHexLattice<HexagonalLocator::FLAT>;
+	m["hex-pointy"] = genHexLattice<HexagonalLocator::POINTY>;
 	return m;
 }
 
@@ -234,7 +345,8 @@ Lattice::Lattice(const FeatureObject* definition) : GeometricFeature(definition)
 	/* We know the definition is a LatticeObject */
 	const LatticeObject* new_lat = dynamic_cast<const LatticeObject*>(definition);
 
-	/* Get dimension and pitch */
+	/* Get type, dimension and pitch */
+	type = new_lat->getType();
 	dimension = new_lat->getDimension();
 	pitch = new_lat->getWidth();
 	/* Get universes to fill each cell */
@@ -243,9 +355,17 @@ Lattice::Lattice(const FeatureObject* definition) : GeometricFeature(definition)
 
 	/* ...and do some generic error checking */
 	if(dimension.size() > 3) throw Universe::BadUniverseCreation(latt_id,"Dimension of the lattice is bigger than 3");
-	if(pitch.size() > 3) throw Universe::BadUniverseCreation(latt_id,"You put more than 3 pitch values for the lattice");
-	if(pitch.size() != dimension.size())
-		throw Universe::BadUniverseCreation(latt_id,"Pitch and dimension arrays aren't of the same size");
+	if(isHexagonal()) {
+		/* Elements on each axis of the lattice (and layers), with the flat to flat distance (and height of each layer) */
+		if(dimension.size() < 2)
+			throw Universe::BadUniverseCreation(latt_id,"An hexagonal lattice needs the number of elements on each axis (and optionally the number of layers)");
+		if(pitch.size() != dimension.size() - 1)
+			throw Universe::BadUniverseCreation(latt_id,"An hexagonal lattice needs the flat to flat pitch (and the height of each layer for 3 dimensions)");
+	} else {
+		if(pitch.size() > 3) throw Universe::BadUniverseCreation(latt_id,"You put more than 3 pitch values for the lattice");
+		if(pitch.size() != dimension.size())
+			throw Universe::BadUniverseCreation(latt_id,"Pitch and dimension arrays aren't of the same size");
+	}
 	if(pitch.size() == 0)
 		throw Universe::BadUniverseCreation(latt_id,"You need to put at least one value on the pitch and dimension arrays of the lattice");
 
@@ -282,4 +402,109 @@ void Lattice::createFeature(const FeatureObject* featureObject,
 	(*it_const).second(*new_lat,surfaceObject,cellObject);
 }
 
+LatticeLocator* Lattice::createLocator() const {
+	if(type == "hex-flat" || type == "hex-pointy") {
+		HexagonalLocator::Orientation orientation = (type == "hex-flat") ? HexagonalLocator::FLAT : HexagonalLocator::POINTY;
+		long nz = (dimension.size() > 2) ? dimension[2] : 1;
+		double height = (pitch.size() > 1) ? pitch[1] : 0.0;
+		return new HexagonalLocator(orientation,dimension[0],dimension[1],pitch[0],nz,height);
+	}
+	if(dimension.size() != 2) return 0;
+	if(type == "x-y") return new RectangularLocator(zaxis,dimension[0],dimension[1],pitch[0],pitch[1]);
+	if(type == "y-z") return new RectangularLocator(xaxis,dimension[0],dimension[1],pitch[0],pitch[1]);
+	if(type == "x-z") return new RectangularLocator(yaxis,dimension[0],dimension[1],pitch[0],pitch[1]);
+	return 0;
+}
+
+/* ---- Mesh stuff */
+
+/* Id of the plane of a face ("mesh[f,N]" between two elements, "mesh[b,N]" on the boundary) */
+static SurfaceId faceId(const UniverseId& mesh_id, const TetMesh::Face& face, size_t index) {
+	bool boundary = (face.element[0] < 0 || face.element[1] < 0);
+	return toString(mesh_id) + (boundary ? "[b," : "[f,") + toString(index) + "]";
+}
+
+Mesh::Mesh(const FeatureObject* definition) : GeometricFeature(definition), mesh(0) {
+
+	/* We know the definition is a MeshObject */
+	const MeshObject* new_mesh = dynamic_cast<const MeshObject*>(definition);
+	UniverseId mesh_id = new_mesh->getUserFeatureId();
+	materials = new_mesh->getMaterials();
+
+	try {
+		mesh = new TetMesh(new_mesh->getFile());
+	} catch(TetMesh::BadMesh& error) {
+		throw Universe::BadUniverseCreation(mesh_id,error.what());
+	}
+
+	/* Check the materials of the blocks */
+	if((size_t)mesh->getBlocks() > materials.size()) {
+		int nblocks = mesh->getBlocks();
+		delete mesh;
+		throw Universe::BadUniverseCreation(mesh_id,
+		"Invalid number of materials in mesh (blocks = " + toString(nblocks) + " ; input = " + toString(materials.size()) + ")");
+	}
+}
+
+void Mesh::createFeature(const FeatureObject* featureObject,
+                         std::vector<SurfaceObject*>& surfaceObject,
+		                 std::vector<CellObject*>& cellObject) const {
+
+	UniverseId mesh_id = featureObject->getUserFeatureId();
+
+	/* The mesh is a universe itself, so it can't be defined with an id of an existent universe */
+	for(vector<CellObject*>::const_iterator it_cell = cellObject.begin() ; it_cell != cellObject.end() ; ++it_cell) {
+		if(mesh_id == (*it_cell)->getUniverse())
+			throw Universe::BadUniverseCreation(mesh_id,"Duplicated id. You can't use the id of a existent universe to define a mesh");
+	}
+
+	/*
+	 * One plane for each face of the mesh. The planes of the faces on the boundary are replaced by the
+	 * surfaces of the cell filled with the mesh when the universe is created.
+	 */
+	const vector<TetMesh::Face>& faces = mesh->getFaces();
+	vector<SurfaceId> face_ids(faces.size());
+	for(size_t f = 0 ; f < faces.size() ; ++f) {
+		face_ids[f] = faceId(mesh_id,faces[f],f);
+		vector<double> coeff;
+		for(int j = 0 ; j < 3 ; ++j)
+			coeff.push_back(faces[f].normal[j]);
+		coeff.push_back(faces[f].distance);
+		surfaceObject.push_back(new SurfaceObject(face_ids[f],Plane().getName(),coeff));
+	}
+
+	/* Each element on the side of its faces where the opposite node is (on the same order of the file) */
+	const vector<TetMesh::Tetrahedron>& elements = mesh->getElements();
+	for(size_t e = 0 ; e < elements.size() ; ++e) {
+		const TetMesh::Tetrahedron& tet = elements[e];
+		std::string surfs = "";
+		for(int i = 0 ; i < 4 ; ++i)
+			surfs += (tet.sense[i] ? "" : "-") + face_ids[tet.face[i]] + " ";
+		CellId element_id = toString(mesh_id) + "[" + toString(e) + "]";
+		cellObject.push_back(new CellObject(element_id,surfs,Cell::NONE,mesh_id,Universe::BASE,materials[tet.block],Transformation()));
+	}
+}
+
+void Mesh::getBoundaryFaces(const FeatureObject* featureObject, BoundaryFaces& boundary) const {
+	UniverseId mesh_id = featureObject->getUserFeatureId();
+	const vector<TetMesh::Face>& faces = mesh->getFaces();
+	const vector<TetMesh::Tetrahedron>& elements = mesh->getElements();
+	const vector<Coordinate>& nodes = mesh->getNodes();
+	for(size_t f = 0 ; f < faces.size() ; ++f) {
+		long element = std::max(faces[f].element[0], faces[f].element[1]);
+		if(faces[f].element[0] >= 0 && faces[f].element[1] >= 0) continue;
+		vector<Coordinate>& face = boundary[faceId(mesh_id,faces[f],f)];
+		for(int i = 0 ; i < 3 ; ++i)
+			face.push_back(nodes[faces[f].node[i]]);
+		/* The node of the element that is not on the face */
+		const TetMesh::Tetrahedron& tet = elements[element];
+		for(int i = 0 ; i < 4 ; ++i)
+			if(tet.face[i] == (long)f) face.push_back(nodes[tet.node[i]]);
+	}
+}
+
+LatticeLocator* Mesh::createLocator() const {
+	return new MeshLocator(*mesh);
+}
+
 } /* namespace Helios */
@@ -36,11 +36,14 @@
 #include "Surface.hpp"
 #include "../Common/Common.hpp"
 #include "GeometryObject.hpp"
+#include "LatticeLocator.hpp"
+#include "TetMesh.hpp"
 
 namespace Helios {
 
 	class FeatureObject;
 	class LatticeObject;
+	class MeshObject;
 
 	/*
 	 * A geometric feature is a collection of geometry entities that conform a complex
@@ -67,6 +70,20 @@ namespace Helios {
 								   std::vector<SurfaceObject*>& surfaceObject,
 								   std::vector<CellObject*>& cellObject) const = 0;
 
+		/*
+		 * Create the object that finds the element of the feature that contains a point (the
+		 * caller owns the pointer). Returns NULL if the feature doesn't have one.
+		 */
+		virtual LatticeLocator* createLocator() const {return 0;}
+
+		/*
+		 * Faces created by the feature that should be on the surfaces of the cell filled with it (the
+		 * particle leaves the feature through the parent level). Each surface is mapped to the nodes of
+		 * its face followed by a point of the feature on the side of the face (on the local frame).
+		 */
+		typedef std::map<SurfaceId,std::vector<Coordinate> > BoundaryFaces;
+		virtual void getBoundaryFaces(const FeatureObject* featureObject, BoundaryFaces& faces) const {/* */}
+
 		virtual ~GeometricFeature() {/* */};
 	};
 
@@ -86,6 +103,9 @@ namespace Helios {
 						   std::vector<SurfaceObject*>& surfaceObject,
 						   std::vector<CellObject*>& cellObject) const;
 
+		/* Arithmetic lookup of the elements of the lattice */
+		LatticeLocator* createLocator() const;
+
 		virtual ~Lattice() {/* */}
 
 	private:
@@ -95,11 +115,53 @@ namespace Helios {
 		std::vector<double> pitch;
 		std::vector<UniverseId> universes;
 
+		/* Check if the lattice is made of hexagons */
+		bool isHexagonal() const {return type.compare(0,3,"hex") == 0;}
+
 		/* Map of lattices types and constructors */
 		static std::map<std::string, Constructor> constructor_table;
 
 	};
 
+	/*
+	 * Unstructured mesh of tetrahedrons. Each element is a cell of the mesh universe bounded by
+	 * the planes of its faces, with the material of its block. The plane of a face is shared by
+	 * the two elements on each side, so the particle walks from one element to the other through
+	 * the neighbors of the face. The faces on the boundary of the mesh should be on the surfaces of
+	 * the cell filled with it (the mesh covers the cell, as a lattice does) : the elements are bounded
+	 * by those surfaces and the particle leaves the mesh through the parent level. A mesh that doesn't
+	 * cover the cell is rejected when the geometry is built.
+	 */
+	class Mesh : public GeometricFeature {
+
+	public:
+
+		/* Read the mesh file */
+		Mesh(const FeatureObject* definition);
+
+		void createFeature(const FeatureObject* featureObject,
+						   std::vector<SurfaceObject*>& surfaceObject,
+						   std::vector<CellObject*>& cellObject) const;
+
+		/* Search of the element with a tree of boxes */
+		LatticeLocator* createLocator() const;
+
+		/* Faces on the boundary of the mesh (with the opposite node of the element) */
+		void getBoundaryFaces(const FeatureObject* featureObject, BoundaryFaces& faces) const;
+
+		virtual ~Mesh() {delete mesh;}
+
+	private:
+
+		/* Prevent copy */
+		Mesh(const Mesh& other);
+		Mesh& operator=(const Mesh& other);
+
+		TetMesh* mesh;
+		/* Material of each block */
+		std::vector<MaterialId> materials;
+	};
+
 	class FeatureObject : public GeometryObject {
 
 	protected:
@@ -150,6 +212,25 @@ namespace Helios {
 		~LatticeObject() {/* */}
 	};
 
+	class MeshObject : public FeatureObject {
+		std::string file;
+		std::vector<MaterialId> materials;
+	public:
+
+		MeshObject(const UniverseId& userMeshId, const std::string& file, const std::vector<MaterialId>& materials) :
+			FeatureObject("mesh",userMeshId), file(file), materials(materials) {/* */}
+
+		std::string getFile() const {
+			return file;
+		}
+
+		std::vector<MaterialId> getMaterials() const {
+			return materials;
+		}
+
+		~MeshObject() {/* */}
+	};
+
 	class FeatureFactory {
 
 	public:
@@ -27,11 +27,13 @@
 
 #include <cstdlib>
 #include <set>
+#include <algorithm>
 
 #include "Surface.hpp"
 #include "Cell.hpp"
 #include "Universe.hpp"
 #include "GeometricFeature.hpp"
+#include "Surfaces/Macrobody.hpp"
 #include "../Environment/McEnvironment.hpp"
 #include "Geometry.hpp"
 
@@ -48,12 +50,13 @@ static void pushObject(McObject* geo, std::vector<T*>& definition) {
 	definition.push_back(dynamic_cast<T*>(geo));
 }
 
-Geometry::Geometry(const std::vector<McObject*>& definitions, const McEnvironment* environment) : McModule(name(),environment) {
+Geometry::Geometry(const std::vector<McObject*>& definitions, const McEnvironment* environment) :
+		McModule(name(),environment), paths_built(false), flat_geometry(0) {
 	Log::bok() << "Initializing Geometry Module " << Log::endl;
 
 	/* Initialize object maps */
-	object_maps[Cell::name()] = ObjectMap(&cell_path_map,&cell_reverse_map,&cell_internal_map);
-	object_maps[Surface::name()] = ObjectMap(&surface_path_map,&surface_reverse_map,&surface_internal_map);
+	object_maps[Cell::name()] = ObjectMap(&cell_paths,&cell_reverse_map,&cell_internal_map);
+	object_maps[Surface::name()] = ObjectMap(&surface_paths,&surface_reverse_map,&surface_internal_map);
 
 	/* Objects */
 	vector<SurfaceObject*> surObjects;
@@ -89,6 +92,11 @@ Geometry::Geometry(const std::vector<McObject*>& definitions, const McEnvironmen
 			/* Create a lattice factory */
 			GeometricFeature* feature = feature_factory.createFeature(*it);
 			feature->createFeature((*it),surFeatureObject,cellFeatureObject);
+			/* Save the arithmetic lookup of the elements, if any */
+			LatticeLocator* locator = feature->createLocator();
+			if(locator) lattice_locators[(*it)->getUserFeatureId()] = locator;
+			/* Surfaces that should be merged with the ones of the filled cell */
+			feature->getBoundaryFaces(*it,feature_boundaries);
 			delete feature;
 		}
 	}
@@ -142,6 +150,19 @@ Geometry::Geometry(const std::vector<McObject*>& definitions, const McEnvironmen
 
 	addUniverse((*u_cells.begin()).first,u_cells,user_surfaces);
 
+	/* Each lattice universe has its own copy of the locator */
+	map<UniverseId,LatticeLocator*>::iterator it_locator = lattice_locators.begin();
+	for(; it_locator != lattice_locators.end() ; ++it_locator)
+		delete (*it_locator).second;
+	lattice_locators.clear();
+	feature_boundaries.clear();
+
+	/* Check the values defined for each instance of the cells */
+	checkInstances(cellObjects);
+
+	/* Link the surfaces on periodic boundaries */
+	setupPeriodicSurfaces(surObjects);
+
 	/* Print general information */
 	Log::msg() << left << Log::ident(1) << " - Total number of surfaces : " << surfaces.size() << Log::endl;
 	Log::msg() << left << Log::ident(1) << " - Total number of cells    : " << cells.size() << Log::endl;
@@ -158,6 +179,9 @@ Geometry::Geometry(const std::vector<McObject*>& definitions, const McEnvironmen
 		setupMaterials(*materials);
 	/* ... if not, just continue and hope the best */
 
+	/* Compile the geometry for the tracking routines */
+	flat_geometry = new FlatGeometry(surfaces,cells,universes);
+
 	/* Clean surfaces */
 	map<SurfaceId,Surface*>::iterator it_user = user_surfaces.begin();
 	for(; it_user != user_surfaces.end() ; ++it_user)
@@ -168,9 +192,73 @@ Geometry::Geometry(const std::vector<McObject*>& definitions, const McEnvironmen
 	purgePointers(surFeatureObject);
 }
 
-Surface* Geometry::addSurface(const Surface* surface, const ParentCell& parent_cell, const std::string& surf_id) {
-	/* Create the new duplicated surface */
-	Surface* new_surface = parent_cell.getTransformation()(surface);
+/* Get the only instance of a surface used on a periodic boundary */
+Surface* Geometry::getPeriodicSurface(const SurfaceId& id) const {
+	map<SurfaceId, vector<InternalSurfaceId> >::const_iterator it_id = surface_internal_map.find(id);
+	if(it_id == surface_internal_map.end())
+		throw Surface::BadSurfaceCreation(id,"Periodic surface is not used on any cell");
+	if((*it_id).second.size() != 1)
+		throw Surface::BadSurfaceCreation(id,"Periodic surface should be used only on the base universe (it is replicated on the geometry)");
+	return surfaces[(*it_id).second[0]];
+}
+
+void Geometry::setupPeriodicSurfaces(const vector<SurfaceObject*>& definitions) {
+	for(vector<SurfaceObject*>::const_iterator it_sur = definitions.begin() ; it_sur != definitions.end() ; ++it_sur) {
+		SurfaceId pair_id = (*it_sur)->getPeriodicPair();
+		Surface::SurfaceInfo flags = (*it_sur)->getFlags();
+		if(not (flags & (Surface::PERIODIC | Surface::ROTATIONAL))) {
+			if(pair_id.size() != 0)
+				throw Surface::BadSurfaceCreation((*it_sur)->getUserSurfaceId(),"Paired surface " + pair_id + " on a non-periodic boundary");
+			continue;
+		}
+		if(pair_id.size() == 0) continue;
+		/* Link both surfaces (the paired one gets the same boundary condition) */
+		Surface* surface = getPeriodicSurface((*it_sur)->getUserSurfaceId());
+		Surface* pair = getPeriodicSurface(pair_id);
+		if(surface == pair)
+			throw Surface::BadSurfaceCreation(pair_id,"A periodic surface can't be paired with itself");
+		pair->setFlags(flags);
+		surface->setPeriodicPair(pair);
+		pair->setPeriodicPair(surface);
+	}
+	/* Check that all the periodic surfaces were paired */
+	for(vector<Surface*>::const_iterator it_sur = surfaces.begin() ; it_sur != surfaces.end() ; ++it_sur)
+		if(((*it_sur)->getFlags() & (Surface::PERIODIC | Surface::ROTATIONAL)) && not (*it_sur)->getPeriodicPair())
+			throw Surface::BadSurfaceCreation((*it_sur)->getUserId(),"Periodic surface without a pair");
+}
+
+const Geometry::ObjectMap& Geometry::getObjectMap(const std::string& name) const {
+	tbb::spin_mutex::scoped_lock lock(paths_mutex);
+	if(not paths_built) {
+		buildPaths();
+		paths_built = true;
+	}
+	return object_maps.find(name)->second;
+}
+
+/* Full path of an object, from the path of the parent cell */
+static inline UserId fullPath(const UserId& id, const Cell* parent, const vector<CellId>& cell_paths) {
+	if(parent) return id + "<" + cell_paths[parent->getInternalId()];
+	return id;
+}
+
+void Geometry::buildPaths() const {
+	/* Parent cells are always created before the cells inside them */
+	cell_paths.resize(cells.size());
+	for(size_t i = 0 ; i < cells.size() ; ++i) {
+		cell_paths[i] = fullPath(cells[i]->getUserId(),cell_parent[i],cell_paths);
+		cell_reverse_map[cell_paths[i]] = i;
+	}
+	surface_paths.resize(surfaces.size());
+	for(size_t i = 0 ; i < surfaces.size() ; ++i) {
+		surface_paths[i] = fullPath(surfaces[i]->getUserId(),surface_parent[i],cell_paths);
+		surface_reverse_map[surface_paths[i]] = i;
+	}
+}
+
+Surface* Geometry::addSurface(const Surface* surface, const ParentCell& parent_cell, bool& flipped) {
+	/* Create the new duplicated surface (maybe with the opposite sense) */
+	Surface* new_surface = parent_cell.getTransformation()(surface,flipped);
 
 	/* Check if the surface is not duplicated */
 	vector<Surface*>::const_iterator it_sur = parent_cell.getSurfaces().begin();
@@ -183,17 +271,10 @@ Surface* Geometry::addSurface(const Surface* surface, const ParentCell& parent_c
 
 	/* Set internal / unique index */
 	new_surface->setInternalId(surfaces.size());
-	/* Update surface map */
-    SurfaceId new_surf_id;
-    if(parent_cell.getId().size() == 0) new_surf_id = surf_id;
-    else new_surf_id = surf_id + "<" + parent_cell.getId();
-
-    /* Update path map */
-    surface_path_map[new_surface->getInternalId()] = new_surf_id;
-    /* Update internal map */
-    surface_internal_map[surf_id].push_back(new_surface->getInternalId());
-    /* Update reverse map */
-    surface_reverse_map[new_surf_id] = new_surface->getInternalId();
+	/* Update internal map */
+	surface_internal_map[new_surface->getUserId()].push_back(new_surface->getInternalId());
+	/* The path is built from the parent cell (if needed) */
+	surface_parent.push_back(parent_cell.getCell());
 
 	/* Push the surface into the container */
 	surfaces.push_back(new_surface);
@@ -202,6 +283,85 @@ Surface* Geometry::addSurface(const Surface* surface, const ParentCell& parent_c
 	return new_surface;
 }
 
+/* Tolerance to find a face on a surface (relative to the size of the face) */
+static const double boundary_tolerance = 1e-6;
+
+/* Check if a surface is a plane */
+static bool isPlane(const Surface* surface) {
+	vector<double> coeffs;
+	surface->getQuadric(coeffs);
+	for(int i = 0 ; i < 6 ; ++i)
+		if(coeffs[i] != 0.0) return false;
+	return (coeffs[6] != 0.0) || (coeffs[7] != 0.0) || (coeffs[8] != 0.0);
+}
+
+Surface* Geometry::getBoundarySurface(const UniverseId& uni_def, const Surface* surface, const vector<Coordinate>& face,
+		                              const ParentCell& parent_cell, bool& flipped) const {
+	/* Nodes and center of the face on the frame of the filled cell */
+	const Transformation& transformation = parent_cell.getTransformation();
+	vector<Coordinate> points;
+	for(size_t i = 0 ; i < 3 ; ++i)
+		points.push_back(transformation.toParent(face[i]));
+	points.push_back((points[0] + points[1] + points[2]) / 3.0);
+	/* A point inside the feature on the side of the face (the other point given could be on another surface) */
+	Coordinate local_inside = (face[0] + face[1] + face[2] + face[3]) / 4.0;
+	Coordinate inside = transformation.toParent(local_inside);
+	/* Size of the face */
+	double size = 0.0;
+	for(size_t i = 0 ; i < 3 ; ++i) {
+		Direction edge(points[i] - points[(i + 1) % 3]);
+		size = max(size,sqrt(dot(edge,edge)));
+	}
+
+	/*
+	 * The nodes and the center of the face should be on the surface. Planes are valid on both sides,
+	 * and macrobodies (convex) only if the feature is inside of them : the element bounded by the
+	 * surface instead of the plane of the face is the same one.
+	 */
+	const vector<Surface*>& parent_surfaces = parent_cell.getSurfaces();
+	for(vector<Surface*>::const_iterator it_sur = parent_surfaces.begin() ; it_sur != parent_surfaces.end() ; ++it_sur) {
+		bool on_surface = true;
+		for(size_t i = 0 ; i < points.size() ; ++i)
+			if(fabs((*it_sur)->function(points[i])) > boundary_tolerance * size) on_surface = false;
+		if(not on_surface) continue;
+		/* Side of the surface where the feature is */
+		bool sense = (*it_sur)->sense(inside);
+		if(not isPlane(*it_sur) && (sense || not dynamic_cast<const Macrobody*>(*it_sur))) continue;
+		/* The half-spaces of the feature are defined with the plane of the face */
+		flipped = (surface->sense(local_inside) != sense);
+		return (*it_sur);
+	}
+
+	throw Universe::BadUniverseCreation(uni_def,"The face " + toString(surface->getUserId()) +
+			" on the boundary of the feature is not on the surfaces of the filled cell (the feature should cover the cell)");
+}
+
+/* Value of some instance of a cell (the same value for all the instances if only one is defined) */
+template<class T>
+static const T& instanceValue(const std::vector<T>& values, size_t instance) {
+	return values[std::min(instance, values.size() - 1)];
+}
+
+void Geometry::checkInstances(const vector<CellObject*>& definitions) const {
+	for(vector<CellObject*>::const_iterator it_cell = definitions.begin() ; it_cell != definitions.end() ; ++it_cell) {
+		size_t ninstances = getInstances((*it_cell)->getUserCellId());
+		size_t nmaterials = (*it_cell)->getMaterials().size();
+		size_t ntemperatures = (*it_cell)->getTemperatures().size();
+		if(nmaterials != 1 && nmaterials != ninstances)
+			throw Cell::BadCellCreation((*it_cell)->getUserCellId(),"The number of materials (" + toString(nmaterials) +
+					") doesn't match the number of instances of the cell (" + toString(ninstances) + ")");
+		if(ntemperatures > 1 && ntemperatures != ninstances)
+			throw Cell::BadCellCreation((*it_cell)->getUserCellId(),"The number of temperatures (" + toString(ntemperatures) +
+					") doesn't match the number of instances of the cell (" + toString(ninstances) + ")");
+	}
+}
+
+size_t Geometry::getInstances(const CellId& id) const {
+	map<CellId, vector<InternalCellId> >::const_iterator it_id = cell_internal_map.find(id);
+	if(it_id == cell_internal_map.end()) return 0;
+	return (*it_id).second.size();
+}
+
 Universe* Geometry::addUniverse(const UniverseId& uni_def, const map<UniverseId,vector<CellObject*> >& u_cells,
 		                        const map<SurfaceId,Surface*>& user_surfaces, const ParentCell& parent_cell) {
 
@@ -218,17 +378,19 @@ Universe* Geometry::addUniverse(const UniverseId& uni_def, const map<UniverseId,
 	if(it_uni_cells == u_cells.end()) return 0;
 
 	/* Get the cell of this level */
-	vector<CellObject*> cell_def = (*it_uni_cells).second;
+	const vector<CellObject*>& cell_def = (*it_uni_cells).second;
 
 	/* Add each cell of this universe */
-	vector<CellObject*>::iterator it_cell = cell_def.begin();
+	vector<CellObject*>::const_iterator it_cell = cell_def.begin();
     map<SurfaceId,Surface*> temp_sur_map;
+    /* Surfaces created with the opposite sense, the half-spaces on the cells are flipped */
+    set<SurfaceId> flipped_surfaces;
 
 	for(; it_cell != cell_def.end() ; ++it_cell) {
 
 		/* Cell information */
 		CellId user_cell_id((*it_cell)->getUserCellId());
-		vector<SurfaceId> surfaces_id = CellFactory::getSurfacesIds((*it_cell)->getSurfacesExpression());
+		const vector<SurfaceId>& surfaces_id = (*it_cell)->getSurfacesIds();
 
 		/* Now get the surfaces and put the references inside the cell */
 	    vector<Surface*> bounding_surfaces;
@@ -251,8 +413,15 @@ Universe* Geometry::addUniverse(const UniverseId& uni_def, const map<UniverseId,
 	    		/* The surface is created */
 	    		new_surface = (*it_temp_sur).second;
 	    	else {
-	    		new_surface = addSurface((*it_sur).second,parent_cell,user_surface_id);
+	    		bool flipped = false;
+	    		/* The boundary of a feature should be on the surfaces of the filled cell */
+	    		GeometricFeature::BoundaryFaces::const_iterator it_face = feature_boundaries.find(user_surface_id);
+	    		if(it_face != feature_boundaries.end())
+	    			new_surface = getBoundarySurface(uni_def,(*it_sur).second,(*it_face).second,parent_cell,flipped);
+	    		else
+	    			new_surface = addSurface((*it_sur).second,parent_cell,flipped);
 		    	temp_sur_map[user_surface_id] = new_surface;
+		    	if(flipped) flipped_surfaces.insert(user_surface_id);
 	    	}
 
 	    	/* Push it into the container */
@@ -260,23 +429,24 @@ Universe* Geometry::addUniverse(const UniverseId& uni_def, const map<UniverseId,
 	    }
 
 	    /* Now we can construct the cell */
-	    Cell* new_cell = cell_factory.createCell((*it_cell),temp_sur_map);
-	    /* Get new cell ID based on the parent cell */
-	    CellId cell_id;
-	    if(parent_cell.getId().size() == 0) cell_id = (*it_cell)->getUserCellId();
-	    else cell_id = (*it_cell)->getUserCellId() + "<" + parent_cell.getId();
+	    Cell* new_cell = cell_factory.createCell((*it_cell),temp_sur_map,flipped_surfaces);
 		/* Set internal / unique index */
 	    new_cell->setInternalId(cells.size());
 
-	    /* Update cell map */
-	    cell_path_map[new_cell->getInternalId()] = cell_id;
 	    /* Update internal map */
-	    cell_internal_map[(*it_cell)->getUserCellId()].push_back(new_cell->getInternalId());
-	    /* Update reverse map */
-	    cell_reverse_map[cell_id] = new_cell->getInternalId();
-
+	    vector<InternalCellId>& instances = cell_internal_map[(*it_cell)->getUserCellId()];
+	    instances.push_back(new_cell->getInternalId());
+	    /* The path is built from the parent cell (if needed) */
+	    cell_parent.push_back(parent_cell.getCell());
+
+	    /* Instances of the same cell are numbered on the order they are created */
+	    size_t instance = instances.size() - 1;
+	    new_cell->setInstance(instance);
 	    /* Update material map */
-	    material_map[new_cell->getInternalId()] = (*it_cell)->getMatId();
+	    cell_materials.push_back(instanceValue((*it_cell)->getMaterials(),instance));
+	    /* Temperature of this instance (if any) */
+	    if((*it_cell)->getTemperatures().size() != 0)
+	    	new_cell->setTemperature(instanceValue((*it_cell)->getTemperatures(),instance));
 	    /* Push the cell into the container */
 	    cells.push_back(new_cell);
 	    /* Link this cell with the new universe */
@@ -297,7 +467,7 @@ Universe* Geometry::addUniverse(const UniverseId& uni_def, const map<UniverseId,
 	    	/* Propagate the transformation... */
 	    	Transformation new_transformation = parent_cell.getTransformation() + (*it_cell)->getTransformation();
 	    	/* ... and create a new Parent Cell */
-	    	ParentCell new_parent(new_transformation,bounding_surfaces,cell_id);
+	    	ParentCell new_parent(new_transformation,bounding_surfaces,new_cell);
 
 	    	/* Create recursively the other universes */
 	    	Universe* fill_universe = addUniverse(fill_universe_id,u_cells,user_surfaces,new_parent);
@@ -310,6 +480,11 @@ Universe* Geometry::addUniverse(const UniverseId& uni_def, const map<UniverseId,
 	    }
 	}
 
+	/* Lattices find their elements with arithmetic, on the frame of the parent cell */
+	map<UniverseId,LatticeLocator*>::const_iterator it_locator = lattice_locators.find(uni_def);
+	if(it_locator != lattice_locators.end())
+		new_universe->setLocator((*it_locator).second->transformate(parent_cell.getTransformation()));
+
 	/* Return the universe */
 	return new_universe;
 }
@@ -334,13 +509,12 @@ std::vector<Surface*> Geometry::getContainer<Surface>(const std::vector<Internal
 }
 
 void Geometry::setupMaterials(const Materials& materials) {
-	/* Iterate over each material on the map */
-	map<InternalCellId, MaterialId>::const_iterator it_mat = material_map.begin();
-	for(; it_mat != material_map.end() ; ++it_mat) {
+	/* Iterate over each cell */
+	for(size_t i = 0 ; i < cells.size() ; ++i) {
 		/* Get cell */
-		Cell* cell = cells[(*it_mat).first];
+		Cell* cell = cells[i];
 		/* Get material ID */
-		MaterialId matId = (*it_mat).second;
+		const MaterialId& matId = cell_materials[i];
 		if(matId != Material::NONE && matId != Material::VOID) {
 			try {
 				cell->setMaterial(materials.getMaterial(matId));
@@ -363,7 +537,16 @@ void Geometry::print(std::ostream& out) const {
 		out << *(*it_uni);
 }
 
+void Geometry::freezeCellOrder() {
+	/* Universes on the compiled geometry */
+	flat_geometry->freezeOrder();
+	/* Neighbors of each surface */
+	for(vector<Surface*>::iterator it = surfaces.begin() ; it != surfaces.end() ; ++it)
+		(*it)->sortNeighborCells(FlatGeometry::MoreHits(*flat_geometry));
+}
+
 Geometry::~Geometry() {
+	delete flat_geometry;
 	purgePointers(surfaces);
 	purgePointers(cells);
 	purgePointers(universes);
@@ -29,15 +29,18 @@
 #define GEOMETRY_HPP_
 
 #include <vector>
+#include <set>
 #include <ostream>
 #include <string>
 #include <boost/tokenizer.hpp>
+#include <tbb/spin_mutex.h>
 
 #include "Surface.hpp"
 #include "Cell.hpp"
 #include "Universe.hpp"
 #include "GeometricFeature.hpp"
 #include "GeometryObject.hpp"
+#include "FlatGeometry.hpp"
 #include "../Material/Materials.hpp"
 #include "../Common/Common.hpp"
 
@@ -81,6 +84,17 @@ namespace Helios {
 		const std::vector<Surface*>& getSurfaces() const {return surfaces;};
 		/* Get all cells */
 		const std::vector<Cell*>& getCells() const {return cells;};
+		/* Get the number of instances of a cell (replicas of the cell on each universe where it is) */
+		size_t getInstances(const CellId& id) const;
+		/* Get the compiled geometry used on the tracking routines */
+		const FlatGeometry* getFlatGeometry() const {return flat_geometry;}
+
+		/*
+		 * Sort the cells searched on the tracking routines (cells of each universe and neighbors
+		 * of each surface) by the number of times a particle was found inside them, and freeze
+		 * that order. Should be called when no particle is being tracked.
+		 */
+		void freezeCellOrder();
 
 		/* Print cell with each surface of the geometry */
 		void print(std::ostream& out) const;
@@ -121,25 +135,29 @@ namespace Helios {
 
 		/* Template to hold maps from different object */
 		class ObjectMap {
-			/* This map an internal ID with the full path of a object */
-			const std::map<InternalId,UserId>* path_map;
+			/* Full path of each object (indexed with the internal ID) */
+			const std::vector<UserId>* paths;
 			/* This map the full path of a object with the internal ID */
 			const std::map<UserId, InternalId>* reverse_map;
 			/* This map the original object ID with all the internal objects IDs */
 			const std::map<UserId, std::vector<InternalId> >* internal_map;
 		public:
 			ObjectMap() {/**/}
-			ObjectMap(const std::map<InternalId,UserId>* path_map, const std::map<UserId, InternalId>* reverse_map,
+			ObjectMap(const std::vector<UserId>* paths, const std::map<UserId, InternalId>* reverse_map,
 					  const std::map<UserId, std::vector<InternalId> >* internal_map) :
-					  path_map(path_map), reverse_map(reverse_map), internal_map(internal_map) {/* */}
+					  paths(paths), reverse_map(reverse_map), internal_map(internal_map) {/* */}
 			~ObjectMap() {/* */}
 			const std::map<UserId, std::vector<InternalId> >& getInternalMap() const {return *internal_map;}
-			const std::map<InternalId, UserId>& getPathMap() const {return *path_map;}
+			const std::vector<UserId>& getPaths() const {return *paths;}
 			const std::map<UserId, InternalId>& getReverseMap() const {return *reverse_map;}
 		};
 
 		/* Map of Object */
 		std::map<std::string,ObjectMap> object_maps;
+		/* Get the maps of some object (the paths are built on the first call) */
+		const ObjectMap& getObjectMap(const std::string& name) const;
+		/* Build the full path of each cell and surface */
+		void buildPaths() const;
 
 		/* Container of surfaces defined on the problem */
 		std::vector<Surface*> surfaces;
@@ -147,22 +165,42 @@ namespace Helios {
 		std::vector<Cell*> cells;
 		/* Container of universes */
 		std::vector<Universe*> universes;
+		/* Compiled version of the geometry */
+		FlatGeometry* flat_geometry;
+		/* Locator of the elements of each lattice (only used while the universes are created) */
+		std::map<UniverseId,LatticeLocator*> lattice_locators;
+		/* Faces of the features that should be on the surfaces of the filled cells (only used while the universes are created) */
+		GeometricFeature::BoundaryFaces feature_boundaries;
+
+		/*
+		 * The full paths of the objects ("id<parent<grandparent...") are only needed to answer queries from
+		 * the user, so they are built on the first query from the parent cell of each object.
+		 */
+
+		/* Mutex to build the paths */
+		mutable tbb::spin_mutex paths_mutex;
+		/* Flag if the paths were built */
+		mutable bool paths_built;
 
 		/* ----- Map surfaces */
 
-		/* This map an internal ID with the full path of a surface */
-		std::map<InternalSurfaceId,SurfaceId> surface_path_map;
+		/* Parent cell of each surface (NULL on the base universe) */
+		std::vector<const Cell*> surface_parent;
+		/* Full path of each surface */
+		mutable std::vector<SurfaceId> surface_paths;
 		/* This map the full path of a surface with the internal ID */
-		std::map<SurfaceId, InternalSurfaceId> surface_reverse_map;
+		mutable std::map<SurfaceId, InternalSurfaceId> surface_reverse_map;
 		/* This map the original surface ID with all the internal surfaces IDs */
 		std::map<SurfaceId, std::vector<InternalSurfaceId> > surface_internal_map;
 
 		/* ----- Map cells */
 
-		/* This map an internal ID with the full path of a cell */
-		std::map<InternalCellId,CellId> cell_path_map;
-		/* This map the full path of a surface with the internal ID */
-		std::map<CellId, InternalCellId> cell_reverse_map;
+		/* Parent cell of each cell (NULL on the base universe) */
+		std::vector<const Cell*> cell_parent;
+		/* Full path of each cell */
+		mutable std::vector<CellId> cell_paths;
+		/* This map the full path of a cell with the internal ID */
+		mutable std::map<CellId, InternalCellId> cell_reverse_map;
 		/* This map the original cell ID with all the internal cells IDs */
 		std::map<CellId, std::vector<InternalCellId> > cell_internal_map;
 
@@ -171,8 +209,8 @@ namespace Helios {
 		/* This map the original universe ID with all the internal universes IDs */
 		std::map<UniverseId, std::vector<InternalUniverseId> > universe_map;
 
-		/* Map of cell to materials IDs */
-		std::map<InternalCellId, MaterialId> material_map;
+		/* Material ID of each cell (indexed with the internal ID) */
+		std::vector<MaterialId> cell_materials;
 
 		/* Get container of objects given the INTERNAL cells id */
 		template<class Object>
@@ -182,13 +220,13 @@ namespace Helios {
 		class ParentCell {
 			Transformation transformation;
 			std::vector<Surface*> parent_surfaces;
-			std::string id;
+			const Cell* cell;
 		public:
-			ParentCell() : transformation(), parent_surfaces(), id() {/* */}
-			ParentCell(const Transformation& transformation, const std::vector<Surface*>& parent_surfaces, const std::string& id) :
-				transformation(transformation), parent_surfaces(parent_surfaces), id(id) {/* */}
-			const std::string& getId() const {return id;}
-			void setId(std::string id) {this->id = id;}
+			ParentCell() : transformation(), parent_surfaces(), cell(0) {/* */}
+			ParentCell(const Transformation& transformation, const std::vector<Surface*>& parent_surfaces, const Cell* cell) :
+				transformation(transformation), parent_surfaces(parent_surfaces), cell(cell) {/* */}
+			/* Parent cell (NULL on the base universe) */
+			const Cell* getCell() const {return cell;}
 			const std::vector<Surface*>& getSurfaces() const {return parent_surfaces;}
 			void setSurfaces(std::vector<Surface*> surfaces) {this->parent_surfaces = surfaces;}
 			const Transformation& getTransformation() const {return transformation;}
@@ -200,8 +238,17 @@ namespace Helios {
 		Universe* addUniverse(const UniverseId& uni_def, const std::map<UniverseId,std::vector<CellObject*> >& u_cells,
 				              const std::map<SurfaceId,Surface*>& user_surfaces, const ParentCell& parent_cell = ParentCell());
 
+		/* Check that the materials and temperatures of each cell are defined for all the instances */
+		void checkInstances(const std::vector<CellObject*>& definitions) const;
+		/* Link the surfaces on periodic boundaries with their pairs */
+		void setupPeriodicSurfaces(const std::vector<SurfaceObject*>& definitions);
+		/* Get the only instance of a surface used on a periodic boundary */
+		Surface* getPeriodicSurface(const SurfaceId& id) const;
 		/* Add a surface to the geometry, prior to check duplicated ones. */
-		Surface* addSurface(const Surface* surface, const ParentCell& parent_cell, const std::string& surf_id);
+		Surface* addSurface(const Surface* surface, const ParentCell& parent_cell, bool& flipped);
+		/* Surface of the filled cell where a face on the boundary of a feature is (the sense is flipped if needed) */
+		Surface* getBoundarySurface(const UniverseId& uni_def, const Surface* surface, const std::vector<Coordinate>& face,
+				                    const ParentCell& parent_cell, bool& flipped) const;
 
 		/* ---- Material information */
 
@@ -223,25 +270,19 @@ namespace Helios {
 
 	template<class Object>
 	UserId Geometry::getPath(const Object* object) const {
-		/* Get the internal ID */
-		InternalId internal = object->getInternalId();
-		std::map<InternalId,UserId> path_map = object_maps.find(Object::name())->second.getPathMap();
-		std::map<InternalId,UserId>::const_iterator it = path_map.find(internal);
-		/* This is the full path of this cell */
-		return (*it).second;
+		/* This is the full path of this object */
+		return getObjectMap(Object::name()).getPaths()[object->getInternalId()];
 	}
 
 	template<class Object>
 	std::vector<Object*> Geometry::getObject(const UserId& orig_id) const {
 		std::string id(orig_id);
 		id.erase(std::remove_if(id.begin(), id.end(),::isspace), id.end());
-		/* Get maps */
-		std::map<UserId,InternalId> reverse_map = object_maps.find(Object::name())->second.getReverseMap();
-		std::map<UserId,std::vector<InternalId> > internal_map = object_maps.find(Object::name())->second.getInternalMap();
 		/* Detect if is a full path (only one cell) or a group of cells */
 		if(id.find("<") != std::string::npos) {
 			/* One specific cell */
-			std::map<UserId,InternalId>::iterator it = reverse_map.find(id);
+			const std::map<UserId,InternalId>& reverse_map = getObjectMap(Object::name()).getReverseMap();
+			std::map<UserId,InternalId>::const_iterator it = reverse_map.find(id);
 			if(it != reverse_map.end()) {
 				std::vector<InternalId> internal_ids;
 				internal_ids.push_back(it->second);
@@ -252,10 +293,10 @@ namespace Helios {
 		}
 		else {
 			/* Group of objects (or a object on top level) */
+			const std::map<UserId,std::vector<InternalId> >& internal_map = object_maps.find(Object::name())->second.getInternalMap();
 			std::map<UserId,std::vector<InternalId> >::const_iterator it = internal_map.find(id);
 			if(it != internal_map.end()) {
-				std::vector<InternalId> internal_ids = (*it).second;
-				return getContainer<Object>(internal_ids);
+				return getContainer<Object>((*it).second);
 			} else
 				throw GeometryError(Object::name() + " " + id + " does not exist");
 		}
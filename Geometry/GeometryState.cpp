@@ -0,0 +1,98 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "GeometryState.hpp"
+#include "Cell.hpp"
+#include "Universe.hpp"
+#include "Surface.hpp"
+
+using namespace std;
+
+namespace Helios {
+
+GeometryState::GeometryState(const FlatGeometry* flat_geometry) :
+	flat_geometry(flat_geometry), direction(0,0,0), origin(0,0,0), crossed_surface(0), crossed_sense(false), crossed_position(0,0,0) {/* */}
+
+void GeometryState::reset() {
+	levels.clear();
+	crossed_surface = 0;
+	crossed_sense = false;
+}
+
+void GeometryState::intersectParents(const Cell* cell, const Coordinate& position, const Direction& new_direction,
+		                             Surface*& surface, bool& sense, double& distance) {
+	/* Distances are only valid along the same direction, start a new track */
+	if(not sameVector(direction,new_direction)) {
+		direction = new_direction;
+		origin = position;
+		levels.clear();
+	}
+
+	/* Distance traveled since the origin of the track */
+	double track = dot(position - origin, direction);
+
+	/* Get the parent cells (from the bottom to the top) */
+	path.clear();
+	for(const Cell* parent_cell = cell->getParent()->getParent() ; parent_cell ; parent_cell = parent_cell->getParent()->getParent())
+		path.push_back(parent_cell);
+
+	/* Levels below the parents of this cell are not valid anymore */
+	size_t nlevels = path.size();
+	levels.resize(nlevels);
+
+	surface = 0;
+	sense = false;
+	distance = std::numeric_limits<double>::infinity();
+
+	/* Check from the top, as the recursive intersection does */
+	for(size_t i = 0 ; i < nlevels ; ++i) {
+		const Cell* level_cell = path[nlevels - i - 1];
+		LevelDistance& level = levels[i];
+		if(level.cell != level_cell) {
+			/* New cell on this level, get the closest surface */
+			level.cell = level_cell;
+			level.surface = 0;
+			level.sense = false;
+			double new_distance = std::numeric_limits<double>::infinity();
+			level_cell->intersectSurfaces(position, direction, level.surface, level.sense, new_distance);
+			level.distance = new_distance + track;
+		}
+		double level_distance = level.distance - track;
+		if(level_distance < distance) {
+			distance = level_distance;
+			surface = level.surface;
+			sense = level.sense;
+		}
+	}
+}
+
+void GeometryState::setCrossed(const Surface* surface, const bool& sense, const Coordinate& position) {
+	crossed_surface = surface;
+	crossed_sense = sense;
+	crossed_position = position;
+}
+
+} /* namespace Helios */
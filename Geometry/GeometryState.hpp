@@ -0,0 +1,135 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef GEOMETRYSTATE_HPP_
+#define GEOMETRYSTATE_HPP_
+
+#include <vector>
+#include <limits>
+
+#include "../Common/Common.hpp"
+#include "Surface.hpp"
+
+namespace Helios {
+
+	class Cell;
+	class Surface;
+	class FlatGeometry;
+
+	/*
+	 * Geometric state of a particle in flight. It carries the cell at each nesting level
+	 * (with the distance to the boundary of that level along the current direction), the
+	 * last surface crossed and the position where it was crossed. If the state is created with
+	 * a compiled geometry, the cell searches are done on it.
+	 *
+	 * The cached data is validated against the position and direction passed on each call,
+	 * so the transport routines only have to keep one state object per history.
+	 */
+	class GeometryState {
+
+	public:
+
+		GeometryState(const FlatGeometry* flat_geometry = 0);
+
+		/*
+		 * Get the nearest surface on the parent levels of a cell (i.e. the cells that contain the
+		 * universe where the cell is). Distances on each level are reused until the direction changes.
+		 */
+		void intersectParents(const Cell* cell, const Coordinate& position, const Direction& direction,
+				              Surface*& surface, bool& sense, double& distance);
+
+		/*
+		 * Sense of a point respect to a surface. The sense of the last surface crossed is known
+		 * at the crossing point, any other surface is evaluated.
+		 */
+		bool sense(const Surface* surface, const Coordinate& position) const {
+			if(surface == crossed_surface && sameVector(position,crossed_position))
+				return not crossed_sense;
+			return surface->sense(position);
+		}
+
+		/* Set the last surface crossed (sense is the one of the cell we are leaving) */
+		void setCrossed(const Surface* surface, const bool& sense, const Coordinate& position);
+		/* Get last surface crossed (NULL if any) */
+		const Surface* getCrossedSurface() const {return crossed_surface;}
+		/* Get the sense of the cell we leave when crossing the last surface */
+		bool getCrossedSense() const {return crossed_sense;}
+
+		/* Compiled geometry used to search cells (NULL if the objects should be used) */
+		const FlatGeometry* getFlatGeometry() const {return flat_geometry;}
+
+		/* Number of parent levels on the state */
+		size_t getLevels() const {return levels.size();}
+		/* Get the cell on some level (0 is the cell on the base universe) */
+		const Cell* getCell(size_t level) const {return levels[level].cell;}
+
+		/* Forget all the cached information */
+		void reset();
+
+		~GeometryState() {/* */}
+
+	private:
+
+		/* Cached intersection of a parent cell */
+		struct LevelDistance {
+			LevelDistance() : cell(0), surface(0), sense(false), distance(std::numeric_limits<double>::infinity()) {/* */}
+			/* Cell on this level */
+			const Cell* cell;
+			/* Closest surface of the cell along the direction */
+			Surface* surface;
+			/* Sense of the cell respect to that surface */
+			bool sense;
+			/* Distance to the surface measured from the origin of the track */
+			double distance;
+		};
+
+		/* Compiled geometry */
+		const FlatGeometry* flat_geometry;
+		/* Cells and distances on each level (0 is the base universe) */
+		std::vector<LevelDistance> levels;
+		/* Auxiliary container to walk up on the geometry */
+		std::vector<const Cell*> path;
+		/* Direction used to calculate the distances */
+		Direction direction;
+		/* Origin of the track, distances on each level are measured from here */
+		Coordinate origin;
+
+		/* Last surface crossed */
+		const Surface* crossed_surface;
+		/* Sense of the cell we leave when crossing that surface */
+		bool crossed_sense;
+
+		/* Position where the last surface was crossed */
+		Coordinate crossed_position;
+
+		/* Check if two tiny vectors are exactly the same */
+		static bool sameVector(const Coordinate& a, const Coordinate& b) {
+			return (a[0] == b[0]) && (a[1] == b[1]) && (a[2] == b[2]);
+		}
+	};
+
+} /* namespace Helios */
+#endif /* GEOMETRYSTATE_HPP_ */
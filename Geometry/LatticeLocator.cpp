@@ -0,0 +1,254 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "LatticeLocator.hpp"
+
+using namespace std;
+
+namespace Helios {
+
+/* Element of a row of a lattice (or -1 outside the lattice) */
+static inline long getElement(double position, double width, long number) {
+	long element = (long) floor(position / width);
+	if(element < 0 || element >= number) return -1;
+	return element;
+}
+
+long RectangularLocator::locateLocal(const Coordinate& position) const {
+	/* Same coordinates used on the generation of the lattice */
+	double u, v;
+	switch(axis) {
+	case xaxis :
+		u = position[yaxis]; v = position[zaxis];
+		break;
+	case yaxis :
+		u = position[zaxis]; v = position[xaxis];
+		break;
+	default :
+		u = position[xaxis]; v = position[yaxis];
+		break;
+	}
+	long j = getElement(u + nu * pu / 2, pu, nu);
+	long i = getElement(v + nv * pv / 2, pv, nv);
+	if(j < 0 || i < 0) return -1;
+	/* Rows are generated from top to bottom */
+	return (nv - 1 - i) * nu + j;
+}
+
+HexagonalLocator::HexagonalLocator(Orientation orientation, long n1, long n2, double pitch, long nz, double height) :
+		n1(n1), n2(n2), nz(nz), height(height) {
+	double half_root = sqrt(3.0) / 2.0;
+	if(orientation == POINTY) {
+		a1[0] = pitch;       a1[1] = 0.0;
+		a2[0] = pitch / 2.0; a2[1] = pitch * half_root;
+	} else {
+		a1[0] = pitch * half_root; a1[1] = pitch / 2.0;
+		a2[0] = 0.0;               a2[1] = pitch;
+	}
+	/* The lattice is centered on the origin */
+	for(int i = 0 ; i < 2 ; ++i)
+		origin[i] = -((n1 - 1) * a1[i] + (n2 - 1) * a2[i]) / 2.0;
+	bottom = -nz * height / 2.0;
+}
+
+Coordinate HexagonalLocator::getCenter(long i, long j, long k) const {
+	double z = (height > 0.0) ? bottom + (k + 0.5) * height : 0.0;
+	return Coordinate(origin[0] + i * a1[0] + j * a2[0], origin[1] + i * a1[1] + j * a2[1], z);
+}
+
+long HexagonalLocator::locateLocal(const Coordinate& position) const {
+	/* Coordinates on the axis of the lattice */
+	double d0 = position[xaxis] - origin[0];
+	double d1 = position[yaxis] - origin[1];
+	double det = a1[0] * a2[1] - a1[1] * a2[0];
+	double q = (d0 * a2[1] - d1 * a2[0]) / det;
+	double r = (a1[0] * d1 - a1[1] * d0) / det;
+	double s = -q - r;
+	/* Round to the nearest center (on cube coordinates, the three of them should add to zero) */
+	double rq = floor(q + 0.5), rr = floor(r + 0.5), rs = floor(s + 0.5);
+	double dq = fabs(rq - q), dr = fabs(rr - r), ds = fabs(rs - s);
+	if(dq > dr && dq > ds) rq = -rr - rs;
+	else if(dr > ds) rr = -rq - rs;
+
+	long i = (long) rq;
+	long j = (long) rr;
+	if(i < 0 || i >= n1 || j < 0 || j >= n2) return -1;
+
+	/* Layer */
+	long k = 0;
+	if(height > 0.0) {
+		k = getElement(position[zaxis] - bottom, height, nz);
+		if(k < 0) return -1;
+	}
+
+	/* Rows are generated from top to bottom on each layer */
+	return k * n1 * n2 + (n2 - 1 - j) * n1 + i;
+}
+
+/* Maximum number of elements on a leaf of the tree */
+static const long leaf_elements = 4;
+
+/* Distance out of the boundary of a mesh to consider a point on the boundary */
+static const double on_boundary = 1e-10;
+
+/* Compare the center of the box of two elements along some axis */
+class CenterLess {
+	const std::vector<Coordinate>& lower;
+	const std::vector<Coordinate>& upper;
+	int axis;
+public:
+	CenterLess(const std::vector<Coordinate>& lower, const std::vector<Coordinate>& upper, int axis) :
+		lower(lower), upper(upper), axis(axis) {/* */}
+	bool operator()(long left, long right) const {
+		return lower[left][axis] + upper[left][axis] < lower[right][axis] + upper[right][axis];
+	}
+};
+
+void MeshLocator::build(Tree& tree, vector<long>& elements, const vector<Coordinate>& lower,
+		                const vector<Coordinate>& upper, long first, long last) {
+	/* Box around the elements, and around their centers */
+	Node node;
+	Coordinate center_lower, center_upper;
+	for(int j = 0 ; j < 3 ; ++j) {
+		node.lower[j] = center_lower[j] = numeric_limits<double>::max();
+		node.upper[j] = center_upper[j] = -numeric_limits<double>::max();
+	}
+	for(long i = first ; i < last ; ++i) {
+		long e = elements[i];
+		for(int j = 0 ; j < 3 ; ++j) {
+			node.lower[j] = min(node.lower[j], lower[e][j]);
+			node.upper[j] = max(node.upper[j], upper[e][j]);
+			double center = (lower[e][j] + upper[e][j]) / 2.0;
+			center_lower[j] = min(center_lower[j], center);
+			center_upper[j] = max(center_upper[j], center);
+		}
+	}
+
+	long index = tree.nodes.size();
+	if(last - first <= leaf_elements) {
+		node.offset = first;
+		node.count = last - first;
+		tree.nodes.push_back(node);
+		return;
+	}
+
+	/* Split at the median of the longest axis of the centers */
+	int axis = 0;
+	for(int j = 1 ; j < 3 ; ++j)
+		if(center_upper[j] - center_lower[j] > center_upper[axis] - center_lower[axis]) axis = j;
+	long middle = (first + last) / 2;
+	nth_element(elements.begin() + first, elements.begin() + middle, elements.begin() + last, CenterLess(lower,upper,axis));
+
+	node.count = 0;
+	tree.nodes.push_back(node);
+	build(tree,elements,lower,upper,first,middle);
+	tree.nodes[index].offset = tree.nodes.size();
+	build(tree,elements,lower,upper,middle,last);
+}
+
+MeshLocator::MeshLocator(const TetMesh& mesh) {
+	const vector<Coordinate>& nodes = mesh.getNodes();
+	const vector<TetMesh::Tetrahedron>& tets = mesh.getElements();
+	const vector<TetMesh::Face>& faces = mesh.getFaces();
+
+	/* Box around each element */
+	long nelements = tets.size();
+	vector<Coordinate> lower(nelements), upper(nelements);
+	for(long e = 0 ; e < nelements ; ++e) {
+		lower[e] = nodes[tets[e].node[0]];
+		upper[e] = nodes[tets[e].node[0]];
+		for(int i = 1 ; i < 4 ; ++i) {
+			const Coordinate& node = nodes[tets[e].node[i]];
+			for(int j = 0 ; j < 3 ; ++j) {
+				lower[e][j] = min(lower[e][j], node[j]);
+				upper[e][j] = max(upper[e][j], node[j]);
+			}
+		}
+	}
+
+	Tree* new_tree = new Tree;
+	new_tree->elements.resize(nelements);
+	for(long e = 0 ; e < nelements ; ++e)
+		new_tree->elements[e] = e;
+	build(*new_tree,new_tree->elements,lower,upper,0,nelements);
+
+	/* Planes of the faces, on the order of the leaves */
+	new_tree->faces.reserve(4 * nelements);
+	for(long i = 0 ; i < nelements ; ++i) {
+		const TetMesh::Tetrahedron& tet = tets[new_tree->elements[i]];
+		for(int j = 0 ; j < 4 ; ++j) {
+			Face face;
+			face.normal = faces[tet.face[j]].normal;
+			face.distance = faces[tet.face[j]].distance;
+			face.sense = tet.sense[j];
+			face.boundary = (faces[tet.face[j]].element[0] < 0 || faces[tet.face[j]].element[1] < 0);
+			new_tree->faces.push_back(face);
+		}
+	}
+	tree.reset(new_tree);
+}
+
+long MeshLocator::locateLocal(const Coordinate& position) const {
+	const vector<Node>& nodes = tree->nodes;
+	/* Nodes to visit */
+	long stack[64];
+	long nstack = 0;
+	stack[nstack++] = 0;
+	while(nstack > 0) {
+		long index = stack[--nstack];
+		const Node& node = nodes[index];
+		bool outside = false;
+		for(int j = 0 ; j < 3 ; ++j)
+			if(position[j] < node.lower[j] - on_boundary || position[j] > node.upper[j] + on_boundary) outside = true;
+		if(outside) continue;
+		if(node.count == 0) {
+			stack[nstack++] = node.offset;
+			stack[nstack++] = index + 1;
+			continue;
+		}
+		/* Check the elements on the leaf (with the same senses of the cells) */
+		for(long i = node.offset ; i < node.offset + node.count ; ++i) {
+			const Face* face = &tree->faces[4 * i];
+			bool inside = true;
+			for(int j = 0 ; j < 4 && inside ; ++j) {
+				double value = dot(face[j].normal, position) - face[j].distance;
+				if(face[j].boundary)
+					inside = face[j].sense ? (value >= -on_boundary) : (value < on_boundary);
+				else
+					inside = ((value >= 0) == face[j].sense);
+			}
+			if(inside) return tree->elements[i];
+		}
+	}
+	return -1;
+}
+
+} /* namespace Helios */
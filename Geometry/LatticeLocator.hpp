@@ -0,0 +1,191 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LATTICELOCATOR_HPP_
+#define LATTICELOCATOR_HPP_
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "Transformation.hpp"
+#include "TetMesh.hpp"
+#include "../Common/Common.hpp"
+
+namespace Helios {
+
+	/*
+	 * Arithmetic lookup of the element of a lattice that contains a point. The elements are
+	 * the cells of the lattice universe, on the same order they were generated by the feature.
+	 * Each clone of the lattice universe has its own locator, on the frame of the parent cell.
+	 */
+	class LatticeLocator {
+
+	public:
+
+		LatticeLocator() {/* */}
+
+		/* Index of the element that contains a point (or -1 if the point is outside the lattice) */
+		long locate(const Coordinate& position) const {
+			return locateLocal(frame.toLocal(position));
+		}
+
+		/* Clone the locator on the frame of a parent cell */
+		virtual LatticeLocator* transformate(const Transformation& transformation) const = 0;
+
+		virtual ~LatticeLocator() {/* */}
+
+	protected:
+
+		/* Index of the element that contains a point (on the frame of the lattice) */
+		virtual long locateLocal(const Coordinate& position) const = 0;
+
+		/* Transformation from the lattice frame to the global frame */
+		Transformation frame;
+	};
+
+	/* Rectangular lattice on a plane perpendicular to some axis */
+	class RectangularLocator : public LatticeLocator {
+
+		/* Axis perpendicular to the lattice */
+		int axis;
+		/* Number of elements on each direction of the plane */
+		long nu, nv;
+		/* Pitch on each direction */
+		double pu, pv;
+
+		long locateLocal(const Coordinate& position) const;
+
+	public:
+
+		RectangularLocator(int axis, long nu, long nv, double pu, double pv) :
+			axis(axis), nu(nu), nv(nv), pu(pu), pv(pv) {/* */}
+
+		LatticeLocator* transformate(const Transformation& transformation) const {
+			RectangularLocator* locator = new RectangularLocator(*this);
+			locator->frame = transformation + frame;
+			return locator;
+		}
+
+		~RectangularLocator() {/* */}
+	};
+
+	/* Hexagonal lattice on the x-y plane, with elements stacked along the z axis */
+	class HexagonalLocator : public LatticeLocator {
+
+		/* Number of elements along each axis of the lattice (and number of layers) */
+		long n1, n2, nz;
+		/* Vectors between neighbor elements */
+		double a1[2], a2[2];
+		/* Center of the element (0,0) */
+		double origin[2];
+		/* Height of each layer, and bottom of the lattice */
+		double height, bottom;
+
+		long locateLocal(const Coordinate& position) const;
+
+	public:
+
+		/* Orientation of the hexagons */
+		enum Orientation {
+			FLAT   = 0, /* Flat side on top (faces normal to the y axis) */
+			POINTY = 1  /* Vertex on top (faces normal to the x axis) */
+		};
+
+		/* Hexagons with a flat to flat distance of pitch (with nz layers of some height) */
+		HexagonalLocator(Orientation orientation, long n1, long n2, double pitch, long nz = 1, double height = 0.0);
+
+		/* Center of an element */
+		Coordinate getCenter(long i, long j, long k) const;
+		/* Vectors between neighbor elements */
+		Direction getFirstAxis() const {return Direction(a1[0],a1[1],0.0);}
+		Direction getSecondAxis() const {return Direction(a2[0],a2[1],0.0);}
+
+		LatticeLocator* transformate(const Transformation& transformation) const {
+			HexagonalLocator* locator = new HexagonalLocator(*this);
+			locator->frame = transformation + frame;
+			return locator;
+		}
+
+		~HexagonalLocator() {/* */}
+	};
+
+	/*
+	 * Elements of an unstructured mesh, found with a bounding volume hierarchy (a binary tree of boxes
+	 * around the elements). The tree is shared by all the clones of the locator. Points slightly out of
+	 * the boundary of the mesh (i.e. on the boundary of the cell filled with it) are on the closest element.
+	 */
+	class MeshLocator : public LatticeLocator {
+
+		/* Node of the tree (the left child is the next node, the leaves have a range of elements) */
+		struct Node {
+			double lower[3], upper[3];
+			/* Index of the right child (or the first element on a leaf) */
+			long offset;
+			/* Number of elements on a leaf (zero on internal nodes) */
+			long count;
+		};
+
+		/* Plane of a face of an element (the element is on the side with the sense) */
+		struct Face {
+			Direction normal;
+			double distance;
+			bool sense;
+			/* Face on the boundary of the mesh */
+			bool boundary;
+		};
+
+		struct Tree {
+			std::vector<Node> nodes;
+			/* Index of the elements sorted as they are on the leaves */
+			std::vector<long> elements;
+			/* Faces of each element (on the same order of the leaves) */
+			std::vector<Face> faces;
+		};
+
+		boost::shared_ptr<const Tree> tree;
+
+		/* Create the nodes of the tree for a range of elements */
+		static void build(Tree& tree, std::vector<long>& elements, const std::vector<Coordinate>& lower,
+				          const std::vector<Coordinate>& upper, long first, long last);
+
+		long locateLocal(const Coordinate& position) const;
+
+	public:
+
+		MeshLocator(const TetMesh& mesh);
+
+		LatticeLocator* transformate(const Transformation& transformation) const {
+			MeshLocator* locator = new MeshLocator(*this);
+			locator->frame = transformation + frame;
+			return locator;
+		}
+
+		~MeshLocator() {/* */}
+	};
+
+} /* namespace Helios */
+#endif /* LATTICELOCATOR_HPP_ */
@@ -25,17 +25,57 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cmath>
+
 #include "Surface.hpp"
 #include "Surfaces/SurfaceTypes.hpp"
 
 #include "Cell.hpp"
+#include "GeometryState.hpp"
 
 using namespace std;
 
 namespace Helios {
 
 Surface::Surface(const SurfaceObject* definition) :
-		surfid(definition->getUserSurfaceId()), flag(definition->getFlags()), int_surfid(0) {/* */}
+		surfid(definition->getUserSurfaceId()), flag(definition->getFlags()), int_surfid(0), periodic_pair(0) {/* */}
+
+/* Get the unit normal and the offset (n * x = d) of a plane from its quadric form */
+static bool planeCoefficients(const Surface* surface, Direction& vnormal, double& offset) {
+	vector<double> coeffs;
+	surface->getQuadric(coeffs);
+	for(size_t i = 0 ; i < 6 ; ++i)
+		if(fabs(coeffs[i]) > 1e-12) return false;
+	double length = sqrt(coeffs[6] * coeffs[6] + coeffs[7] * coeffs[7] + coeffs[8] * coeffs[8]);
+	if(length < 1e-12) return false;
+	vnormal = Direction(coeffs[6], coeffs[7], coeffs[8]) / length;
+	offset = -coeffs[9] / length;
+	return true;
+}
+
+void Surface::setPeriodicPair(const Surface* pair) {
+	double offset, pair_offset;
+	if(not planeCoefficients(this, periodic_normal, offset) || not planeCoefficients(pair, pair_normal, pair_offset))
+		throw BadSurfaceCreation(getUserId(),"Periodic boundaries are only supported on planes");
+	/* Cosine between both planes */
+	double cosine = dot(periodic_normal, pair_normal);
+	if(flag & PERIODIC) {
+		if(fabs(fabs(cosine) - 1.0) > 1e-10)
+			throw BadSurfaceCreation(getUserId(),"Translational periodic surface " + toString(pair->getUserId()) + " is not parallel");
+		/* A point x on this plane is mapped to x + offset * n on the other one */
+		periodic_offset = (cosine * pair_offset - offset) * periodic_normal;
+	} else if(flag & ROTATIONAL) {
+		if(fabs(periodic_normal[2]) > 1e-10 || fabs(pair_normal[2]) > 1e-10 || fabs(fabs(cosine) - 1.0) < 1e-10)
+			throw BadSurfaceCreation(getUserId(),"Rotational periodic surface " + toString(pair->getUserId()) +
+					" should be a non-parallel plane sharing an axis parallel to z");
+		/* Point on the rotation axis (where both planes intersect on the x-y plane) */
+		double det = periodic_normal[0] * pair_normal[1] - periodic_normal[1] * pair_normal[0];
+		periodic_offset = Coordinate((offset * pair_normal[1] - pair_offset * periodic_normal[1]) / det,
+				                     (pair_offset * periodic_normal[0] - offset * pair_normal[0]) / det, 0.0);
+	} else
+		throw BadSurfaceCreation(getUserId(),"Surface is not a periodic boundary");
+	periodic_pair = pair;
+}
 
 void Surface::addNeighborCell(const bool& sense, Cell* cell) {
 	if(sense)
@@ -52,18 +92,35 @@ const std::vector<Cell*>& Surface::getNeighborCell(const bool& sense) const {
 }
 
 /* Cross a surface, i.e. find next cell. Of course, this should be called on a position located on the surface */
-void Surface::cross(const Coordinate& position, const bool& sense, const Cell*& cell) const {
+void Surface::cross(const Coordinate& position, const bool& sense, const Cell*& cell, GeometryState* state) const {
+	/* Neighbors learned on the face we are leaving (if we know the cell where the particle comes from) */
+	Cell::NeighborCache* learned = cell ? cell->getNeighborCache(this) : 0;
 	/* Set to zero */
 	cell = 0;
+	/* Save the surface on the state, the sense of the new cell is known */
+	if(state) state->setCrossed(this,sense,position);
+	if(learned) {
+		/* Try first with the cells reached before through this face */
+		size_t nlearned = learned->size();
+		for(size_t i = 0 ; i < nlearned ; ++i) {
+			cell = (*learned)[i]->findCell(position,this,state);
+			if(cell) return;
+		}
+	}
+	/* Full search over the neighbors of the surface */
 	const std::vector<Cell*>& neighbor = getNeighborCell(not sense);
 	std::vector<Cell*>::const_iterator it_neighbor = neighbor.begin();
 	for( ; it_neighbor != neighbor.end() ; ++it_neighbor) {
-		cell = (*it_neighbor)->findCell(position,this);
-		if(cell) break;
+		cell = (*it_neighbor)->findCell(position,this,state);
+		if(cell) {
+			/* Remember this neighbor for the next crossing */
+			if(learned) learned->push(*it_neighbor);
+			break;
+		}
 	}
 }
 
-bool Surface::cross(Particle& particle, const bool& sense, const Cell*& cell) const {
+bool Surface::cross(Particle& particle, const bool& sense, const Cell*& cell, GeometryState* state) const {
 	/* Check reflecting surface */
 	if(getFlags() & REFLECTING) {
 		/* Get normal */
@@ -78,10 +135,53 @@ bool Surface::cross(Particle& particle, const bool& sense, const Cell*& cell) co
 	} else if (getFlags() & VACUUM) {
 		/* Reach a boundary */
 		return false;
+	} else if (getFlags() & (PERIODIC | ROTATIONAL)) {
+		Coordinate& position = particle.pos();
+		Direction& direction = particle.dir();
+		if(getFlags() & PERIODIC) {
+			/* Just translate the particle onto the paired plane */
+			position = position + periodic_offset;
+		} else {
+			/* Normal of this plane pointing into the region we are leaving */
+			Direction inward = (dot(direction, periodic_normal) > 0) ? Direction(-periodic_normal) : periodic_normal;
+			/* Half plane bounding the region on this surface (where the particle is) and on the paired one */
+			double ux = position[0] - periodic_offset[0];
+			double uy = position[1] - periodic_offset[1];
+			double ulength = sqrt(ux * ux + uy * uy);
+			double vx = -pair_normal[1];
+			double vy = pair_normal[0];
+			if(inward[0] * vx + inward[1] * vy < 0) {
+				vx = -vx;
+				vy = -vy;
+			}
+			/* Rotation around the axis that takes one half plane onto the other (the particle on the axis is not moved) */
+			double cosine = 1.0, sine = 0.0;
+			if(ulength > 0) {
+				cosine = (ux * vx + uy * vy) / ulength;
+				sine = (ux * vy - uy * vx) / ulength;
+			}
+			position[0] = periodic_offset[0] + cosine * ux - sine * uy;
+			position[1] = periodic_offset[1] + sine * ux + cosine * uy;
+			double dx = direction[0];
+			double dy = direction[1];
+			direction[0] = cosine * dx - sine * dy;
+			direction[1] = sine * dx + cosine * dy;
+		}
+		/* Sense of the paired surface on the side we come from */
+		bool pair_sense = dot(direction, pair_normal) < 0;
+		/* The cell we are leaving is not a neighbor of the paired surface */
+		cell = 0;
+		/* The particle jumped, distances to the parent levels are not valid anymore */
+		if(state) state->reset();
+		periodic_pair->cross(position,pair_sense,cell,state);
+		/* We are inside the geometry (unless some dead cell is there) */
+		if(cell && (cell->getFlag() & Cell::DEADCELL))
+			return false;
+		return true;
 	}
 
 	/* Just a normal surface, cross and get new cell*/
-	cross(particle.pos(),sense,cell);
+	cross(particle.pos(),sense,cell,state);
 
 	/* Now check if we reach a dead cell, i.e. outside the geometry */
 	if(cell) /* God save the caller if this is not true... */ {
@@ -105,6 +205,15 @@ SurfaceFactory::SurfaceFactory() {
 	registerSurface(CylinderOnAxis<yaxis>());       /* c/y - radius x z */
 	registerSurface(CylinderOnAxis<zaxis>());       /* c/z - radius x y */
 	registerSurface(SphereOnOrigin());              /* so  - radius */
+	registerSurface(Sphere());                      /* s   - x y z radius */
+	registerSurface(Sphere(),"sph");                /* sph - x y z radius */
+	registerSurface(Plane());                       /* p   - A B C D */
+	registerSurface(GeneralQuadric());              /* gq  - A B C D E F G H J K */
+	registerSurface(Box());                         /* rpp - xmin xmax ymin ymax zmin zmax */
+	registerSurface(Box(),"box");                   /* box - corner and 3 edges */
+	registerSurface(RightCircularCylinder());       /* rcc - base, height vector and radius */
+	registerSurface(HexagonalPrism());              /* rhp - base, height vector and facet vector */
+	registerSurface(HexagonalPrism(),"hex");        /* hex - base, height vector and facet vector */
 }
 
 Surface* SurfaceFactory::createSurface(const SurfaceObject* definition) const {
@@ -119,6 +228,10 @@ void SurfaceFactory::registerSurface(const Surface& surface) {
 	constructor_table[surface.getName()] = surface.constructor();
 }
 
+void SurfaceFactory::registerSurface(const Surface& surface, const std::string& alias) {
+	constructor_table[alias] = surface.constructor();
+}
+
 std::ostream& operator<<(std::ostream& out, const Surface& q) {
 	out << "surface = " << q.getUserId() << " (internal = " << q.getInternalId() << ")"
 	    << " ; type = " << q.getName() << " ; flags = " << q.getFlags() << " : ";
@@ -34,6 +34,7 @@
 #include <map>
 #include <exception>
 #include <fstream>
+#include <algorithm>
 
 #include "../Common/Common.hpp"
 #include "../Transport/Particle.hpp"
@@ -43,6 +44,7 @@ namespace Helios {
 
 	class SurfaceObject;
 	class Cell;
+	class GeometryState;
 
 	class Surface {
 
@@ -55,7 +57,9 @@ namespace Helios {
 		enum SurfaceInfo {
 			NONE       = 0,
 			REFLECTING = 1,
-			VACUUM = 2
+			VACUUM = 2,
+			PERIODIC = 4,  /* Translational periodic boundary (paired with a parallel plane) */
+			ROTATIONAL = 8 /* Rotational periodic boundary (paired with another plane containing a z-axis) */
 		};
 
 		/* Surface constructor function */
@@ -98,6 +102,12 @@ namespace Helios {
 		void addNeighborCell(const bool& sense, Cell* cell);
 		/* Get neighbor cells of this surface */
 		const std::vector<Cell*>& getNeighborCell(const bool& sense) const;
+		/* Sort the neighbor cells (keeping the relative order of equivalent cells) */
+		template<class Compare>
+		void sortNeighborCells(Compare compare) {
+			std::stable_sort(neighbor_pos.begin(), neighbor_pos.end(), compare);
+			std::stable_sort(neighbor_neg.begin(), neighbor_neg.end(), compare);
+		}
 
 		/* Return the user ID associated with this surface. */
 		const SurfaceId& getUserId() const {return surfid;}
@@ -110,11 +120,23 @@ namespace Helios {
 		/* Set different options for the surfaces */
 		void setFlags(SurfaceInfo new_flag) {flag = new_flag;}
 
+		/*
+		 * Set the surface paired with this one on a periodic boundary. Both surfaces should be planes, parallel
+		 * on a translational boundary or sharing an axis parallel to z on a rotational one.
+		 */
+		void setPeriodicPair(const Surface* pair);
+		/* Get the surface paired with this one (NULL if this is not a periodic boundary) */
+		const Surface* getPeriodicPair() const {return periodic_pair;}
+
 		/* Mathematically define a surface as a collection of points that satisfy this equation */
 		virtual double function(const Coordinate& pos) const = 0;
 
-		/* Cross a surface, i.e. find next cell. Of course, this should be called on a position located on the surface */
-		void cross(const Coordinate& position, const bool& sense, const Cell*& cell) const ;
+		/*
+		 * Cross a surface, i.e. find next cell. Of course, this should be called on a position located on the surface.
+		 * If the cell pointer is the cell we are leaving (instead of NULL), the neighbors learned on that face are
+		 * checked first. The geometry state of the particle (if any) is updated with the surface crossed.
+		 */
+		void cross(const Coordinate& position, const bool& sense, const Cell*& cell, GeometryState* state = 0) const ;
 
 		/*
 		 * Cross a surface, i.e. find next cell.
@@ -123,7 +145,9 @@ namespace Helios {
 		 * will change the phase space parameters of the particle.
 		 *
 		 * For example, if the surface is reflective, the next cell won't be searched and the
-		 * direction of the particle will be changed accordingly.
+		 * direction of the particle will be changed accordingly. On periodic boundaries, the
+		 * position (and direction) is mapped onto the paired surface and the next cell is
+		 * searched there.
 		 * Finally a boundary condition checking is done. The function will return 'false'
 		 * if the particle is getting out of the system.
 		 *
@@ -131,7 +155,7 @@ namespace Helios {
 		 * from NULL. If the Cell pointer is NULL is symptom of a geometry error
 		 * and should be correctly handled by the caller.
 		 */
-		bool cross(Particle& particle, const bool& sense, const Cell*& cell) const ;
+		bool cross(Particle& particle, const bool& sense, const Cell*& cell, GeometryState* state = 0) const ;
 
 		/*
 		 * Return a new instance of the surface translated (same flags and userId)
@@ -139,13 +163,26 @@ namespace Helios {
 		 */
 		virtual Surface* transformate(const Direction& trans) const = 0;
 
+		/*
+		 * Coefficients of the surface written as a general quadric (A B C D E F G H J K) :
+		 * A*x^2 + B*y^2 + C*z^2 + D*x*y + E*y*z + F*z*x + G*x + H*y + J*z + K
+		 * with the same sign of the surface function (used to rotate the surfaces).
+		 */
+		virtual void getQuadric(std::vector<double>& coeffs) const = 0;
+
+		/*
+		 * Return a new instance of the surface rotated and translated (x' = rotation * x + trans). Surfaces
+		 * that return NULL are rotated as a general quadric.
+		 */
+		virtual Surface* rotate(const double rotation[3][3], const Direction& trans) const {return 0;}
+
 		virtual ~Surface() {/* */};
 
 	protected:
 		/* Default, used only on factory */
-		Surface() : surfid(), flag(NONE), int_surfid(0) {/* */};
+		Surface() : surfid(), flag(NONE), int_surfid(0), periodic_pair(0) {/* */};
 		/* Constructor from id and flags */
-		Surface(const SurfaceId& surfid, const SurfaceInfo& flag) : surfid(surfid), flag(flag), int_surfid(0) {/* */};
+		Surface(const SurfaceId& surfid, const SurfaceInfo& flag) : surfid(surfid), flag(flag), int_surfid(0), periodic_pair(0) {/* */};
 		/* Create surface from user id */
 		Surface(const SurfaceObject* definition);
 		/* Prevent copy */
@@ -170,6 +207,13 @@ namespace Helios {
 		/* Neighbor cells */
 		std::vector<Cell*> neighbor_pos;
 		std::vector<Cell*> neighbor_neg;
+		/* Surface paired with this one on a periodic boundary */
+		const Surface* periodic_pair;
+		/* Unit normal of this plane and of the paired one */
+		Direction periodic_normal;
+		Direction pair_normal;
+		/* Translation onto the paired plane (translational) or point on the rotation axis (rotational) */
+		Coordinate periodic_offset;
 	};
 
 	class SurfaceObject : public GeometryObject {
@@ -177,13 +221,15 @@ namespace Helios {
 		std::string type;
 		std::vector<double> coeffs;
 		Surface::SurfaceInfo flags;
+		SurfaceId pair;
 		friend class Surface;
 	public:
 		SurfaceObject() : GeometryObject(Surface::name()) {/* */}
 		SurfaceObject(const SurfaceId& userSurfaceId, const std::string& type,
-				   const std::vector<double>& coeffs, const Surface::SurfaceInfo& flags = Surface::NONE) :
+				   const std::vector<double>& coeffs, const Surface::SurfaceInfo& flags = Surface::NONE,
+				   const SurfaceId& pair = SurfaceId()) :
 				   GeometryObject(Surface::name()), userSurfaceId(userSurfaceId), type(type),
-				   coeffs(coeffs), flags(flags) {/* */}
+				   coeffs(coeffs), flags(flags), pair(pair) {/* */}
 		std::vector<double> getCoeffs() const {
 			return coeffs;
 		}
@@ -196,6 +242,10 @@ namespace Helios {
 		Surface::SurfaceInfo getFlags() const {
 			return flags;
 		}
+		/* Surface paired with this one on a periodic boundary (empty if none) */
+		SurfaceId getPeriodicPair() const {
+			return pair;
+		}
 		~SurfaceObject() {/* */}
 	};
 
@@ -210,6 +260,8 @@ namespace Helios {
 
 		/* Register a new surface */
 		void registerSurface(const Surface& surface);
+		/* Register a new surface with another name */
+		void registerSurface(const Surface& surface, const std::string& alias);
 
 		/* Create a new surface */
 		Surface* createSurface(const SurfaceObject* definition) const;
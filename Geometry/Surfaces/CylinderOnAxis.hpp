@@ -70,11 +70,26 @@ namespace Helios {
 		void normal(const Coordinate& point, Direction& vnormal) const;
 		bool intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const;
 		Surface* transformate(const Direction& trans) const;
+		/* Coefficients as a general quadric */
+		void getQuadric(std::vector<double>& coeffs) const {
+		coeffs.assign(10, 0.0);
+		coeffs[9] = -radius * radius;
+		for(int i = 0 ; i < 3 ; i++) {
+			if(i == axis) continue;
+			coeffs[i] = 1.0;
+			coeffs[6 + i] = -2.0 * point[i];
+			coeffs[9] += point[i] * point[i];
+		}
+		}
 		/* Name of the surface */
 		std::string getName() const;
 
 		/* Evaluate function */
 		double function(const Coordinate& pos) const;
+		/* Radius of the cylinder */
+		double getRadius() const {return radius;}
+		/* Point through which the axis passes */
+		const Coordinate& getPoint() const {return point;}
 
 		/* Comparison */
 		bool compare(const Surface& sur) const {
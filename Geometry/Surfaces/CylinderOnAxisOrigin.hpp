@@ -67,10 +67,19 @@ namespace Helios {
 		void normal(const Coordinate& point, Direction& vnormal) const;
 		bool intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const;
 		Surface* transformate(const Direction& trans) const;
+		/* Coefficients as a general quadric */
+		void getQuadric(std::vector<double>& coeffs) const {
+		coeffs.assign(10, 0.0);
+		for(int i = 0 ; i < 3 ; i++)
+			if(i != axis) coeffs[i] = 1.0;
+		coeffs[9] = -radius * radius;
+		}
 		/* Name of the surface */
 		std::string getName() const;
 		/* Evaluate function */
 		double function(const Coordinate& pos) const;
+		/* Radius of the cylinder */
+		double getRadius() const {return radius;}
 
 		/* Comparison */
 		bool compare(const Surface& sur) const {
@@ -0,0 +1,91 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SurfaceUtils.hpp"
+#include "GeneralQuadric.hpp"
+
+using namespace std;
+
+namespace Helios {
+
+GeneralQuadric::GeneralQuadric(const SurfaceId& surid, const SurfaceInfo& flags, const std::vector<double>& quadric)
+	: Surface(surid,flags) {
+	copy(quadric.begin(), quadric.begin() + 10, coeffs);
+}
+
+GeneralQuadric::GeneralQuadric(const SurfaceObject* definition) : Surface(definition) {
+	/* Check number of parameters */
+	if(definition->getCoeffs().size() == 10) {
+		vector<double> quadric = definition->getCoeffs();
+		copy(quadric.begin(), quadric.end(), coeffs);
+	} else {
+		throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),
+			  "Bad number of coefficients. Expected 10 values : A B C D E F G H J K");
+	}
+}
+
+void GeneralQuadric::print(std::ostream& out) const {
+	out << "coefficients = ";
+	for(size_t i = 0 ; i < 10 ; i++)
+		out << coeffs[i] << " ";
+}
+
+void GeneralQuadric::normal(const Coordinate& point, Direction& vnormal) const {
+	gradient(point, vnormal);
+	vnormal /= sqrt(dot(vnormal, vnormal));
+}
+
+bool GeneralQuadric::intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const {
+	/* Second order term along the ray */
+	double a = dir[0]*(coeffs[0]*dir[0] + coeffs[3]*dir[1]) +
+			   dir[1]*(coeffs[1]*dir[1] + coeffs[4]*dir[2]) +
+			   dir[2]*(coeffs[2]*dir[2] + coeffs[5]*dir[0]);
+	/* Half of the derivative along the ray */
+	Direction grad;
+	gradient(pos, grad);
+	double k = 0.5 * dot(grad, dir);
+	double c = function(pos);
+	return quadraticIntersect(a,k,c,sense,distance);
+}
+
+Surface* GeneralQuadric::transformate(const Direction& trans) const {
+	/* f'(x) = f(x - t), so the linear terms are the gradient at -t and the constant term is f(-t) */
+	Coordinate origin(-trans);
+	Direction grad;
+	gradient(origin, grad);
+	vector<double> quadric(coeffs, coeffs + 10);
+	for(size_t i = 0 ; i < 3 ; i++)
+		quadric[6 + i] = grad[i];
+	quadric[9] = function(origin);
+	return new GeneralQuadric(this->getUserId(),this->getFlags(),quadric);
+}
+
+void GeneralQuadric::getQuadric(std::vector<double>& quadric) const {
+	quadric.assign(coeffs, coeffs + 10);
+}
+
+} /* namespace Helios */
@@ -0,0 +1,96 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GENERALQUADRIC_HPP_
+#define GENERALQUADRIC_HPP_
+
+#include <vector>
+
+#include "../Surface.hpp"
+
+namespace Helios {
+
+/* General quadric : A*x^2 + B*y^2 + C*z^2 + D*x*y + E*y*z + F*z*x + G*x + H*y + J*z + K = 0 */
+class GeneralQuadric: public Helios::Surface {
+	/* Static constructor functions */
+	static Surface* Constructor(const SurfaceObject* definition) {
+		return new GeneralQuadric(definition);
+	}
+	/* Print surface internal data */
+	void print(std::ostream& out) const;
+	/* Return constructor function */
+	Surface::Constructor constructor() const {
+		return GeneralQuadric::Constructor;
+	}
+
+	/* Coefficients of the quadric (same order of the input) */
+	double coeffs[10];
+
+	/* Gradient of the function */
+	void gradient(const Coordinate& pos, Direction& grad) const {
+		grad[0] = 2.0*coeffs[0]*pos[0] + coeffs[3]*pos[1] + coeffs[5]*pos[2] + coeffs[6];
+		grad[1] = 2.0*coeffs[1]*pos[1] + coeffs[3]*pos[0] + coeffs[4]*pos[2] + coeffs[7];
+		grad[2] = 2.0*coeffs[2]*pos[2] + coeffs[4]*pos[1] + coeffs[5]*pos[0] + coeffs[8];
+	}
+
+public:
+	/* Default, used only on factory */
+	GeneralQuadric() {std::fill(coeffs, coeffs + 10, 0.0);};
+	GeneralQuadric(const SurfaceId& surid, const SurfaceInfo& flags, const std::vector<double>& quadric);
+	GeneralQuadric(const SurfaceObject* definition);
+
+	void normal(const Coordinate& point, Direction& vnormal) const;
+	bool intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const;
+	Surface* transformate(const Direction& trans) const;
+	void getQuadric(std::vector<double>& quadric) const;
+
+	/* Evaluate function */
+	double function(const Coordinate& pos) const {
+		return pos[0]*(coeffs[0]*pos[0] + coeffs[3]*pos[1] + coeffs[6]) +
+			   pos[1]*(coeffs[1]*pos[1] + coeffs[4]*pos[2] + coeffs[7]) +
+			   pos[2]*(coeffs[2]*pos[2] + coeffs[5]*pos[0] + coeffs[8]) + coeffs[9];
+	}
+
+	/* Name of the surface */
+	std::string getName() const {
+		return "gq";
+	}
+
+	/* Comparison */
+	bool compare(const Surface& sur) const {
+        /* safe to static cast because Surface::== already confirmed the type */
+        const GeneralQuadric& gq = static_cast<const GeneralQuadric&>(sur);
+        for(size_t i = 0 ; i < 10 ; i++)
+        	if(not compareFloating(coeffs[i],gq.coeffs[i])) return false;
+        return true;
+	}
+
+	virtual ~GeneralQuadric() {/* */};
+};
+
+} /* namespace Helios */
+#endif /* GENERALQUADRIC_HPP_ */
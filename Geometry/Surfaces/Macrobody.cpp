@@ -0,0 +1,318 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+
+#include "SurfaceUtils.hpp"
+#include "Macrobody.hpp"
+
+using namespace std;
+
+namespace Helios {
+
+/* ---- Macrobody */
+
+void Macrobody::addSlab(const Direction& normal, const double& lower, const double& upper) {
+	slab_normal[nslabs] = normal;
+	slab_lower[nslabs] = lower;
+	slab_upper[nslabs] = upper;
+	nslabs++;
+}
+
+void Macrobody::copySlabs(const Macrobody& body, const Direction& trans, const double rotation[3][3]) {
+	nslabs = 0;
+	for(int s = 0 ; s < body.nslabs ; ++s) {
+		Direction normal = body.slab_normal[s];
+		if(rotation) {
+			for(int i = 0 ; i < 3 ; ++i)
+				normal[i] = rotation[i][0] * body.slab_normal[s][0] + rotation[i][1] * body.slab_normal[s][1] +
+				            rotation[i][2] * body.slab_normal[s][2];
+		}
+		/* The projection of the translated points is shifted by normal * trans */
+		double shift = dot(normal, trans);
+		addSlab(normal, body.slab_lower[s] + shift, body.slab_upper[s] + shift);
+	}
+}
+
+double Macrobody::facetFunction(const Coordinate& pos, int& facet) const {
+	double value = -numeric_limits<double>::infinity();
+	for(int s = 0 ; s < nslabs ; ++s) {
+		double projection = dot(slab_normal[s], pos);
+		double lower = slab_lower[s] - projection;
+		double upper = projection - slab_upper[s];
+		if(lower > value) {value = lower; facet = 2 * s;}
+		if(upper > value) {value = upper; facet = 2 * s + 1;}
+	}
+	return value;
+}
+
+void Macrobody::interval(const Coordinate& pos, const Direction& dir, double& enter, double& exit) const {
+	/* Slab test */
+	for(int s = 0 ; s < nslabs ; ++s) {
+		double projection = dot(slab_normal[s], pos);
+		double cosine = dot(slab_normal[s], dir);
+		if(cosine != 0.0) {
+			double t_lower = (slab_lower[s] - projection) / cosine;
+			double t_upper = (slab_upper[s] - projection) / cosine;
+			enter = max(enter, min(t_lower, t_upper));
+			exit = min(exit, max(t_lower, t_upper));
+		} else if(projection < slab_lower[s] || projection > slab_upper[s]) {
+			/* Parallel to the slab and outside of it */
+			enter = numeric_limits<double>::infinity();
+			exit = -numeric_limits<double>::infinity();
+			return;
+		}
+	}
+}
+
+void Macrobody::normal(const Coordinate& point, Direction& vnormal) const {
+	int facet = getFacet(point);
+	if(facet < 2 * nslabs) {
+		vnormal = slab_normal[facet / 2];
+		if(facet % 2 == 0) vnormal = -vnormal;
+	} else
+		facetNormal(point, facet, vnormal);
+}
+
+bool Macrobody::intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const {
+	double enter = -numeric_limits<double>::infinity();
+	double exit = numeric_limits<double>::infinity();
+	interval(pos, dir, enter, exit);
+	/* Particle inside the body, always leaving it */
+	if(not sense) {
+		distance = max(0.0, exit);
+		return (exit < numeric_limits<double>::infinity());
+	}
+	/* Particle outside the body, check if the body is ahead */
+	if(enter < exit && exit > 0.0) {
+		distance = max(0.0, enter);
+		return true;
+	}
+	distance = 0.0;
+	return false;
+}
+
+void Macrobody::print(std::ostream& out) const {
+	for(int s = 0 ; s < nslabs ; ++s) {
+		out << "slab = " << slab_normal[s] << " [" << slab_lower[s] << "," << slab_upper[s] << "]";
+		if(s + 1 < nslabs) out << " ; ";
+	}
+}
+
+bool Macrobody::compare(const Surface& sur) const {
+	/* safe to static cast because Surface::== already confirmed the type */
+	const Macrobody& body = static_cast<const Macrobody&>(sur);
+	if(nslabs != body.nslabs) return false;
+	for(int s = 0 ; s < nslabs ; ++s) {
+		if(not compareTinyVector(slab_normal[s],body.slab_normal[s])) return false;
+		if(not compareFloating(slab_lower[s],body.slab_lower[s])) return false;
+		if(not compareFloating(slab_upper[s],body.slab_upper[s])) return false;
+	}
+	return true;
+}
+
+/* ---- Box */
+
+Box::Box(const SurfaceObject* definition) : Macrobody(definition) {
+	vector<double> coeffs = definition->getCoeffs();
+	if(definition->getType() == "box") {
+		/* Corner and three orthogonal edges */
+		if(coeffs.size() != 12)
+			throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),
+				  "Bad number of coefficients. Expected 12 values : vx vy vz a1x a1y a1z a2x a2y a2z a3x a3y a3z");
+		Coordinate corner(coeffs[0], coeffs[1], coeffs[2]);
+		for(int i = 0 ; i < 3 ; ++i) {
+			Direction edge(coeffs[3 + 3*i], coeffs[4 + 3*i], coeffs[5 + 3*i]);
+			double length = sqrt(dot(edge, edge));
+			if(length == 0.0)
+				throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),"The edges of the box can't be null vectors");
+			Direction normal(edge / length);
+			addSlab(normal, dot(normal, corner), dot(normal, corner) + length);
+		}
+		for(int i = 0 ; i < 3 ; ++i)
+			if(fabs(dot(slab_normal[i], slab_normal[(i + 1) % 3])) > 1e-10)
+				throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),"The edges of the box should be orthogonal");
+	} else {
+		/* Planes normal to each axis */
+		if(coeffs.size() != 6)
+			throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),
+				  "Bad number of coefficients. Expected 6 values : xmin xmax ymin ymax zmin zmax");
+		for(int i = 0 ; i < 3 ; ++i) {
+			if(coeffs[2*i] >= coeffs[2*i + 1])
+				throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),"The minimum values should be lower than the maximum ones");
+			Direction normal(0.0, 0.0, 0.0);
+			normal[i] = 1.0;
+			addSlab(normal, coeffs[2*i], coeffs[2*i + 1]);
+		}
+	}
+}
+
+Surface* Box::transformate(const Direction& trans) const {
+	Box* box = new Box(this->getUserId(),this->getFlags());
+	box->copySlabs(*this, trans);
+	return box;
+}
+
+Surface* Box::rotate(const double rotation[3][3], const Direction& trans) const {
+	Box* box = new Box(this->getUserId(),this->getFlags());
+	box->copySlabs(*this, trans, rotation);
+	return box;
+}
+
+/* ---- Right circular cylinder */
+
+RightCircularCylinder::RightCircularCylinder(const SurfaceObject* definition) : Macrobody(definition) {
+	vector<double> coeffs = definition->getCoeffs();
+	if(coeffs.size() != 7)
+		throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),
+			  "Bad number of coefficients. Expected 7 values : vx vy vz hx hy hz radius");
+	base = Coordinate(coeffs[0], coeffs[1], coeffs[2]);
+	Direction height(coeffs[3], coeffs[4], coeffs[5]);
+	double length = sqrt(dot(height, height));
+	if(length == 0.0)
+		throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),"The height vector can't be a null vector");
+	radius = coeffs[6];
+	Direction axis(height / length);
+	addSlab(axis, dot(axis, base), dot(axis, base) + length);
+}
+
+void RightCircularCylinder::print(std::ostream& out) const {
+	out << "base = " << base << " ; radius = " << radius << " ; ";
+	Macrobody::print(out);
+}
+
+double RightCircularCylinder::facetFunction(const Coordinate& pos, int& facet) const {
+	double value = Macrobody::facetFunction(pos, facet);
+	/* Distance to the lateral surface */
+	Coordinate trpos(pos - base);
+	double axial = dot(trpos, slab_normal[0]);
+	double lateral = sqrt(max(0.0, dot(trpos, trpos) - axial * axial)) - radius;
+	if(lateral > value) {
+		value = lateral;
+		facet = 2;
+	}
+	return value;
+}
+
+void RightCircularCylinder::facetNormal(const Coordinate& point, int facet, Direction& vnormal) const {
+	/* Radial direction */
+	Coordinate trpos(point - base);
+	vnormal = trpos - dot(trpos, slab_normal[0]) * slab_normal[0];
+	vnormal /= sqrt(dot(vnormal, vnormal));
+}
+
+void RightCircularCylinder::interval(const Coordinate& pos, const Direction& dir, double& enter, double& exit) const {
+	/* Planes of the bases */
+	Macrobody::interval(pos, dir, enter, exit);
+	if(enter >= exit) return;
+	/* Lateral surface (components perpendicular to the axis) */
+	Coordinate trpos(pos - base);
+	double axial_pos = dot(trpos, slab_normal[0]);
+	double axial_dir = dot(dir, slab_normal[0]);
+	double a = 1.0 - axial_dir * axial_dir;
+	double k = dot(trpos, dir) - axial_pos * axial_dir;
+	double c = dot(trpos, trpos) - axial_pos * axial_pos - radius * radius;
+	if(a <= 0.0) {
+		/* Parallel to the axis */
+		if(c > 0.0) {
+			enter = numeric_limits<double>::infinity();
+			exit = -numeric_limits<double>::infinity();
+		}
+		return;
+	}
+	double disc = k * k - a * c;
+	if(disc < 0.0) {
+		enter = numeric_limits<double>::infinity();
+		exit = -numeric_limits<double>::infinity();
+		return;
+	}
+	double root = sqrt(disc);
+	enter = max(enter, (-k - root) / a);
+	exit = min(exit, (-k + root) / a);
+}
+
+Surface* RightCircularCylinder::transformate(const Direction& trans) const {
+	RightCircularCylinder* rcc = new RightCircularCylinder(this->getUserId(),this->getFlags(),base + trans,radius);
+	rcc->copySlabs(*this, trans);
+	return rcc;
+}
+
+Surface* RightCircularCylinder::rotate(const double rotation[3][3], const Direction& trans) const {
+	Coordinate new_base(trans);
+	for(int i = 0 ; i < 3 ; ++i)
+		for(int j = 0 ; j < 3 ; ++j)
+			new_base[i] += rotation[i][j] * base[j];
+	RightCircularCylinder* rcc = new RightCircularCylinder(this->getUserId(),this->getFlags(),new_base,radius);
+	rcc->copySlabs(*this, trans, rotation);
+	return rcc;
+}
+
+/* ---- Right hexagonal prism */
+
+HexagonalPrism::HexagonalPrism(const SurfaceObject* definition) : Macrobody(definition) {
+	vector<double> coeffs = definition->getCoeffs();
+	if(coeffs.size() != 9)
+		throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),
+			  "Bad number of coefficients. Expected 9 values : vx vy vz hx hy hz rx ry rz");
+	Coordinate base(coeffs[0], coeffs[1], coeffs[2]);
+	Direction height(coeffs[3], coeffs[4], coeffs[5]);
+	Direction facet(coeffs[6], coeffs[7], coeffs[8]);
+	double length = sqrt(dot(height, height));
+	double apothem = sqrt(dot(facet, facet));
+	if(length == 0.0 || apothem == 0.0)
+		throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),"The height and facet vectors can't be null vectors");
+	Direction axis(height / length);
+	Direction first(facet / apothem);
+	if(fabs(dot(axis, first)) > 1e-10)
+		throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),"The facet vector should be perpendicular to the height vector");
+	/* Bases */
+	addSlab(axis, dot(axis, base), dot(axis, base) + length);
+	/* Pairs of facets, each one rotated 60 degrees around the axis */
+	Direction second(axis[1] * first[2] - axis[2] * first[1],
+			         axis[2] * first[0] - axis[0] * first[2],
+			         axis[0] * first[1] - axis[1] * first[0]);
+	const double cosine[3] = {1.0, 0.5, -0.5};
+	const double sine[3] = {0.0, sqrt(3.0) / 2.0, sqrt(3.0) / 2.0};
+	for(int i = 0 ; i < 3 ; ++i) {
+		Direction normal(cosine[i] * first + sine[i] * second);
+		addSlab(normal, dot(normal, base) - apothem, dot(normal, base) + apothem);
+	}
+}
+
+Surface* HexagonalPrism::transformate(const Direction& trans) const {
+	HexagonalPrism* hex = new HexagonalPrism(this->getUserId(),this->getFlags());
+	hex->copySlabs(*this, trans);
+	return hex;
+}
+
+Surface* HexagonalPrism::rotate(const double rotation[3][3], const Direction& trans) const {
+	HexagonalPrism* hex = new HexagonalPrism(this->getUserId(),this->getFlags());
+	hex->copySlabs(*this, trans, rotation);
+	return hex;
+}
+
+} /* namespace Helios */
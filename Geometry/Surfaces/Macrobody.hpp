@@ -0,0 +1,212 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MACROBODY_HPP_
+#define MACROBODY_HPP_
+
+#include <limits>
+
+#include "../Surface.hpp"
+
+namespace Helios {
+
+/*
+ * A macrobody is a closed body defined with a single surface (negative sense inside the body). The
+ * body is the intersection of slabs (pairs of parallel planes) and the distance to the boundary is
+ * calculated with one slab test over all of them. The function of the surface is the maximum of the
+ * signed distances to each facet, so the normal of the surface is the normal of the facet where the
+ * point is (needed on reflecting boundaries).
+ */
+class Macrobody: public Helios::Surface {
+
+public:
+
+	/* Normal of the facet nearest to the point (outward of the body) */
+	void normal(const Coordinate& point, Direction& vnormal) const;
+	/* Facet nearest to the point (2 * slab for the lower plane, 2 * slab + 1 for the upper one, other facets after them) */
+	int getFacet(const Coordinate& point) const {
+		int facet;
+		facetFunction(point, facet);
+		return facet;
+	}
+	/* Distance to the boundary of the body */
+	bool intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const;
+	/* Evaluate function */
+	double function(const Coordinate& pos) const {
+		int facet;
+		return facetFunction(pos, facet);
+	}
+	/* Macrobodies are not quadrics (they are rotated with the rotation matrix) */
+	void getQuadric(std::vector<double>& coeffs) const {
+		coeffs.assign(10, 0.0);
+	}
+
+	virtual ~Macrobody() {/* */};
+
+protected:
+
+	/* Maximum number of slabs of a body */
+	static const int max_slabs = 4;
+
+	/* Default, used only on factory */
+	Macrobody() : nslabs(0) {/* */};
+	Macrobody(const SurfaceId& surid, const SurfaceInfo& flags) : Surface(surid,flags), nslabs(0) {/* */};
+	Macrobody(const SurfaceObject* definition) : Surface(definition), nslabs(0) {/* */};
+
+	/* Add a slab (lower <= normal * x <= upper) */
+	void addSlab(const Direction& normal, const double& lower, const double& upper);
+	/* Copy the slabs of another body, translated and rotated (x' = rotation * x + trans) */
+	void copySlabs(const Macrobody& body, const Direction& trans, const double rotation[3][3] = 0);
+
+	/*
+	 * Maximum of the signed distances to each facet (negative inside the body), and the facet where
+	 * that maximum is reached (2 * slab for the lower plane and 2 * slab + 1 for the upper one).
+	 */
+	virtual double facetFunction(const Coordinate& pos, int& facet) const;
+	/* Normal of a facet that is not a plane of the slabs */
+	virtual void facetNormal(const Coordinate& point, int facet, Direction& vnormal) const {/* */};
+	/* Interval of the ray inside the body (empty if enter >= exit) */
+	virtual void interval(const Coordinate& pos, const Direction& dir, double& enter, double& exit) const;
+
+	/* Print the slabs of the body */
+	void print(std::ostream& out) const;
+	/* Compare the slabs of two bodies */
+	bool compare(const Surface& sur) const;
+
+	/* Number of slabs */
+	int nslabs;
+	/* Unit normal of each slab */
+	Direction slab_normal[max_slabs];
+	/* Lower and upper values of the projection of the points inside the body */
+	double slab_lower[max_slabs];
+	double slab_upper[max_slabs];
+};
+
+/* Box with faces normal to three orthogonal vectors (rpp : xmin xmax ymin ymax zmin zmax ; box : corner and 3 edges) */
+class Box: public Helios::Macrobody {
+	/* Static constructor functions */
+	static Surface* Constructor(const SurfaceObject* definition) {
+		return new Box(definition);
+	}
+	/* Return constructor function */
+	Surface::Constructor constructor() const {
+		return Box::Constructor;
+	}
+public:
+	/* Default, used only on factory */
+	Box() {/* */};
+	Box(const SurfaceId& surid, const SurfaceInfo& flags) : Macrobody(surid,flags) {/* */};
+	Box(const SurfaceObject* definition);
+
+	Surface* transformate(const Direction& trans) const;
+	Surface* rotate(const double rotation[3][3], const Direction& trans) const;
+
+	/* Name of the surface */
+	std::string getName() const {
+		return "rpp";
+	}
+
+	virtual ~Box() {/* */};
+};
+
+/* Right circular cylinder (rcc : base point, height vector and radius) */
+class RightCircularCylinder: public Helios::Macrobody {
+	/* Static constructor functions */
+	static Surface* Constructor(const SurfaceObject* definition) {
+		return new RightCircularCylinder(definition);
+	}
+	/* Return constructor function */
+	Surface::Constructor constructor() const {
+		return RightCircularCylinder::Constructor;
+	}
+	/* Print surface internal data */
+	void print(std::ostream& out) const;
+
+	/* Point on the axis of the cylinder */
+	Coordinate base;
+	/* Radius of the cylinder */
+	double radius;
+
+	/* The lateral surface is the facet 2 */
+	double facetFunction(const Coordinate& pos, int& facet) const;
+	void facetNormal(const Coordinate& point, int facet, Direction& vnormal) const;
+	void interval(const Coordinate& pos, const Direction& dir, double& enter, double& exit) const;
+
+public:
+	/* Default, used only on factory */
+	RightCircularCylinder() : base(0,0,0), radius(0) {/* */};
+	RightCircularCylinder(const SurfaceId& surid, const SurfaceInfo& flags, const Coordinate& base, const double& radius) :
+		Macrobody(surid,flags), base(base), radius(radius) {/* */};
+	RightCircularCylinder(const SurfaceObject* definition);
+
+	Surface* transformate(const Direction& trans) const;
+	Surface* rotate(const double rotation[3][3], const Direction& trans) const;
+
+	/* Name of the surface */
+	std::string getName() const {
+		return "rcc";
+	}
+
+	/* Comparison */
+	bool compare(const Surface& sur) const {
+		/* safe to static cast because Surface::== already confirmed the type */
+		const RightCircularCylinder& rcc = static_cast<const RightCircularCylinder&>(sur);
+		return compareFloating(radius,rcc.radius) && compareTinyVector(base,rcc.base) && Macrobody::compare(sur);
+	}
+
+	virtual ~RightCircularCylinder() {/* */};
+};
+
+/* Right hexagonal prism (rhp : base point, height vector and vector from the axis to the center of a facet) */
+class HexagonalPrism: public Helios::Macrobody {
+	/* Static constructor functions */
+	static Surface* Constructor(const SurfaceObject* definition) {
+		return new HexagonalPrism(definition);
+	}
+	/* Return constructor function */
+	Surface::Constructor constructor() const {
+		return HexagonalPrism::Constructor;
+	}
+public:
+	/* Default, used only on factory */
+	HexagonalPrism() {/* */};
+	HexagonalPrism(const SurfaceId& surid, const SurfaceInfo& flags) : Macrobody(surid,flags) {/* */};
+	HexagonalPrism(const SurfaceObject* definition);
+
+	Surface* transformate(const Direction& trans) const;
+	Surface* rotate(const double rotation[3][3], const Direction& trans) const;
+
+	/* Name of the surface */
+	std::string getName() const {
+		return "rhp";
+	}
+
+	virtual ~HexagonalPrism() {/* */};
+};
+
+} /* namespace Helios */
+#endif /* MACROBODY_HPP_ */
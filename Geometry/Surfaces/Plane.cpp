@@ -0,0 +1,85 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+
+#include "Plane.hpp"
+
+namespace Helios {
+
+Plane::Plane(const SurfaceId& surid, const SurfaceInfo& flags, const Direction& plane_normal, const double& value)
+	: Surface(surid,flags) {
+	double norm = std::sqrt(dot(plane_normal, plane_normal));
+	unit_normal = plane_normal / norm;
+	distance = value / norm;
+}
+
+Plane::Plane(const SurfaceObject* definition) : Surface(definition) {
+	/* Check number of parameters */
+	if(definition->getCoeffs().size() == 4) {
+		std::vector<double> coeffs = definition->getCoeffs();
+		Direction plane_normal(coeffs[0], coeffs[1], coeffs[2]);
+		double norm = std::sqrt(dot(plane_normal, plane_normal));
+		if(norm == 0.0)
+			throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),
+				  "The normal of the plane (A,B,C) can't be a null vector");
+		unit_normal = plane_normal / norm;
+		distance = coeffs[3] / norm;
+	} else {
+		throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),
+			  "Bad number of coefficients. Expected 4 values : A B C D (A*x + B*y + C*z - D = 0)");
+	}
+}
+
+void Plane::normal(const Coordinate& point, Direction& vnormal) const {
+	vnormal = unit_normal;
+}
+
+bool Plane::intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const {
+	double projection = dot(unit_normal, dir);
+    if (((sense == false) && (projection > 0)) || ((sense == true)  && (projection < 0))) {
+        /* Headed towards surface */
+        distance = -function(pos) / projection;
+        distance = std::max(0.0, distance);
+        return true;
+    }
+    distance = 0.0;
+    return false;
+}
+
+Surface* Plane::transformate(const Direction& trans) const {
+	return new Plane(this->getUserId(),this->getFlags(),unit_normal,distance + dot(unit_normal, trans));
+}
+
+void Plane::getQuadric(std::vector<double>& coeffs) const {
+	coeffs.assign(10, 0.0);
+	for(int i = 0 ; i < 3 ; i++)
+		coeffs[6 + i] = unit_normal[i];
+	coeffs[9] = -distance;
+}
+
+} /* namespace Helios */
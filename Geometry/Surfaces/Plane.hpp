@@ -0,0 +1,91 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANE_HPP_
+#define PLANE_HPP_
+
+#include "../Surface.hpp"
+
+namespace Helios {
+
+/* General plane : A*x + B*y + C*z - D = 0 (stored with an unit normal) */
+class Plane: public Helios::Surface {
+	/* Static constructor functions */
+	static Surface* Constructor(const SurfaceObject* definition) {
+		return new Plane(definition);
+	}
+	/* Print surface internal data */
+	void print(std::ostream& out) const {
+		out << "normal = " << unit_normal << " ; distance = " << distance;
+	}
+	/* Return constructor function */
+	Surface::Constructor constructor() const {
+		return Plane::Constructor;
+	}
+
+	/* Unit normal of the plane */
+	Direction unit_normal;
+	/* Signed distance of the plane to the origin */
+	double distance;
+public:
+	/* Default, used only on factory */
+	Plane() : unit_normal(0,0,1), distance(0) {/* */};
+	/* Plane defined by a normal vector (not necessarily normalized) and the value of the product with the normal */
+	Plane(const SurfaceId& surid, const SurfaceInfo& flags, const Direction& plane_normal, const double& value);
+	Plane(const SurfaceObject* definition);
+
+	void normal(const Coordinate& point, Direction& vnormal) const;
+	bool intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const;
+	Surface* transformate(const Direction& trans) const;
+	void getQuadric(std::vector<double>& coeffs) const;
+
+	/* Evaluate function */
+	double function(const Coordinate& pos) const {
+		return dot(unit_normal, pos) - distance;
+	}
+	/* Unit normal of the plane */
+	const Direction& getNormal() const {return unit_normal;}
+	/* Distance to the origin */
+	double getDistance() const {return distance;}
+
+	/* Name of the surface */
+	std::string getName() const {
+		return "p";
+	}
+
+	/* Comparison */
+	bool compare(const Surface& sur) const {
+        /* safe to static cast because Surface::== already confirmed the type */
+        const Plane& plane = static_cast<const Plane&>(sur);
+        return (compareFloating(distance,plane.distance) && compareTinyVector(unit_normal,plane.unit_normal));
+	}
+
+	virtual ~Plane() {/* */};
+};
+
+} /* namespace Helios */
+#endif /* PLANE_HPP_ */
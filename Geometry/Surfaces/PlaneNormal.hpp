@@ -65,10 +65,18 @@ namespace Helios {
 		void normal(const Coordinate& point, Direction& vnormal) const;
 		bool intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const;
 		Surface* transformate(const Direction& trans) const;
+		/* Coefficients as a general quadric */
+		void getQuadric(std::vector<double>& coeffs) const {
+		coeffs.assign(10, 0.0);
+		coeffs[6 + axis] = 1.0;
+		coeffs[9] = -coordinate;
+		}
 		/* Name of the surface */
 		std::string getName() const;
 		/* Evaluate function */
 		double function(const Coordinate& pos) const;
+		/* Coordinate of the plane on the normal axis */
+		double getCoordinate() const {return coordinate;}
 
 		/* Comparison */
 		bool compare(const Surface& sur) const {
@@ -0,0 +1,79 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SurfaceUtils.hpp"
+#include "Sphere.hpp"
+
+namespace Helios {
+
+Sphere::Sphere(const SurfaceObject* definition) : Surface(definition) {
+	/* Check number of parameters */
+	if(definition->getCoeffs().size() == 4) {
+		/* Get the center and the radius */
+		for(size_t i = 0 ; i < 3 ; i++)
+			center[i] = definition->getCoeffs()[i];
+		radius = definition->getCoeffs()[3];
+	} else {
+		throw Surface::BadSurfaceCreation(definition->getUserSurfaceId(),
+			  "Bad number of coefficients. Expected 4 values : x y z radius ");
+	}
+}
+
+void Sphere::normal(const Coordinate& point, Direction& vnormal) const {
+	vnormal = (point - center) / radius;
+}
+
+bool Sphere::intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const {
+	/* Calculate "quadratic" coefficients on the frame of the sphere */
+	Coordinate trpos(pos - center);
+	double a = 1.0;
+	double k = dot(trpos, dir);
+	double c = dot(trpos, trpos) - radius*radius;
+	return quadraticIntersect(a,k,c,sense,distance);
+}
+
+Surface* Sphere::transformate(const Direction& trans) const {
+	Coordinate new_center = center + trans;
+	return new Sphere(this->getUserId(),this->getFlags(),new_center,this->radius);
+}
+
+void Sphere::getQuadric(std::vector<double>& coeffs) const {
+	coeffs.assign(10, 0.0);
+	for(int i = 0 ; i < 3 ; i++) {
+		coeffs[i] = 1.0;
+		coeffs[6 + i] = -2.0 * center[i];
+	}
+	coeffs[9] = dot(center, center) - radius*radius;
+}
+
+/* Evaluate function */
+double Sphere::function(const Coordinate& pos) const {
+	Coordinate trpos(pos - center);
+	return dot(trpos, trpos) - radius*radius;
+}
+
+} /* namespace Helios */
@@ -27,6 +27,7 @@
 
 #include "SurfaceUtils.hpp"
 #include "SphereOnOrigin.hpp"
+#include "Sphere.hpp"
 
 namespace Helios {
 
@@ -54,7 +55,16 @@ bool SphereOnOrigin::intersect(const Coordinate& pos, const Direction& dir, cons
 }
 
 Surface* SphereOnOrigin::transformate(const Direction& trans) const {
-	return new SphereOnOrigin(this->getUserId(),this->getFlags(),this->radius);
+	if(compareTinyVector(trans,Direction(0,0,0)))
+		return new SphereOnOrigin(this->getUserId(),this->getFlags(),this->radius);
+	/* Off the origin */
+	return new Sphere(this->getUserId(),this->getFlags(),trans,this->radius);
+}
+
+void SphereOnOrigin::getQuadric(std::vector<double>& coeffs) const {
+	coeffs.assign(10, 0.0);
+	coeffs[0] = coeffs[1] = coeffs[2] = 1.0;
+	coeffs[9] = -radius*radius;
 }
 
 /* Evaluate function */
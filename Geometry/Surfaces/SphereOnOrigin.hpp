@@ -58,9 +58,12 @@ public:
 	void normal(const Coordinate& point, Direction& vnormal) const;
 	bool intersect(const Coordinate& pos, const Direction& dir, const bool& sense, double& distance) const;
 	Surface* transformate(const Direction& trans) const;
+	void getQuadric(std::vector<double>& coeffs) const;
 
 	/* Evaluate function */
 	double function(const Coordinate& pos) const;
+	/* Radius of the sphere */
+	double getRadius() const {return radius;}
 
 	/* Name of the surface */
 	std::string getName() const {
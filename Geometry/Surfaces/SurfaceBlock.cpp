@@ -0,0 +1,225 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "SurfaceBlock.hpp"
+#include "SurfaceTypes.hpp"
+#include "SurfaceUtils.hpp"
+
+using namespace std;
+
+namespace Helios {
+
+/* Indexes of the two axis perpendicular to some axis (same order used on dotProduct) */
+template<int axis> struct PerpendicularAxis;
+template<> struct PerpendicularAxis<xaxis> {static const int u = yaxis; static const int v = zaxis;};
+template<> struct PerpendicularAxis<yaxis> {static const int u = xaxis; static const int v = zaxis;};
+template<> struct PerpendicularAxis<zaxis> {static const int u = xaxis; static const int v = yaxis;};
+
+void SurfaceBlock::PlaneGroup::push(double plane_coordinate, bool sense, size_t surface_index) {
+	coordinate.push_back(plane_coordinate);
+	side.push_back(sense ? 1.0 : -1.0);
+	index.push_back(surface_index);
+}
+
+void SurfaceBlock::CylinderGroup::push(double point_u, double point_v, double radius, bool sense, size_t surface_index) {
+	u.push_back(point_u);
+	v.push_back(point_v);
+	radius2.push_back(radius * radius);
+	side.push_back(sense ? 1.0 : -1.0);
+	index.push_back(surface_index);
+}
+
+/* Try to put a cylinder on the block */
+template<int axis>
+static bool pushCylinder(const Surface* surface, double u[3], double v[3], double radius[3], int& cylaxis) {
+	if(const CylinderOnAxis<axis>* cyl = dynamic_cast<const CylinderOnAxis<axis>*>(surface)) {
+		u[axis] = cyl->getPoint()[PerpendicularAxis<axis>::u];
+		v[axis] = cyl->getPoint()[PerpendicularAxis<axis>::v];
+		radius[axis] = cyl->getRadius();
+		cylaxis = axis;
+		return true;
+	}
+	if(const CylinderOnAxisOrigin<axis>* cyl = dynamic_cast<const CylinderOnAxisOrigin<axis>*>(surface)) {
+		u[axis] = 0.0;
+		v[axis] = 0.0;
+		radius[axis] = cyl->getRadius();
+		cylaxis = axis;
+		return true;
+	}
+	return false;
+}
+
+/* Try to put a plane on the block */
+template<int axis>
+static bool pushPlane(const Surface* surface, double coordinate[3], int& planeaxis) {
+	if(const PlaneNormal<axis>* plane = dynamic_cast<const PlaneNormal<axis>*>(surface)) {
+		coordinate[axis] = plane->getCoordinate();
+		planeaxis = axis;
+		return true;
+	}
+	return false;
+}
+
+SurfaceBlock::SurfaceBlock(const std::vector<SenseSurface>& surfaces) : surfaces(surfaces) {
+	for(size_t i = 0 ; i < surfaces.size() ; ++i) {
+		const Surface* surface = surfaces[i].first;
+		bool sense = surfaces[i].second;
+		double coordinate[3], u[3], v[3], radius[3];
+		int surface_axis = 0;
+		if(pushPlane<xaxis>(surface,coordinate,surface_axis) || pushPlane<yaxis>(surface,coordinate,surface_axis) ||
+		   pushPlane<zaxis>(surface,coordinate,surface_axis))
+			planes[surface_axis].push(coordinate[surface_axis],sense,i);
+		else if(pushCylinder<xaxis>(surface,u,v,radius,surface_axis) || pushCylinder<yaxis>(surface,u,v,radius,surface_axis) ||
+				pushCylinder<zaxis>(surface,u,v,radius,surface_axis))
+			cylinders[surface_axis].push(u[surface_axis],v[surface_axis],radius[surface_axis],sense,i);
+		else
+			generic.push_back(i);
+	}
+	/* Only the groups with some surface are evaluated */
+	if(planes[xaxis].index.size()) kernels.push_back(xplane);
+	if(planes[yaxis].index.size()) kernels.push_back(yplane);
+	if(planes[zaxis].index.size()) kernels.push_back(zplane);
+	if(cylinders[xaxis].index.size()) kernels.push_back(xcylinder);
+	if(cylinders[yaxis].index.size()) kernels.push_back(ycylinder);
+	if(cylinders[zaxis].index.size()) kernels.push_back(zcylinder);
+}
+
+/* Keep the closest surface (on ties, the one that comes first on the cell) */
+static inline void selectDistance(double new_distance, size_t new_index, size_t& best_index, double& best_distance) {
+	if(new_distance < best_distance || (new_distance == best_distance && new_index < best_index)) {
+		best_distance = new_distance;
+		best_index = new_index;
+	}
+}
+
+template<int axis>
+void SurfaceBlock::planeDistance(const Coordinate& position, const Direction& direction, size_t& best_index, double& best_distance) const {
+	const PlaneGroup& group = planes[axis];
+	const double infinity = std::numeric_limits<double>::infinity();
+	const double pos = position[axis];
+	const double dir = direction[axis];
+	const size_t nplanes = group.coordinate.size();
+	size_t i = 0;
+	for(; i + width <= nplanes ; i += width) {
+		const double* coordinate = &group.coordinate[i];
+		const double* side = &group.side[i];
+		double batch[width];
+		for(size_t j = 0 ; j < width ; ++j) {
+			/* Headed towards the surface */
+			double new_distance = std::max(0.0, (coordinate[j] - pos) / dir);
+			batch[j] = (side[j] * dir < 0.0) ? new_distance : infinity;
+		}
+		for(size_t j = 0 ; j < width ; ++j)
+			selectDistance(batch[j],group.index[i + j],best_index,best_distance);
+	}
+	/* Remaining planes */
+	for(; i < nplanes ; ++i) {
+		if(group.side[i] * dir < 0.0)
+			selectDistance(std::max(0.0, (group.coordinate[i] - pos) / dir),group.index[i],best_index,best_distance);
+	}
+}
+
+template<int axis>
+void SurfaceBlock::cylinderDistance(const Coordinate& position, const Direction& direction, size_t& best_index, double& best_distance) const {
+	const CylinderGroup& group = cylinders[axis];
+	const double infinity = std::numeric_limits<double>::infinity();
+	const int iu = PerpendicularAxis<axis>::u;
+	const int iv = PerpendicularAxis<axis>::v;
+	/* Quadratic coefficient is the same for all the cylinders on the group */
+	const double a = 1 - direction[axis] * direction[axis];
+	const size_t ncylinders = group.u.size();
+	size_t i = 0;
+	for(; i + width <= ncylinders ; i += width) {
+		const double* u = &group.u[i];
+		const double* v = &group.v[i];
+		const double* radius2 = &group.radius2[i];
+		const double* side = &group.side[i];
+		double batch[width];
+		for(size_t j = 0 ; j < width ; ++j) {
+			/* Same calculation done by quadraticIntersect, without branches */
+			double tu = position[iu] - u[j];
+			double tv = position[iv] - v[j];
+			double k = direction[iu] * tu + direction[iv] * tv;
+			double c = (tu * tu + tv * tv) - radius2[j];
+			double disc = k*k - a*c;
+			double root = std::sqrt(std::max(disc,0.0));
+			/* Particle is inside the surface (negative orientation) */
+			double inside = (k <= 0) ? ((a > 0) ? (root - k)/a : infinity) : std::max(0.0, -c/(root + k));
+			/* Particle is outside the surface */
+			double outside = (k >= 0) ? ((a >= 0) ? infinity : -(root + k)/a) : std::max(0.0, c/(root - k));
+			double new_distance = (side[j] > 0.0) ? outside : inside;
+			batch[j] = (disc >= 0.0) ? new_distance : infinity;
+		}
+		for(size_t j = 0 ; j < width ; ++j)
+			selectDistance(batch[j],group.index[i + j],best_index,best_distance);
+	}
+	/* Remaining cylinders */
+	for(; i < ncylinders ; ++i) {
+		double tu = position[iu] - group.u[i];
+		double tv = position[iv] - group.v[i];
+		double k = direction[iu] * tu + direction[iv] * tv;
+		double c = (tu * tu + tv * tv) - group.radius2[i];
+		double new_distance;
+		if(quadraticIntersect(a,k,c,group.side[i] > 0.0,new_distance))
+			selectDistance(new_distance,group.index[i],best_index,best_distance);
+	}
+}
+
+void SurfaceBlock::intersect(const Coordinate& position, const Direction& direction, Surface*& surface, bool& sense, double& distance) const {
+	size_t best_index = surfaces.size();
+	double best_distance = std::numeric_limits<double>::infinity();
+
+	for(vector<Kernel>::const_iterator it = kernels.begin() ; it != kernels.end() ; ++it) {
+		switch(*it) {
+		case xplane : planeDistance<xaxis>(position,direction,best_index,best_distance); break;
+		case yplane : planeDistance<yaxis>(position,direction,best_index,best_distance); break;
+		case zplane : planeDistance<zaxis>(position,direction,best_index,best_distance); break;
+		case xcylinder : cylinderDistance<xaxis>(position,direction,best_index,best_distance); break;
+		case ycylinder : cylinderDistance<yaxis>(position,direction,best_index,best_distance); break;
+		case zcylinder : cylinderDistance<zaxis>(position,direction,best_index,best_distance); break;
+		}
+	}
+
+	/* Surfaces without specialized kernel */
+	for(vector<size_t>::const_iterator it = generic.begin() ; it != generic.end() ; ++it) {
+		double new_distance;
+		if(surfaces[*it].first->intersect(position,direction,surfaces[*it].second,new_distance))
+			selectDistance(new_distance,*it,best_index,best_distance);
+	}
+
+	/* Update data only if the surface is closer */
+	if(best_index < surfaces.size() && best_distance < distance) {
+		distance = best_distance;
+		surface = surfaces[best_index].first;
+		sense = surfaces[best_index].second;
+	}
+}
+
+} /* namespace Helios */
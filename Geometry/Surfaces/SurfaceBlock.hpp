@@ -0,0 +1,115 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SURFACEBLOCK_HPP_
+#define SURFACEBLOCK_HPP_
+
+#include <vector>
+
+#include "../../Common/Common.hpp"
+
+namespace Helios {
+
+	class Surface;
+
+	/*
+	 * Bounding surfaces of a cell grouped by type. The coefficients of each group are stored
+	 * on contiguous arrays (structure of arrays) and distances are evaluated on batches of
+	 * fixed width, so the compiler can vectorize the kernels instead of doing one virtual call
+	 * per surface. The surfaces that don't fill a batch are evaluated one by one, and surfaces
+	 * without a specialized kernel are intersected through the virtual function of the surface.
+	 */
+	class SurfaceBlock {
+
+	public:
+
+		/* Number of surfaces evaluated on each batch */
+		static const size_t width = 4;
+
+		/* Pair of surface and sense */
+		typedef std::pair<Surface*, bool> SenseSurface;
+
+		SurfaceBlock(const std::vector<SenseSurface>& surfaces);
+
+		/*
+		 * Get the nearest surface to a point in a given direction. The surface, sense and distance are
+		 * only updated if the intersection is closer than the distance passed. On ties, the surface that
+		 * comes first on the container of the cell is selected.
+		 */
+		void intersect(const Coordinate& position, const Direction& direction, Surface*& surface, bool& sense, double& distance) const;
+
+		~SurfaceBlock() {/* */}
+
+	private:
+
+		/* Planes normal to one axis */
+		struct PlaneGroup {
+			/* Coordinate of each plane */
+			std::vector<double> coordinate;
+			/* +1 if the cell is on the positive side, -1 if is on the negative side */
+			std::vector<double> side;
+			/* Index of the surface on the cell container */
+			std::vector<size_t> index;
+			void push(double plane_coordinate, bool sense, size_t surface_index);
+		};
+
+		/* Cylinders parallel to one axis */
+		struct CylinderGroup {
+			/* Coordinates of the axis (on the two directions perpendicular to the axis) */
+			std::vector<double> u;
+			std::vector<double> v;
+			/* Squared radius */
+			std::vector<double> radius2;
+			/* +1 if the cell is outside the cylinder, -1 if is inside */
+			std::vector<double> side;
+			/* Index of the surface on the cell container */
+			std::vector<size_t> index;
+			void push(double point_u, double point_v, double radius, bool sense, size_t surface_index);
+		};
+
+		/* Kernels of the groups */
+		enum Kernel {xplane, yplane, zplane, xcylinder, ycylinder, zcylinder};
+
+		/* Distance kernels of each group */
+		template<int axis>
+		void planeDistance(const Coordinate& position, const Direction& direction, size_t& best_index, double& best_distance) const;
+		template<int axis>
+		void cylinderDistance(const Coordinate& position, const Direction& direction, size_t& best_index, double& best_distance) const;
+
+		/* Bounding surfaces of the cell */
+		std::vector<SenseSurface> surfaces;
+		/* Planes for each axis */
+		PlaneGroup planes[3];
+		/* Cylinders for each axis */
+		CylinderGroup cylinders[3];
+		/* Kernels of the groups with some surface on it */
+		std::vector<Kernel> kernels;
+		/* Index of surfaces without specialized kernel */
+		std::vector<size_t> generic;
+	};
+
+} /* namespace Helios */
+#endif /* SURFACEBLOCK_HPP_ */
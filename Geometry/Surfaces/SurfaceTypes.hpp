@@ -32,5 +32,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "CylinderOnAxisOrigin.hpp"
 #include "CylinderOnAxis.hpp"
 #include "PlaneNormal.hpp"
+#include "Sphere.hpp"
+#include "Plane.hpp"
+#include "GeneralQuadric.hpp"
+#include "Macrobody.hpp"
 
 #endif /* SURFACETYPES_HPP_ */
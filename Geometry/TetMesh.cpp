@@ -0,0 +1,184 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <cmath>
+
+#include "TetMesh.hpp"
+
+using namespace std;
+
+namespace Helios {
+
+TetMesh::TetMesh(const string& file) : nblocks(0) {
+	ifstream in(file.c_str(), ios::in | ios::binary);
+	if(!in)
+		throw BadMesh(file,"The file doesn't exist");
+	/* Check the magic of the binary format */
+	char magic[4] = {0, 0, 0, 0};
+	in.read(magic,4);
+	if(in.gcount() == 4 && string(magic,4) == "HTET")
+		readBinary(in,file);
+	else {
+		in.clear();
+		in.seekg(0);
+		readText(in,file);
+	}
+	if(nodes.size() == 0 || elements.size() == 0)
+		throw BadMesh(file,"The mesh doesn't have any element");
+	/* Check the elements */
+	for(vector<Tetrahedron>::const_iterator it = elements.begin() ; it != elements.end() ; ++it) {
+		for(int i = 0 ; i < 4 ; ++i)
+			if((*it).node[i] < 0 || (*it).node[i] >= (long)nodes.size())
+				throw BadMesh(file,"Node " + toString((*it).node[i]) + " of element " + toString(it - elements.begin()) + " doesn't exist");
+		if((*it).block < 0)
+			throw BadMesh(file,"Negative block on element " + toString(it - elements.begin()));
+		nblocks = max(nblocks, (*it).block + 1);
+	}
+	setupFaces(file);
+}
+
+void TetMesh::readText(istream& in, const string& file) {
+	/* Remove the comments */
+	stringstream data;
+	string line;
+	while(getline(in,line)) {
+		size_t comment = line.find('#');
+		if(comment != string::npos) line.erase(comment);
+		data << line << "\n";
+	}
+
+	string keyword;
+	long nnodes = -1;
+	if(!(data >> keyword >> nnodes) || keyword != "nodes" || nnodes < 0)
+		throw BadMesh(file,"Expected the number of nodes (nodes N)");
+	nodes.resize(nnodes);
+	for(long i = 0 ; i < nnodes ; ++i)
+		if(!(data >> nodes[i][0] >> nodes[i][1] >> nodes[i][2]))
+			throw BadMesh(file,"Bad coordinates of node " + toString(i));
+
+	long ntets = -1;
+	if(!(data >> keyword >> ntets) || keyword != "tets" || ntets < 0)
+		throw BadMesh(file,"Expected the number of elements (tets M)");
+	elements.resize(ntets);
+	for(long i = 0 ; i < ntets ; ++i) {
+		Tetrahedron& tet = elements[i];
+		if(!(data >> tet.node[0] >> tet.node[1] >> tet.node[2] >> tet.node[3] >> tet.block))
+			throw BadMesh(file,"Bad definition of element " + toString(i) + " (expected 4 nodes and the block)");
+	}
+}
+
+template<class T>
+static void readValue(istream& in, T& value, const string& file) {
+	in.read(reinterpret_cast<char*>(&value), sizeof(T));
+	if(!in)
+		throw TetMesh::BadMesh(file,"Unexpected end of the binary file");
+}
+
+void TetMesh::readBinary(istream& in, const string& file) {
+	int version;
+	readValue(in,version,file);
+	if(version != 1)
+		throw BadMesh(file,"Version " + toString(version) + " of the binary format is not supported");
+
+	long long nnodes;
+	readValue(in,nnodes,file);
+	if(nnodes < 0) throw BadMesh(file,"Negative number of nodes");
+	nodes.resize(nnodes);
+	for(long i = 0 ; i < nnodes ; ++i)
+		for(int j = 0 ; j < 3 ; ++j)
+			readValue(in,nodes[i][j],file);
+
+	long long ntets;
+	readValue(in,ntets,file);
+	if(ntets < 0) throw BadMesh(file,"Negative number of elements");
+	elements.resize(ntets);
+	for(long i = 0 ; i < ntets ; ++i) {
+		int value[5];
+		for(int j = 0 ; j < 5 ; ++j)
+			readValue(in,value[j],file);
+		for(int j = 0 ; j < 4 ; ++j)
+			elements[i].node[j] = value[j];
+		elements[i].block = value[4];
+	}
+}
+
+void TetMesh::setupFaces(const string& file) {
+	/* Faces by the (sorted) nodes */
+	typedef pair<long, pair<long,long> > FaceKey;
+	map<FaceKey,long> face_map;
+	for(size_t e = 0 ; e < elements.size() ; ++e) {
+		Tetrahedron& tet = elements[e];
+		for(int i = 0 ; i < 4 ; ++i) {
+			/* Nodes of the face opposite to the node i */
+			long fnode[3];
+			for(int j = 0, k = 0 ; j < 4 ; ++j)
+				if(j != i) fnode[k++] = tet.node[j];
+			sort(fnode, fnode + 3);
+			FaceKey key(fnode[0], make_pair(fnode[1],fnode[2]));
+
+			map<FaceKey,long>::const_iterator it_face = face_map.find(key);
+			long index;
+			if(it_face == face_map.end()) {
+				/* New face, get the plane */
+				Face face;
+				for(int j = 0 ; j < 3 ; ++j)
+					face.node[j] = fnode[j];
+				face.element[0] = face.element[1] = -1;
+				Direction u = nodes[fnode[1]] - nodes[fnode[0]];
+				Direction v = nodes[fnode[2]] - nodes[fnode[0]];
+				Direction normal(u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]);
+				double norm = sqrt(dot(normal, normal));
+				if(norm == 0.0)
+					throw BadMesh(file,"Element " + toString(e) + " is degenerated (a face has no area)");
+				face.normal = normal / norm;
+				face.distance = dot(face.normal, nodes[fnode[0]]);
+				index = faces.size();
+				face_map[key] = index;
+				faces.push_back(face);
+			} else
+				index = (*it_face).second;
+
+			/* Side of the face where the element is */
+			Face& face = faces[index];
+			double side = face.function(nodes[tet.node[i]]);
+			if(side == 0.0)
+				throw BadMesh(file,"Element " + toString(e) + " is degenerated (the nodes are on the same plane)");
+			int slot = (side > 0.0) ? 0 : 1;
+			if(face.element[slot] >= 0)
+				throw BadMesh(file,"Elements " + toString(face.element[slot]) + " and " + toString(e) + " overlap (or a face is shared by more than two elements)");
+			face.element[slot] = e;
+			tet.face[i] = index;
+			tet.sense[i] = (slot == 0);
+		}
+	}
+}
+
+} /* namespace Helios */
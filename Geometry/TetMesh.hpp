@@ -0,0 +1,126 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TETMESH_HPP_
+#define TETMESH_HPP_
+
+#include <vector>
+#include <string>
+
+#include "../Common/Common.hpp"
+
+namespace Helios {
+
+	/*
+	 * Unstructured mesh of tetrahedrons. The mesh is read from a text file with the coordinates
+	 * of the nodes and the nodes of each element (numbered from zero) followed by the block of
+	 * the element :
+	 *
+	 *   nodes N
+	 *   x y z             (N lines)
+	 *   tets M
+	 *   n0 n1 n2 n3 block (M lines)
+	 *
+	 * Lines starting with # are comments. The same data can be on a binary file, starting with
+	 * the magic "HTET" and the version (int32) followed by the number of nodes (int64), the
+	 * coordinates (3 doubles for each node), the number of elements (int64) and 5 int32 values
+	 * for each element (the nodes and the block).
+	 *
+	 * The faces of the elements are found once : each face is shared by at most two elements,
+	 * the faces on the boundary of the mesh have only one of them.
+	 */
+	class TetMesh {
+
+	public:
+
+		/* Exception */
+		class BadMesh : public std::exception {
+			std::string reason;
+		public:
+			BadMesh(const std::string& file, const std::string& msg) {
+				reason = "Cannot read mesh file " + file + " : " + msg;
+			}
+			const char *what() const throw() {
+				return reason.c_str();
+			}
+			~BadMesh() throw() {/* */};
+		};
+
+		/* Element of the mesh */
+		struct Tetrahedron {
+			/* Nodes of the element */
+			long node[4];
+			/* Block of the element */
+			int block;
+			/* Face opposite to each node */
+			long face[4];
+			/* Side of each face where the element is (the opposite node is on the positive side of the plane) */
+			bool sense[4];
+		};
+
+		/* Triangular face of the mesh */
+		struct Face {
+			/* Nodes of the face (sorted) */
+			long node[3];
+			/* Element on the positive side of the plane and on the negative side (or -1 on the boundary) */
+			long element[2];
+			/* Plane of the face : dot(normal, x) - distance = 0 */
+			Direction normal;
+			double distance;
+			/* Value of the plane equation on a point */
+			double function(const Coordinate& position) const {return dot(normal, position) - distance;}
+		};
+
+		/* Read the mesh from a file */
+		TetMesh(const std::string& file);
+
+		const std::vector<Coordinate>& getNodes() const {return nodes;}
+		const std::vector<Tetrahedron>& getElements() const {return elements;}
+		const std::vector<Face>& getFaces() const {return faces;}
+
+		/* Number of blocks of the mesh (the biggest block number plus one) */
+		int getBlocks() const {return nblocks;}
+
+		~TetMesh() {/* */}
+
+	private:
+
+		/* Read the nodes and the elements */
+		void readText(std::istream& in, const std::string& file);
+		void readBinary(std::istream& in, const std::string& file);
+
+		/* Find the faces of the elements (and the neighbors on each one) */
+		void setupFaces(const std::string& file);
+
+		std::vector<Coordinate> nodes;
+		std::vector<Tetrahedron> elements;
+		std::vector<Face> faces;
+		int nblocks;
+	};
+
+} /* namespace Helios */
+#endif /* TETMESH_HPP_ */
@@ -0,0 +1,195 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "Transformation.hpp"
+#include "Surfaces/SurfaceTypes.hpp"
+
+using namespace std;
+
+namespace Helios {
+
+/* Tolerance to recognize special forms of a rotated quadric */
+static const double quadric_tolerance = 1e-10;
+
+static inline bool isZero(const double& value) {
+	return std::fabs(value) < quadric_tolerance;
+}
+
+Transformation::Transformation(const Direction& translation, const Direction& rotation) : translation(translation) {
+	rotated = (rotation[0] != 0.0) || (rotation[1] != 0.0) || (rotation[2] != 0.0);
+	setMatrix(rotation);
+}
+
+void Transformation::setMatrix(const Direction& rotation) {
+	double deg = M_PI / 180.0;
+	double cx = cos(rotation[0] * deg), sx = sin(rotation[0] * deg);
+	double cy = cos(rotation[1] * deg), sy = sin(rotation[1] * deg);
+	double cz = cos(rotation[2] * deg), sz = sin(rotation[2] * deg);
+	/* R = Rz * Ry * Rx */
+	matrix[0][0] = cz*cy; matrix[0][1] = cz*sy*sx - sz*cx; matrix[0][2] = cz*sy*cx + sz*sx;
+	matrix[1][0] = sz*cy; matrix[1][1] = sz*sy*sx + cz*cx; matrix[1][2] = sz*sy*cx - cz*sx;
+	matrix[2][0] = -sy;   matrix[2][1] = cy*sx;            matrix[2][2] = cy*cx;
+}
+
+const Transformation Transformation::operator+(const Transformation& right) const {
+	Transformation result;
+	if(not rotated) {
+		result = right;
+		result.translation = right.translation + translation;
+		return result;
+	}
+	/* x = R_left * (R_right * x + t_right) + t_left */
+	for(int i = 0 ; i < 3 ; i++) {
+		result.translation[i] = translation[i];
+		for(int j = 0 ; j < 3 ; j++) {
+			result.translation[i] += matrix[i][j] * right.translation[j];
+			result.matrix[i][j] = 0.0;
+			for(int k = 0 ; k < 3 ; k++)
+				result.matrix[i][j] += matrix[i][k] * right.matrix[k][j];
+		}
+	}
+	result.rotated = true;
+	return result;
+}
+
+Surface* Transformation::rotate(const Surface* surface, bool& flipped) const {
+	/* Surfaces that know how to rotate themselves */
+	Surface* rotated_surface = surface->rotate(matrix, translation);
+	if(rotated_surface) return rotated_surface;
+
+	/* Get the surface as a quadric on the local frame : x^T Q x + g x + K */
+	vector<double> coeffs;
+	surface->getQuadric(coeffs);
+	double quad[3][3] = {{coeffs[0],       0.5*coeffs[3], 0.5*coeffs[5]},
+			             {0.5*coeffs[3], coeffs[1],       0.5*coeffs[4]},
+			             {0.5*coeffs[5], 0.5*coeffs[4], coeffs[2]}};
+
+	/* Rotated quadric, Q' = R Q R^T and g' = R g */
+	double rquad[3][3];
+	double rlin[3];
+	for(int i = 0 ; i < 3 ; i++) {
+		rlin[i] = 0.0;
+		for(int k = 0 ; k < 3 ; k++)
+			rlin[i] += matrix[i][k] * coeffs[6 + k];
+		for(int j = 0 ; j < 3 ; j++) {
+			rquad[i][j] = 0.0;
+			for(int k = 0 ; k < 3 ; k++)
+				for(int l = 0 ; l < 3 ; l++)
+					rquad[i][j] += matrix[i][k] * quad[k][l] * matrix[j][l];
+		}
+	}
+
+	/* Translated quadric, g'' = g' - 2 Q' t and K'' = t Q' t - g' t + K */
+	double constant = coeffs[9];
+	double linear[3];
+	for(int i = 0 ; i < 3 ; i++) {
+		double qt = 0.0;
+		for(int j = 0 ; j < 3 ; j++)
+			qt += rquad[i][j] * translation[j];
+		linear[i] = rlin[i] - 2.0 * qt;
+		constant += translation[i] * qt - rlin[i] * translation[i];
+	}
+
+	SurfaceId surid = surface->getUserId();
+	Surface::SurfaceInfo flags = surface->getFlags();
+
+	bool diagonal = isZero(rquad[0][1]) && isZero(rquad[1][2]) && isZero(rquad[0][2]);
+	if(diagonal) {
+		/* Count second order terms */
+		int axis = -1;
+		int nzero = 0;
+		double scale = 0.0;
+		for(int i = 0 ; i < 3 ; i++) {
+			if(isZero(rquad[i][i])) {
+				axis = i;
+				nzero++;
+			}
+			else scale = rquad[i][i];
+		}
+
+		/* A plane (normal to an axis if the normal is along some axis, with the sense flipped if it's on the negative direction) */
+		if(nzero == 3) {
+			for(int i = 0 ; i < 3 ; i++) {
+				if(isZero(linear[i]) || not isZero(linear[(i + 1) % 3]) || not isZero(linear[(i + 2) % 3])) continue;
+				double coordinate = -constant / linear[i];
+				flipped = (linear[i] < 0.0);
+				switch(i) {
+				case xaxis :
+					return new PlaneNormal<xaxis>(surid, flags, coordinate);
+				case yaxis :
+					return new PlaneNormal<yaxis>(surid, flags, coordinate);
+				case zaxis :
+					return new PlaneNormal<zaxis>(surid, flags, coordinate);
+				}
+			}
+			return new Plane(surid, flags, Direction(linear[0], linear[1], linear[2]), -constant);
+		}
+
+		/* Check that the non null terms are equal (spheres and circular cylinders) */
+		bool isotropic = (scale > 0.0);
+		for(int i = 0 ; i < 3 ; i++)
+			if(i != axis && not isZero(rquad[i][i] - scale)) isotropic = false;
+
+		if(isotropic && nzero == 0) {
+			Coordinate center(-0.5 * linear[0] / scale, -0.5 * linear[1] / scale, -0.5 * linear[2] / scale);
+			double radius2 = dot(center, center) - constant / scale;
+			if(radius2 > 0.0)
+				return new Sphere(surid, flags, center, sqrt(radius2));
+		}
+
+		if(isotropic && nzero == 1 && isZero(linear[axis])) {
+			Coordinate point(0.0, 0.0, 0.0);
+			for(int i = 0 ; i < 3 ; i++)
+				if(i != axis) point[i] = -0.5 * linear[i] / scale;
+			double radius2 = dot(point, point) - constant / scale;
+			if(radius2 > 0.0) {
+				double radius = sqrt(radius2);
+				switch(axis) {
+				case xaxis :
+					return new CylinderOnAxis<xaxis>(surid, flags, radius, point);
+				case yaxis :
+					return new CylinderOnAxis<yaxis>(surid, flags, radius, point);
+				case zaxis :
+					return new CylinderOnAxis<zaxis>(surid, flags, radius, point);
+				}
+			}
+		}
+	}
+
+	/* General case */
+	vector<double> quadric(10);
+	quadric[0] = rquad[0][0]; quadric[1] = rquad[1][1]; quadric[2] = rquad[2][2];
+	quadric[3] = 2.0 * rquad[0][1]; quadric[4] = 2.0 * rquad[1][2]; quadric[5] = 2.0 * rquad[0][2];
+	quadric[6] = linear[0]; quadric[7] = linear[1]; quadric[8] = linear[2];
+	quadric[9] = constant;
+	return new GeneralQuadric(surid, flags, quadric);
+}
+
+} /* namespace Helios */
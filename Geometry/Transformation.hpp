@@ -32,25 +32,66 @@
 
 namespace Helios {
 
+/*
+ * Transformation from the local frame of an universe to the frame of the parent cell :
+ * x_parent = R * x_local + translation. The rotation R is given in degrees around each of
+ * the 3 axis (applied first around x, then around y and finally around z).
+ */
 class Transformation {
 
 	/* A translation transformation */
 	Direction translation;
-	/* A rotation (degrees around each of the 3 axis) */
-	Direction rotation;
+	/* Rotation matrix */
+	double matrix[3][3];
+	/* Flag if the transformation has a rotation */
+	bool rotated;
+
+	/* Set rotation matrix from the angles (degrees) */
+	void setMatrix(const Direction& rotation);
 
 public:
-	Transformation(const Direction& translation = Direction(0,0,0), const Direction& rotation = Direction(0,0,0))
-					: translation(translation), rotation(rotation) {/* */}
+	Transformation(const Direction& translation = Direction(0,0,0), const Direction& rotation = Direction(0,0,0));
+
+	/*
+	 * Returns a new instance of a cloned transformed surface. The flag is set when the new surface
+	 * has the opposite sense of the original one (a plane whose normal ends up on the negative
+	 * direction of an axis is created as a plane normal to that axis).
+	 */
+	Surface* operator()(const Surface* surface, bool& flipped) const {
+		flipped = false;
+		if(not rotated) return surface->transformate(translation);
+		return rotate(surface,flipped);
+	}
 
-	/* Returns a new instance of a cloned transformed surface */
-	Surface* operator()(const Surface* surface) const { return surface->transformate(translation); }
+	/* Rotate and translate a surface */
+	Surface* rotate(const Surface* surface, bool& flipped) const;
 
-	/* Sum transformations */
-	const Transformation operator+(const Transformation& right) const {
-		return Transformation(right.translation + translation, right.rotation + rotation);
+	/* Coordinates of a point on the local frame */
+	Coordinate toLocal(const Coordinate& position) const {
+		Coordinate local(position - translation);
+		if(not rotated) return local;
+		/* Inverse rotation (transpose) */
+		return Coordinate(matrix[0][0]*local[0] + matrix[1][0]*local[1] + matrix[2][0]*local[2],
+				          matrix[0][1]*local[0] + matrix[1][1]*local[1] + matrix[2][1]*local[2],
+				          matrix[0][2]*local[0] + matrix[1][2]*local[1] + matrix[2][2]*local[2]);
 	}
 
+	/* Coordinates of a local point on the frame of the parent */
+	Coordinate toParent(const Coordinate& local) const {
+		if(not rotated) return local + translation;
+		return Coordinate(matrix[0][0]*local[0] + matrix[0][1]*local[1] + matrix[0][2]*local[2] + translation[0],
+				          matrix[1][0]*local[0] + matrix[1][1]*local[1] + matrix[1][2]*local[2] + translation[1],
+				          matrix[2][0]*local[0] + matrix[2][1]*local[1] + matrix[2][2]*local[2] + translation[2]);
+	}
+
+	/* Compose transformations (the right one is applied first) */
+	const Transformation operator+(const Transformation& right) const;
+
+	/* Translation of this transformation */
+	const Direction& getTranslation() const {return translation;}
+	/* Check if there is a rotation on this transformation */
+	bool isRotated() const {return rotated;}
+
 	~Transformation() {/* */}
 };
 
@@ -32,6 +32,7 @@
 
 #include "Cell.hpp"
 #include "Surface.hpp"
+#include "LatticeLocator.hpp"
 
 #include "../Common/Common.hpp"
 
@@ -55,6 +56,8 @@ namespace Helios {
 		 * has a NULL parent.
 		 */
 		Cell* parent;
+		/* Arithmetic lookup of the cells (only on lattices, the cells are the elements of the lattice) */
+		LatticeLocator* locator;
 
 	protected:
 
@@ -93,10 +96,18 @@ namespace Helios {
 		const std::vector<Cell*>& getCells() const {return cells;};
 
 		/* Find cell inside the universe */
-		const Cell* findCell(const Coordinate& position, const Surface* skip = 0) const {
+		const Cell* findCell(const Coordinate& position, const Surface* skip = 0, GeometryState* state = 0) const {
+			/* Try first with the element of the lattice that contains the point */
+			if(locator) {
+				long element = locator->locate(position);
+				if(element >= 0) {
+					const Cell* in_cell = cells[element]->findCell(position,skip,state);
+					if (in_cell) return in_cell;
+				}
+			}
 			/* loop through all cells in problem */
 			for (std::vector<Cell*>::const_iterator it_cell = cells.begin(); it_cell != cells.end(); ++it_cell) {
-				const Cell* in_cell = (*it_cell)->findCell(position,skip);
+				const Cell* in_cell = (*it_cell)->findCell(position,skip,state);
 				if (in_cell) return in_cell;
 			}
 			return 0;
@@ -107,6 +118,11 @@ namespace Helios {
 		/* Get parent cell */
 		const Cell* getParent() const {return parent;}
 
+		/* Set the lattice locator of this universe (the universe owns the pointer) */
+		void setLocator(LatticeLocator* lattice_locator) {locator = lattice_locator;}
+		/* Get the lattice locator (NULL if this universe is not a lattice) */
+		const LatticeLocator* getLocator() const {return locator;}
+
 		/* Return the user ID associated with the universe. */
 		const UniverseId& getUserId() const {return user_id;}
 		/* Set internal / unique identifier for the cell */
@@ -114,7 +130,7 @@ namespace Helios {
 		/* Return the internal ID associated with the universe. */
 		const InternalUniverseId& getInternalId() const {return internal_id;}
 
-		virtual ~Universe() {/* */};
+		virtual ~Universe() {delete locator;};
 	};
 
 
@@ -0,0 +1,176 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <iomanip>
+
+#include "VolumeCalculator.hpp"
+#include "Geometry.hpp"
+#include "FlatGeometry.hpp"
+#include "Cell.hpp"
+#include "Universe.hpp"
+#include "../Material/Material.hpp"
+
+using namespace std;
+
+namespace Helios {
+
+VolumeCalculator::VolumeCalculator(const Geometry* geometry, const Coordinate& lower, const Coordinate& upper) :
+	geometry(geometry), lower(lower), upper(upper),
+	box_volume((upper[0] - lower[0]) * (upper[1] - lower[1]) * (upper[2] - lower[2])),
+	nhits(geometry->getCells().size() + 1, 0), npoints(0) {
+	if(box_volume <= 0.0)
+		throw Geometry::GeometryError("Bad box to calculate volumes (the upper corner should be greater than the lower one)");
+}
+
+VolumeCalculator::PointCounter::PointCounter(const VolumeCalculator& calculator, const Random& r) :
+	calculator(calculator), r(r), nhits(calculator.nhits.size(), 0) {/* */}
+
+VolumeCalculator::PointCounter::PointCounter(PointCounter& other, tbb::split) :
+	calculator(other.calculator), r(other.r), nhits(other.nhits.size(), 0) {/* */}
+
+void VolumeCalculator::PointCounter::operator() (const tbb::blocked_range<size_t>& range) {
+	const FlatGeometry* flat_geometry = calculator.geometry->getFlatGeometry();
+	const Coordinate& lower = calculator.lower;
+	const Coordinate& upper = calculator.upper;
+	/* Jump random number generator (3 numbers per point) */
+	Random r_local(r);
+	r_local.jump(3*range.begin());
+	for(size_t k = range.begin() ; k < range.end() ; ++k) {
+		double x = lower[0] + r_local.uniform() * (upper[0] - lower[0]);
+		double y = lower[1] + r_local.uniform() * (upper[1] - lower[1]);
+		double z = lower[2] + r_local.uniform() * (upper[2] - lower[2]);
+		const Cell* cell = flat_geometry->findCell(Coordinate(x,y,z));
+		if(!cell) {
+			nhits.back()++;
+			continue;
+		}
+		/* The point is also inside the cells filled with the universe of this cell (on each level) */
+		for(; cell ; cell = cell->getParent()->getParent())
+			nhits[cell->getInternalId()]++;
+	}
+}
+
+void VolumeCalculator::PointCounter::join(const PointCounter& other) {
+	for(size_t i = 0 ; i < nhits.size() ; ++i)
+		nhits[i] += other.nhits[i];
+}
+
+size_t VolumeCalculator::calculate(const Random& r, double relative_error, size_t batch_size, size_t max_points) {
+	Random batch_random(r);
+	while(npoints < max_points) {
+		/* Count the points of this batch */
+		PointCounter counter(*this, batch_random);
+		tbb::parallel_reduce(tbb::blocked_range<size_t>(0,batch_size),counter);
+		batch_random.jump(3*batch_size);
+		for(size_t i = 0 ; i < nhits.size() ; ++i)
+			nhits[i] += counter.nhits[i];
+		npoints += batch_size;
+
+		/* Check the relative error of each cell found */
+		bool converged = true;
+		for(size_t i = 0 ; i < nhits.size() - 1 ; ++i)
+			if(estimate(nhits[i]).relative() > relative_error) {
+				converged = false;
+				break;
+			}
+		if(converged) break;
+	}
+	return npoints;
+}
+
+VolumeCalculator::Volume VolumeCalculator::estimate(size_t hits) const {
+	if(npoints == 0) return Volume();
+	double fraction = (double)hits / (double)npoints;
+	return Volume(box_volume * fraction, box_volume * sqrt(fraction * (1.0 - fraction) / (double)npoints));
+}
+
+VolumeCalculator::Volume VolumeCalculator::getVolume(const Cell* cell) const {
+	return estimate(nhits[cell->getInternalId()]);
+}
+
+VolumeCalculator::Volume VolumeCalculator::getCellVolume(const CellId& cell) const {
+	const vector<Cell*>& cells = geometry->getCells();
+	size_t hits = 0;
+	for(vector<Cell*>::const_iterator it = cells.begin() ; it != cells.end() ; ++it)
+		if((*it)->getUserId() == cell)
+			hits += nhits[(*it)->getInternalId()];
+	return estimate(hits);
+}
+
+VolumeCalculator::Volume VolumeCalculator::getMaterialVolume(const Material* material) const {
+	const vector<Cell*>& cells = geometry->getCells();
+	size_t hits = 0;
+	for(vector<Cell*>::const_iterator it = cells.begin() ; it != cells.end() ; ++it)
+		if((*it)->getMaterial() == material)
+			hits += nhits[(*it)->getInternalId()];
+	return estimate(hits);
+}
+
+static ostream& printVolume(ostream& out, const string& name, const VolumeCalculator::Volume& volume) {
+	out << left << setw(30) << name << right << scientific << setprecision(5) << setw(15) << volume.value
+		<< " +- " << setw(12) << volume.error << fixed << setprecision(2) << " (" << 100.0 * volume.relative() << " %)" << endl;
+	return out;
+}
+
+void VolumeCalculator::print(std::ostream& out) const {
+	const vector<Cell*>& cells = geometry->getCells();
+	/* Accumulate hits of user cells and materials (keeping the order of the cells) */
+	vector<CellId> user_cells;
+	map<CellId,size_t> user_hits;
+	vector<const Material*> materials;
+	map<const Material*,size_t> material_hits;
+	for(vector<Cell*>::const_iterator it = cells.begin() ; it != cells.end() ; ++it) {
+		size_t hits = nhits[(*it)->getInternalId()];
+		if(user_hits.find((*it)->getUserId()) == user_hits.end()) user_cells.push_back((*it)->getUserId());
+		user_hits[(*it)->getUserId()] += hits;
+		const Material* material = (*it)->getMaterial();
+		if(material) {
+			if(material_hits.find(material) == material_hits.end()) materials.push_back(material);
+			material_hits[material] += hits;
+		}
+	}
+
+	ios_base::fmtflags flags = out.flags();
+	streamsize precision = out.precision();
+	out << "Volumes estimated with " << npoints << " points (" << nhits.back() << " outside the geometry)" << endl;
+	out << endl << "Cells : " << endl;
+	for(vector<CellId>::const_iterator it = user_cells.begin() ; it != user_cells.end() ; ++it)
+		printVolume(out, *it, estimate(user_hits[*it]));
+	if(materials.size()) {
+		out << endl << "Materials : " << endl;
+		for(vector<const Material*>::const_iterator it = materials.begin() ; it != materials.end() ; ++it)
+			printVolume(out, (*it)->getUserId(), estimate(material_hits[*it]));
+	}
+	out << endl << "Paths : " << endl;
+	for(vector<Cell*>::const_iterator it = cells.begin() ; it != cells.end() ; ++it)
+		printVolume(out, geometry->getPath(*it), getVolume(*it));
+	out.flags(flags);
+	out.precision(precision);
+}
+
+} /* namespace Helios */
@@ -0,0 +1,129 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef VOLUMECALCULATOR_HPP_
+#define VOLUMECALCULATOR_HPP_
+
+#include <vector>
+#include <map>
+#include <iostream>
+#include <tbb/parallel_reduce.h>
+#include <tbb/blocked_range.h>
+
+#include "../Common/Common.hpp"
+
+namespace Helios {
+
+	class Geometry;
+	class Cell;
+	class Material;
+
+	/*
+	 * Stochastic calculation of volumes. Points are sampled uniformly inside a box and the cell that contains
+	 * each one is found with the compiled geometry (the same search used on transport). The volume of each
+	 * cell is the volume of the box times the fraction of points inside the cell (a point found on some cell
+	 * is also inside the cells filled with the universes above it).
+	 *
+	 * Points are sampled in batches (checked in parallel, each thread with its own counters) until the
+	 * relative error of the volume of each cell found is below the requested value, or the maximum number
+	 * of points is reached. Volumes are tallied for each cell on the geometry (i.e. each path), and
+	 * accumulated for each user cell (all the instances) and for each material.
+	 */
+	class VolumeCalculator {
+
+	public:
+
+		/* Volume of a region */
+		struct Volume {
+			/* Estimated volume */
+			double value;
+			/* Standard deviation of the estimation */
+			double error;
+			Volume(double value = 0.0, double error = 0.0) : value(value), error(error) {/* */}
+			/* Relative error (zero if the region was not found) */
+			double relative() const {return (value > 0.0) ? error / value : 0.0;}
+		};
+
+		VolumeCalculator(const Geometry* geometry, const Coordinate& lower, const Coordinate& upper);
+
+		/*
+		 * Sample points until the relative error of each cell found is below the value requested. Returns
+		 * the number of points sampled (at most max_points, rounded up to the batch size).
+		 */
+		size_t calculate(const Random& r, double relative_error, size_t batch_size = 100000, size_t max_points = 100000000);
+
+		/* Volume of a cell on the geometry (one instance of a user cell) */
+		Volume getVolume(const Cell* cell) const;
+		/* Volume of all the instances of a user cell */
+		Volume getCellVolume(const CellId& cell) const;
+		/* Volume of all the cells filled with a material */
+		Volume getMaterialVolume(const Material* material) const;
+
+		/* Number of points sampled */
+		size_t getPoints() const {return npoints;}
+		/* Number of points outside the geometry */
+		size_t getOutside() const {return nhits.back();}
+
+		/* Print volumes of user cells, materials and each cell on the geometry */
+		void print(std::ostream& out) const;
+
+		~VolumeCalculator() {/* */}
+
+	private:
+
+		/* Tally of points found on each cell (the last counter are the points outside the geometry) */
+		class PointCounter {
+			const VolumeCalculator& calculator;
+			Random r;
+		public:
+			std::vector<size_t> nhits;
+			PointCounter(const VolumeCalculator& calculator, const Random& r);
+			PointCounter(PointCounter& other, tbb::split);
+			void operator() (const tbb::blocked_range<size_t>& range);
+			void join(const PointCounter& other);
+			~PointCounter() {/* */}
+		};
+
+		/* Estimation of the volume from a number of points */
+		Volume estimate(size_t hits) const;
+
+		/* Geometry */
+		const Geometry* geometry;
+		/* Box where the points are sampled */
+		Coordinate lower;
+		Coordinate upper;
+		/* Volume of the box */
+		double box_volume;
+		/* Number of points on each cell (indexed with the internal ID) */
+		std::vector<size_t> nhits;
+		/* Total number of points sampled */
+		size_t npoints;
+
+	};
+
+} /* namespace Helios */
+#endif /* VOLUMECALCULATOR_HPP_ */
@@ -44,9 +44,15 @@ using namespace Ace;
 namespace Helios {
 
 AceIsotopeBase* AceIsotopeFactory::createIsotope(const Ace::NeutronTable& table) const {
+	return createIsotope(table, pushGrid(table));
+}
+
+const ChildGrid* AceIsotopeFactory::pushGrid(const Ace::NeutronTable& table) const {
 	/* Create child grid */
-	const ChildGrid* child_grid = master_grid->pushGrid(table.getEnergyGrid().begin(), table.getEnergyGrid().end());
+	return master_grid->pushGrid(table.getEnergyGrid().begin(), table.getEnergyGrid().end());
+}
 
+AceIsotopeBase* AceIsotopeFactory::createIsotope(const Ace::NeutronTable& table, const ChildGrid* child_grid) const {
 	/* Get distribution of emerging particles from the NU-block */
 	const Ace::NUBlock* nu_block = table.block<NUBlock>();
 
@@ -99,23 +105,37 @@ AceIsotopeBase* AceIsotopeFactory::createIsotope(const Ace::NeutronTable& table)
 	return new AceIsotope<NonFissile>(table, child_grid);
 }
 
+/* Factory of ACE reactions */
+static const AceReaction::AceReactionFactory reaction_factory;
+
+/* Lock of the reactions of an isotope during a scope */
+class ReactionLock {
+	pthread_mutex_t& mutex;
+public:
+	ReactionLock(pthread_mutex_t& mutex) : mutex(mutex) {pthread_mutex_lock(&mutex);}
+	~ReactionLock() {pthread_mutex_unlock(&mutex);}
+};
+
 double AceIsotopeBase::energy_freegas_threshold = 400.0; /* By default, 400.0 kT*/
 double AceIsotopeBase::awr_freegas_threshold = 1.0;      /* By default, only H */
 
 AceIsotopeBase::AceIsotopeBase(const Ace::NeutronTable& _table, const ChildGrid* _child_grid) : Isotope(_table.getReactions().name()),
-	reactions(_table.getReactions()), aweight(reactions.awr()), temperature(reactions.temp()), child_grid(_child_grid),
+	aweight(_table.getReactions().awr()), temperature(_table.getReactions().temp()), child_grid(_child_grid),
 	secondary_sampler(0) {
 
+	pthread_mutex_init(&reaction_mutex,0);
+
+	/* Reactions on the table */
+	const ReactionContainer& table_reactions(_table.getReactions());
+
 	/* Total microscopic cross section of this isotope */
-	total_xs = reactions.get_xs(1);
+	total_xs = table_reactions.get_xs(1);
 
 	/* Elastic cross section */
-	elastic_xs = reactions.get_xs(2);
-	/* Set elastic reaction */
-	elastic_scattering = getReaction(2);
+	elastic_xs = table_reactions.get_xs(2);
 
 	/* Set the absorption cross section */
-	absorption_xs = reactions.get_xs(27);
+	absorption_xs = table_reactions.get_xs(27);
 	/* Check size */
 	if(absorption_xs.size() != 0) {
 		if(absorption_xs.size() != total_xs.size())
@@ -128,11 +148,28 @@ AceIsotopeBase::AceIsotopeBase(const Ace::NeutronTable& _table, const ChildGrid*
 	/* 	Calculate inelastic cross section */
 	inelastic_xs = total_xs - absorption_xs - elastic_xs;
 
+	/* Keep the ACE data of reactions with secondary particles, the rest can't be sampled */
+	for(Ace::ReactionContainer::const_iterator it = table_reactions.begin() ; it != table_reactions.end() ; ++it) {
+		int mt = (*it).getMt();
+		if(mt == 2 || (*it).getTyr().getTyr() != 0) {
+			/* Unsupported data is reported now, not when the reaction is sampled for the first time */
+			reaction_factory.checkReaction(this, *it);
+			reaction_index[mt] = ace_reactions.size();
+			ace_reactions.push_back(new NeutronReaction(*it));
+		}
+	}
+	reactions.resize(ace_reactions.size());
+	for(size_t i = 0 ; i < reactions.size() ; ++i)
+		reactions[i] = 0;
+
+	/* Set elastic reaction */
+	elastic_scattering = getReaction(2);
+
 	/* Array for the secondary particle reaction sampler */
-	vector<pair<Reaction*,const CrossSection*> > reaction_array;
+	vector<pair<size_t,const CrossSection*> > reaction_array;
 
 	/* Loop over the scattering reactions (skipping fission) */
-	for(Ace::ReactionContainer::const_iterator it = reactions.begin() ; it != reactions.end() ; ++it) {
+	for(Ace::ReactionContainer::const_iterator it = table_reactions.begin() ; it != table_reactions.end() ; ++it) {
 		/* Get angular distribution type */
 		int angular_data = (*it).getAngular().getKind();
 
@@ -142,16 +179,18 @@ AceIsotopeBase::AceIsotopeBase(const Ace::NeutronTable& _table, const ChildGrid*
 		/* Get MT of the reaction */
 		int mt = (*it).getMt();
 
-		/* We shouldn't include elastic and fission here */
+		/* We shouldn't include elastic and fission here (the reaction is created the first time is sampled) */
 		if((mt < 18 || mt > 21) && mt != 38 && mt != 2) {
-				/* Create reaction */
-				reaction_array.push_back(make_pair(getReaction(mt), &(*it).getXs()));
+			map<int,size_t>::const_iterator it_index = reaction_index.find(mt);
+			if(it_index == reaction_index.end())
+				throw(AceModule::AceError(getUserId(),"Reaction mt = " + toString(mt) + " doesn't produce secondary particles"));
+			reaction_array.push_back(make_pair((*it_index).second, &(*it).getXs()));
 		}
 	}
 
 	/* Create the sampler */
 	if(reaction_array.size() > 0)
-		secondary_sampler = new XsSampler<Reaction*>(reaction_array);
+		secondary_sampler = new XsSampler<size_t>(reaction_array);
 
 }
 
@@ -164,6 +203,20 @@ double AceIsotopeBase::getProb(Energy& energy, const Ace::CrossSection& xs) cons
 	return prob / total;
 }
 
+void AceIsotopeBase::setXs(Energy& energy, XsCache& cache) const {
+	double factor;
+	size_t idx = child_grid->index(energy,factor);
+	double total = factor * (total_xs[idx + 1] - total_xs[idx]) + total_xs[idx];
+	double absorption = factor * (absorption_xs[idx + 1] - absorption_xs[idx]) + absorption_xs[idx];
+	double elastic = factor * (elastic_xs[idx + 1] - elastic_xs[idx]) + elastic_xs[idx];
+	cache.absorption = absorption / total;
+	cache.elastic = elastic / total;
+	if(fissile) {
+		cache.fission = getFissionXs(energy) / total;
+		cache.isotope_nu_bar = getNuBar(energy);
+	}
+}
+
 double AceIsotopeBase::getAbsorptionProb(Energy& energy) const {
 	return getProb(energy, absorption_xs);
 }
@@ -193,48 +246,54 @@ Reaction* AceIsotopeBase::inelastic(Energy& energy, Random& random) const {
 	double factor;
 	size_t idx = child_grid->index(energy, factor);
 	double inel = factor * (inelastic_xs[idx + 1] - inelastic_xs[idx]) + inelastic_xs[idx];
-	return secondary_sampler->sample(idx, inel * random.uniform(), factor);
+	return buildReaction(secondary_sampler->sample(idx, inel * random.uniform(), factor));
 };
 
-Reaction* AceIsotopeBase::getReaction(InternalId mt) {
-	/* Static instance of the reaction factory */
-	static AceReaction::AceReactionFactory reaction_factory;
+Reaction* AceIsotopeBase::buildReaction(size_t index) const {
+	/* Check if the reaction was already created */
+	Reaction* reaction = reactions[index];
+	if(reaction) return reaction;
+
+	ReactionLock lock(reaction_mutex);
+	/* Another thread could have created it while we were waiting */
+	reaction = reactions[index];
+	if(!reaction) {
+		reaction = reaction_factory.createReaction(this, *ace_reactions[index]);
+		/* We don't need the ACE data anymore */
+		delete ace_reactions[index];
+		ace_reactions[index] = 0;
+		reactions[index] = reaction;
+	}
+	return reaction;
+}
 
+Reaction* AceIsotopeBase::getReaction(InternalId mt) {
 	/* Check on local map */
-	map<int,Reaction*>::const_iterator rea = reaction_map.find(mt);
-	if(rea != reaction_map.end())
-		return (*rea).second;
-
-	/* Get the reaction from the container */
-	ReactionContainer::const_iterator it_reaction = reactions.get_mt(mt);
+	map<int,size_t>::const_iterator it_index = reaction_index.find(mt);
 
-	if(it_reaction != reactions.end()) {
+	if(it_index != reaction_index.end())
 		/* Reaction exist */
-		const NeutronReaction& ace_reaction = (*it_reaction);
-		/* Return reaction */
-		Reaction* reaction = reaction_factory.createReaction(this, ace_reaction);
-		/* Push reaction into local map */
-		reaction_map[mt] = reaction;
-		/* And return it... */
-		return reaction;
-	} else {
+		return buildReaction((*it_index).second);
+	else
 		/* Reaction can't be found */
-		throw(AceModule::AceError(reactions.name(),"Reaction mt = " + toString(mt) + " does not exist"));
-	}
+		throw(AceModule::AceError(getUserId(),"Reaction mt = " + toString(mt) + " does not exist"));
 
 }
 
 void AceIsotopeBase::print(std::ostream& out) const {
-	out << "isotope = " <<  setw(9) << reactions.name()
+	out << "isotope = " <<  setw(9) << getUserId()
 		<< " ; awr = " << setw(9) << aweight << " ; temperature = " << temperature / Constant::boltz << " K ";
 }
 
 AceIsotopeBase::~AceIsotopeBase() {
-	/* Delete reactions */
-	for(map<int,Reaction*>::const_iterator it = reaction_map.begin() ; it != reaction_map.end() ; ++it)
-		delete (*it).second;
+	/* Delete reactions (and the ACE data of reactions that were never used) */
+	for(size_t i = 0 ; i < reactions.size() ; ++i) {
+		delete reactions[i];
+		delete ace_reactions[i];
+	}
 	/* Delete sampler */
 	delete secondary_sampler;
+	pthread_mutex_destroy(&reaction_mutex);
 };
 
 }
@@ -28,6 +28,11 @@
 #ifndef ACEISOTOPEBASE_HPP_
 #define ACEISOTOPEBASE_HPP_
 
+#include <map>
+#include <vector>
+#include <pthread.h>
+#include <tbb/atomic.h>
+
 #include "AceReader/ReactionContainer.hpp"
 #include "AceReader/NeutronTable.hpp"
 #include "AceReaction/NuSampler.hpp"
@@ -50,10 +55,10 @@ template<typename TypeReaction> class XsSampler;
 		/* Auxiliary function to get the probability of a reaction */
 		double getProb(Energy& energy, const Ace::CrossSection& xs) const;
 
-		/* -- General data */
+		/* Evaluate the reaction probabilities with a single lookup on the energy grid */
+		void setXs(Energy& energy, XsCache& cache) const;
 
-		/* Reference to a neutron container (obtained from the AceReader) */
-		Ace::ReactionContainer reactions;
+		/* -- General data */
 
 		/* Atomic weight ratio */
 		double aweight;
@@ -83,11 +88,26 @@ template<typename TypeReaction> class XsSampler;
 		/* Elastic reaction of this isotope. This reaction always exist */
 		Reaction* elastic_scattering;
 
-		/* Map of MT numbers and reactions */
-		std::map<int,Reaction*> reaction_map;
+		/*
+		 * Reactions are created from the ACE data the first time they are requested. The ACE
+		 * data of each reaction is released once the reaction is created.
+		 */
+		mutable std::vector<Ace::NeutronReaction*> ace_reactions;
+		mutable std::vector<tbb::atomic<Reaction*> > reactions;
+		/*
+		 * Protects the creation of reactions (particles are transported concurrently). Building the
+		 * tables of a reaction takes a while, so the other threads sleep meanwhile.
+		 */
+		mutable pthread_mutex_t reaction_mutex;
+
+		/* Map of MT numbers and index on the reaction containers */
+		std::map<int,size_t> reaction_index;
+
+		/* Secondary particle reaction sampler (using an interpolation factor), returns an index on the reaction containers */
+		XsSampler<size_t>* secondary_sampler;
 
-		/* Secondary particle reaction sampler (using an interpolation factor) */
-		XsSampler<Reaction*>* secondary_sampler;
+		/* Get a reaction from its index, creating it if is the first time is requested */
+		Reaction* buildReaction(size_t index) const;
 
 	public:
 
@@ -111,6 +131,10 @@ template<typename TypeReaction> class XsSampler;
 		/* Get total cross section */
 		double getTotalXs(Energy& energy) const;
 
+		/* Get the CHILD grid and the total cross section table (for vectorized lookups) */
+		const ChildGrid* getChildGrid() const {return child_grid;}
+		const Ace::CrossSection& getTotalTable() const {return total_xs;}
+
 		/* Fission treatment of the isotope */
 
 		/* Get fission probability */
@@ -132,8 +156,8 @@ template<typename TypeReaction> class XsSampler;
 		Reaction* inelastic(Energy& energy, Random& random) const;
 
 		/*
-		 * Get reaction from an MT number (thrown an exception if the reaction number does not exist)
-		 * Each created reaction is managed by the isotope.
+		 * Get reaction from an MT number (thrown an exception if the reaction number does not exist
+		 * or doesn't produce secondary particles). Each created reaction is managed by the isotope.
 		 */
 		Reaction* getReaction(InternalId mt);
 
@@ -153,6 +177,12 @@ template<typename TypeReaction> class XsSampler;
 		/* Returns an ACE isotope */
 		AceIsotopeBase* createIsotope(const Ace::NeutronTable& table) const;
 
+		/* Push the energy grid of a table into the master grid (should be called in a deterministic order) */
+		const ChildGrid* pushGrid(const Ace::NeutronTable& table) const;
+
+		/* Returns an ACE isotope on a grid already pushed into the master grid (can be called concurrently) */
+		AceIsotopeBase* createIsotope(const Ace::NeutronTable& table, const ChildGrid* child_grid) const;
+
 		~AceIsotopeFactory() {/* */}
 	};
 
@@ -33,6 +33,10 @@ using namespace Ace;
 
 namespace Helios {
 
+/* Static parameters of the vectorized loop */
+const size_t AceMaterial::lanes;
+const size_t AceMaterial::max_groups;
+
 static void normalize(map<string,double>& isotopes_fraction) {
 	map<string,double>::iterator it = isotopes_fraction.begin();
 	double total = 0.0;
@@ -104,7 +108,7 @@ double AceMaterial::setIsotopeMap(string& type, map<string,double> isotopes_frac
 
 AceMaterial::AceMaterial(const AceMaterialObject* definition) : Material(definition)
 		,master_grid(definition->getEnvironment()->getModule<AceModule>()->getMasterGrid())
-		,total_xs(master_grid->size(),0.0) {
+		,tabulated(true), isotope_sampler(0), group_size(lanes) {
 
 	/* Type of isotope fractions */
 	string type = definition->fraction;
@@ -133,106 +137,237 @@ AceMaterial::AceMaterial(const AceMaterialObject* definition) : Material(definit
 	} else
 		throw(Material::BadMaterialCreation(getUserId(),"Unit " + units + " not recognized in density"));
 
-	/* -- Setup the isotope sampler and the mean free path of the material */
-
-	/* Array for the isotope sampler */
-	vector<AceIsotopeBase*> isotope_array(isotope_map.size());
-	/* Container of fissile isotopes */
-	vector<AceIsotopeBase*> fissile_isotopes;
-	/* Arrays of XS of each isotope*/
-	vector<vector<double> > xs_array(isotope_map.size(), vector<double>(master_grid->size(),0.0));
-
-	/* Process data of each isotope */
+	/* -- Setup the isotope data of the material */
 	std::map<std::string,IsotopeData>::iterator iso = isotope_map.begin();
-	/* Isotope counter */
-	size_t counter = 0;
 	for(; iso != isotope_map.end() ; ++iso) {
 		/* Get isotope */
 		AceIsotopeBase* ace_isotope = (*iso).second.isotope;
+		/* Get atomic density */
+		double density = (*iso).second.atomic_fraction * atom;
+		/* Push isotope to the array */
+		isotope_array.push_back(ace_isotope);
+		isotope_density.push_back(density);
 		/* Check if there are fissile isotopes */
 		if(ace_isotope->isFissile()) {
 			/* Set the flag as true */
 			fissile = true;
 			/* Push the isotope in the container */
-			fissile_isotopes.push_back(ace_isotope);
+			fissile_array.push_back(ace_isotope);
+			fissile_density.push_back(density);
 		}
-		/* Get atomic density */
-		double density = (*iso).second.atomic_fraction * atom;
-		/* Push isotope to the array*/
-		isotope_array[counter] = ace_isotope;
-		/* Set the XS array for this isotope */
-		Energy energy(0,0.0);
-		for(size_t i = 0 ; i < master_grid->size() ; ++i) {
-			/* Set the energy and leave the index alone (faster interpolation) */
-			energy.second = (*master_grid)[i];
+	}
+
+	/* Big materials are evaluated on the fly, the rest is tabulated on the master grid */
+	size_t max_tabulated = definition->getEnvironment()->getSetting<size_t>("max_tabulated_isotopes","value");
+	tabulated = (isotope_array.size() <= max_tabulated);
+	if(tabulated)
+		setupTables();
+	else
+		setupArrays();
+}
+
+void AceMaterial::XsTable::setup(const vector<double>& dense) {
+	/* Get the range of non zero values */
+	size_t low = 0;
+	size_t high = dense.size();
+	while(low < high && dense[low] == 0.0) ++low;
+	while(high > low && dense[high - 1] == 0.0) --high;
+	/* Save values */
+	first = low;
+	vector<double>(dense.begin() + low, dense.begin() + high).swap(values);
+}
+
+void AceMaterial::setupTables() {
+	/* Dense total cross section (only during the setup) */
+	vector<double> dense_total(master_grid->size(), 0.0);
+
+	/* Set the isotope sampler */
+	isotope_sampler = new CompactSampler<AceIsotopeBase*>(isotope_array, master_grid->size());
+
+	/* Set the XS row of each isotope */
+	vector<double> xs_row(isotope_array.size());
+	Energy energy(0,0.0);
+	for(size_t i = 0 ; i < master_grid->size() ; ++i) {
+		/* Set the energy and leave the index alone (faster interpolation) */
+		energy.second = (*master_grid)[i];
+		for(size_t j = 0 ; j < isotope_array.size() ; ++j) {
 			/* Set isotope cross section on this material */
-			double total = density * ace_isotope->getTotalXs(energy);
-			xs_array[counter][i] = total;
+			double total = isotope_density[j] * isotope_array[j]->getTotalXs(energy);
+			xs_row[j] = total;
 			/* Contribution to the mean free path */
-			total_xs[i] += total;
+			dense_total[i] += total;
 		}
-		/* Increment isotope */
-		++counter;
+		isotope_sampler->setRow(i, xs_row);
 	}
-
-	/* Set the isotope sampler */
-	isotope_sampler = new FactorSampler<AceIsotopeBase*>(isotope_array, xs_array, false);
+	isotope_sampler->compact();
+	total_xs.setup(dense_total);
 
 	/* If the material is fissile, we should construct the related cross sections */
 	if(isFissile()) {
 		/* Prepare container */
-		nu_sigma_fission.resize(master_grid->size());
-		nu_bar.resize(master_grid->size());
-		/* Energy */
-		Energy energy(0,0.0);
+		vector<double> dense_nu_fission(master_grid->size());
 		for(size_t i = 0 ; i < master_grid->size() ; ++i) {
 			/* Set the energy and leave the index alone (faster interpolation) */
 			energy.second = (*master_grid)[i];
 			/* Accumulated total NU-fission cross section */
 			double nu_fission = 0.0;
 			/* Loop over the fissile isotopes */
-			for(vector<AceIsotopeBase*>::const_iterator iso = fissile_isotopes.begin() ; iso != fissile_isotopes.end() ; ++iso) {
-				/* Get density (atomic) */
-				double density = (*isotope_map.find((*iso)->getUserId())).second.atomic_fraction * atom;
-				/* Accumulate NU-fission */
-				nu_fission += density * (*iso)->getNuBar(energy) * (*iso)->getFissionXs(energy);
-			}
+			for(size_t j = 0 ; j < fissile_array.size() ; ++j)
+				nu_fission += fissile_density[j] * fissile_array[j]->getNuBar(energy) * fissile_array[j]->getFissionXs(energy);
 			/* Setup NU-fission cross section */
-			nu_sigma_fission[i] = nu_fission;
-			/* Setup average NU */
-			nu_bar[i] = nu_fission / total_xs[i];
+			dense_nu_fission[i] = nu_fission;
 		}
+		nu_sigma_fission.setup(dense_nu_fission);
 	}
 }
 
+void AceMaterial::setupArrays() {
+	for(size_t j = 0 ; j < isotope_array.size() ; ++j) {
+		const Ace::CrossSection& total = isotope_array[j]->getTotalTable();
+		/* The total cross section should be defined on the whole grid of the isotope */
+		if(total.getIndex() != 1 || total.size() != isotope_array[j]->getChildGrid()->size())
+			throw(Material::BadMaterialCreation(getUserId(),"Total cross section of isotope " +
+					isotope_array[j]->getUserId() + " is not defined on the whole energy grid"));
+		grid_set.push(isotope_array[j]->getChildGrid());
+		total_data.push_back(&total.getData()[0]);
+	}
+	/* Split the isotopes in groups of lanes */
+	size_t nlanes = (isotope_array.size() + lanes - 1) / lanes;
+	group_size = lanes * ((nlanes + max_groups - 1) / max_groups);
+}
+
+double AceMaterial::evalLanes(size_t key, double energy, size_t first, size_t count, double* xs) const {
+	/* Index and interpolation factor on each isotope grid */
+	size_t idx[lanes];
+	double factor[lanes];
+	grid_set.index(key, energy, first, count, idx, factor);
+	/* Interpolate the total cross sections */
+	double sum = 0.0;
+	#pragma omp simd reduction(+:sum)
+	for(size_t i = 0 ; i < count ; ++i) {
+		const double* data = total_data[first + i];
+		double low = data[idx[i]];
+		xs[i] = isotope_density[first + i] * (factor[i] * (data[idx[i] + 1] - low) + low);
+		sum += xs[i];
+	}
+	return sum;
+}
+
+double AceMaterial::evalTotalXs(Energy& energy, size_t& key, double* group_sums) const {
+	/* Key of the energy, shared by all the isotopes */
+	key = grid_set.key(energy);
+	double xs[lanes];
+	double total = 0.0;
+	size_t ngroup = 0;
+	for(size_t first = 0 ; first < isotope_array.size() ; first += group_size) {
+		size_t last = min(first + group_size, isotope_array.size());
+		double group = 0.0;
+		for(size_t i = first ; i < last ; i += lanes)
+			group += evalLanes(key, energy.second, i, min(lanes, last - i), xs);
+		group_sums[ngroup++] = group;
+		total += group;
+	}
+	return total;
+}
+
+double AceMaterial::evalNuFission(Energy& energy) const {
+	double nu_fission = 0.0;
+	for(size_t j = 0 ; j < fissile_array.size() ; ++j)
+		nu_fission += fissile_density[j] * fissile_array[j]->getNuBar(energy) * fissile_array[j]->getFissionXs(energy);
+	return nu_fission;
+}
+
 double AceMaterial::getMeanFreePath(Energy& energy) const {
+	if(!tabulated) {
+		size_t key;
+		double group_sums[max_groups];
+		return 1.0 / evalTotalXs(energy, key, group_sums);
+	}
 	double factor = master_grid->interpolate(energy);
-	size_t idx = energy.first;
-	double total = factor * (total_xs[idx + 1] - total_xs[idx]) + total_xs[idx];
-	return 1.0 / total;
+	return 1.0 / total_xs(energy.first, factor);
 }
 
 double AceMaterial::getNuFission(Energy& energy) const {
+	if(!tabulated)
+		return evalNuFission(energy);
 	double factor = master_grid->interpolate(energy);
-	size_t idx = energy.first;
-	double nu_fission = factor * (nu_sigma_fission[idx + 1] - nu_sigma_fission[idx]) + nu_sigma_fission[idx];
-	return nu_fission;
+	return nu_sigma_fission(energy.first, factor);
 }
 
 double AceMaterial::getNuBar(Energy& energy) const {
+	if(!tabulated) {
+		size_t key;
+		double group_sums[max_groups];
+		return evalNuFission(energy) / evalTotalXs(energy, key, group_sums);
+	}
+	/* Ratio of the interpolated cross sections (the same value evaluated on the fly) */
 	double factor = master_grid->interpolate(energy);
-	size_t idx = energy.first;
-	double nu = factor * (nu_bar[idx + 1] - nu_bar[idx]) + nu_bar[idx];
-	return nu;
+	return nu_sigma_fission(energy.first, factor) / total_xs(energy.first, factor);
+}
+
+const Isotope* AceMaterial::sampleIsotope(size_t key, double energy, double value, const double* group_sums) const {
+	/* Find the group of the isotope with the partial sums */
+	size_t first = 0;
+	double partial_sum = 0.0;
+	for(size_t ngroup = 0 ; first + group_size < isotope_array.size() ; ++ngroup, first += group_size) {
+		if(value <= partial_sum + group_sums[ngroup]) break;
+		partial_sum += group_sums[ngroup];
+	}
+	/* Evaluate again only the isotopes of this group */
+	size_t last = min(first + group_size, isotope_array.size());
+	double xs[lanes];
+	for(size_t i = first ; i < last ; i += lanes) {
+		size_t count = min(lanes, last - i);
+		evalLanes(key, energy, i, count, xs);
+		for(size_t j = 0 ; j < count ; ++j) {
+			partial_sum += xs[j];
+			if(value <= partial_sum) return isotope_array[i + j];
+		}
+	}
+	return isotope_array[last - 1];
 }
 
 const Isotope* AceMaterial::getIsotope(Energy& energy, Random& random) const {
+	if(!tabulated) {
+		size_t key;
+		double group_sums[max_groups];
+		double value = evalTotalXs(energy, key, group_sums) * random.uniform();
+		return sampleIsotope(key, energy.second, value, group_sums);
+	}
 	double factor = master_grid->interpolate(energy);
 	size_t idx = energy.first;
-	double total = factor * (total_xs[idx + 1] - total_xs[idx]) + total_xs[idx];
+	double total = total_xs(idx, factor);
 	return isotope_sampler->sample(idx,total * random.uniform(), factor);
 }
 
+void AceMaterial::setXs(Energy& energy, XsCache& cache) const {
+	if(!tabulated) {
+		cache.total = evalTotalXs(energy, cache.index, cache.group_sums);
+		cache.factor = 0.0;
+		if(isFissile()) {
+			cache.nu_fission = evalNuFission(energy);
+			cache.nu_bar = cache.nu_fission / cache.total;
+		}
+	} else {
+		cache.factor = master_grid->interpolate(energy);
+		cache.index = energy.first;
+		cache.total = total_xs(cache.index, cache.factor);
+		if(isFissile()) {
+			cache.nu_fission = nu_sigma_fission(cache.index, cache.factor);
+			cache.nu_bar = cache.nu_fission / cache.total;
+		}
+	}
+	cache.mfp = 1.0 / cache.total;
+}
+
+const Isotope* AceMaterial::getIsotope(Energy& energy, Random& random, const XsCache& cache) const {
+	double value = cache.total * random.uniform();
+	/* The partial sums of the groups were saved with the total cross section */
+	if(!tabulated)
+		return sampleIsotope(cache.index, energy.second, value, cache.group_sums);
+	return isotope_sampler->sample(cache.index, value, cache.factor);
+}
+
 AceMaterial::~AceMaterial() {
 	delete isotope_sampler;
 };
@@ -242,6 +377,11 @@ void AceMaterial::print(std::ostream& out) const {
 	/* Print material information */
 	out << Log::ident(1) << " - density = " << setw(9) << rho << " g/cm3 " << endl;
 	out << Log::ident(1) << " - density = " << setw(9) << atom << " atom/b-cm " << endl;
+	if(tabulated) {
+		size_t bytes = total_xs.size() + nu_sigma_fission.size() + isotope_sampler->size();
+		out << Log::ident(1) << " - tabulated cross sections (" << bytes / 1024 << " kb) " << endl;
+	} else
+		out << Log::ident(1) << " - cross sections evaluated on the fly " << endl;
 	/* Print isotope information */
 	std::map<std::string,IsotopeData>::const_iterator iso = isotope_map.begin();
 	for(; iso != isotope_map.end() ; ++iso)
@@ -30,7 +30,7 @@
 
 #include "AceModule.hpp"
 #include "../Material.hpp"
-#include "../../Common/FactorSampler.hpp"
+#include "../../Common/CompactSampler.hpp"
 
 namespace Helios {
 	class AceMaterialObject;
@@ -38,20 +38,90 @@ namespace Helios {
 
 	class AceMaterial : public Helios::Material {
 
+		/*
+		 * Values tabulated on the master grid. Only the range of indexes where the
+		 * values are different from zero is stored.
+		 */
+		class XsTable {
+			/* First index on the master grid */
+			size_t first;
+			/* Values on the range */
+			std::vector<double> values;
+			/* Get a value (zero outside of the range) */
+			double getValue(size_t idx) const {
+				if(idx < first || idx - first >= values.size()) return 0.0;
+				return values[idx - first];
+			}
+		public:
+			XsTable() : first(0) {/* */}
+			/* Keep the non zero range of a dense table */
+			void setup(const std::vector<double>& dense);
+			/* Interpolated value */
+			double operator()(size_t idx, double factor) const {
+				double low = getValue(idx);
+				double high = getValue(idx + 1);
+				return factor * (high - low) + low;
+			}
+			/* Memory used by the table (in bytes) */
+			size_t size() const {return values.size() * sizeof(double);}
+			~XsTable() {/* */}
+		};
+
 		/* Constant reference to a MASTER grid (managed by the AceModule) */
 		const MasterGrid* master_grid;
 
+		/*
+		 * Tabulated or evaluated on the fly. If the material has more isotopes than the
+		 * setting max_tabulated_isotopes, nothing is tabulated on the master grid and the
+		 * macroscopic cross sections are calculated from the isotopes on each call.
+		 */
+		bool tabulated;
+
 		/* Total cross section */
-		std::vector<double> total_xs;
+		XsTable total_xs;
 
 		/* NU-Fission cross section */
-		std::vector<double> nu_sigma_fission;
-
-		/* Average NU */
-		std::vector<double> nu_bar;
+		XsTable nu_sigma_fission;
 
 		/* Isotope sampler */
-		FactorSampler<AceIsotopeBase*>* isotope_sampler;
+		CompactSampler<AceIsotopeBase*>* isotope_sampler;
+
+		/* Isotopes and atomic densities */
+		std::vector<AceIsotopeBase*> isotope_array;
+		std::vector<double> isotope_density;
+		/* Fissile isotopes and atomic densities */
+		std::vector<AceIsotopeBase*> fissile_array;
+		std::vector<double> fissile_density;
+
+		/* -- Data used when the material is not tabulated (nuclide-major arrays) */
+
+		/* Grids of the isotopes */
+		ChildGridSet grid_set;
+		/* Total microscopic cross section of the isotopes */
+		std::vector<const double*> total_data;
+		/* Number of isotopes evaluated together on the vectorized loop */
+		static const size_t lanes = 8;
+		/* Maximum number of groups of isotopes (partial sums kept to sample an isotope) */
+		static const size_t max_groups = XsCache::max_groups;
+		/* Number of isotopes on each group */
+		size_t group_size;
+
+		/* Tabulate the cross sections on the master grid */
+		void setupTables();
+		/* Setup the arrays to evaluate the cross sections on the fly */
+		void setupArrays();
+
+		/* Macroscopic total cross section of the isotopes [first, first + count), saved on xs */
+		double evalLanes(size_t key, double energy, size_t first, size_t count, double* xs) const;
+		/* Total cross section evaluated from the isotopes, saving the partial sum of each group */
+		double evalTotalXs(Energy& energy, size_t& key, double* group_sums) const;
+		/* Sample an isotope from the partial sums of the groups (only the isotopes of one group are evaluated again) */
+		const Isotope* sampleIsotope(size_t key, double energy, double value, const double* group_sums) const;
+		/* NU-fission evaluated from the isotopes */
+		double evalNuFission(Energy& energy) const;
+
+		/* Evaluate all the macroscopic data with a single lookup on the energy grid */
+		void setXs(Energy& energy, XsCache& cache) const;
 
 		/* Density of the material */
 		double atom;   /* atom/b-cm*/
@@ -89,6 +159,7 @@ namespace Helios {
 
 		/* Sample the isotope */
 		const Isotope* getIsotope(Energy& energy, Random& random) const;
+		const Isotope* getIsotope(Energy& energy, Random& random, const XsCache& cache) const;
 
 		/* Return the atomic density of the material */
 		double getAtomicDensity() const {
@@ -25,6 +25,10 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <map>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
 #include "AceModule.hpp"
 #include "AceReader/ACEReader.hpp"
 #include "AceReader/NeutronTable.hpp"
@@ -39,6 +43,43 @@ using namespace Ace;
 
 namespace Helios {
 
+namespace {
+
+/* Read the neutron table of each isotope */
+class TableReader {
+	const vector<AceReader::XsdirEntry>& entries;
+	vector<NeutronTable*>& tables;
+public:
+	TableReader(const vector<AceReader::XsdirEntry>& entries, vector<NeutronTable*>& tables) :
+		entries(entries), tables(tables) {/* */}
+	void operator() (const tbb::blocked_range<size_t>& range) const {
+		for(size_t i = range.begin() ; i < range.end() ; ++i)
+			tables[i] = dynamic_cast<NeutronTable*>(AceReader::getTable(entries[i]));
+	}
+};
+
+/* Create each isotope from its neutron table (the table is deleted afterwards) */
+class IsotopeBuilder {
+	const AceIsotopeFactory& isotope_factory;
+	vector<NeutronTable*>& tables;
+	const vector<const ChildGrid*>& child_grids;
+	vector<AceIsotopeBase*>& isotopes;
+public:
+	IsotopeBuilder(const AceIsotopeFactory& isotope_factory, vector<NeutronTable*>& tables,
+			       const vector<const ChildGrid*>& child_grids, vector<AceIsotopeBase*>& isotopes) :
+		isotope_factory(isotope_factory), tables(tables), child_grids(child_grids), isotopes(isotopes) {/* */}
+	void operator() (const tbb::blocked_range<size_t>& range) const {
+		for(size_t i = range.begin() ; i < range.end() ; ++i) {
+			isotopes[i] = isotope_factory.createIsotope(*tables[i], child_grids[i]);
+			/* Delete table, we don't need it anymore */
+			delete tables[i];
+			tables[i] = 0;
+		}
+	}
+};
+
+}
+
 AceModule::AceModule(const std::vector<McObject*>& aceObjects, const McEnvironment* environment) : McModule(name(),environment) {
 	Log::bok() << "Initializing Ace Module " << Log::endl;
 	/* Try to get the location of the XS data from the environment */
@@ -48,33 +89,78 @@ AceModule::AceModule(const std::vector<McObject*>& aceObjects, const McEnvironme
 	/* Print information about the Ace reader */
 	Log::msg() << left << Log::ident(1) << " - Using xsdir from directory " << Ace::Conf::DATAPATH << Log::endl;
 
+	/* Directory of the binary cache of ACE tables */
+	if(environment->isSet("xs_cache"))
+		Ace::Conf::CACHEPATH = environment->getSetting<string>("xs_cache","value");
+	if(!Ace::Conf::CACHEPATH.empty())
+		Log::msg() << left << Log::ident(1) << " - Using binary ACE tables from directory " << Ace::Conf::CACHEPATH << Log::endl;
+
+	/* Type of lookup on the energy grid */
+	string grid_type = environment->getSetting<string>("energy_grid","value");
+	MasterGrid::GridType type;
+	if(grid_type == "unionized")
+		type = MasterGrid::UNIONIZED;
+	else if(grid_type == "hashed")
+		type = MasterGrid::HASHED;
+	else
+		throw(GeneralError("Energy grid type " + grid_type + " not recognized"));
+
+	Log::msg() << left << Log::ident(1) << " - Energy grid lookup : " << grid_type << Log::endl;
+
 	/* Create master grid */
-	master_grid = new MasterGrid();
+	master_grid = new MasterGrid(type);
 	/* Ace isotope factory */
 	AceIsotopeFactory isotope_factory(master_grid);
 
-	/* Loop over the definitions to create isotopes */
+	/*
+	 * Tables of the isotopes, in the same order as the definitions. Names that resolve to the same
+	 * entry of the xsdir file (i.e. a partial and a full name) share the isotope.
+	 */
+	vector<AceReader::XsdirEntry> entries;
+	map<AceReader::XsdirEntry,size_t> entry_index;
+	map<string,size_t> isotope_index;
 	for(vector<McObject*>::const_iterator it = aceObjects.begin() ; it != aceObjects.end() ; ++it) {
 		/* Cast to AceObject */
 		AceObject* ace_material = dynamic_cast<AceObject*>(*it);
 		string isotope = ace_material->table_name;
-		if (isotope_map.find(isotope) == isotope_map.end()) {
+		if(isotope_index.find(isotope) != isotope_index.end()) continue;
+		AceReader::XsdirEntry entry = AceReader::getEntry(isotope);
+		map<AceReader::XsdirEntry,size_t>::const_iterator it_entry = entry_index.find(entry);
+		if(it_entry == entry_index.end()) {
 			/* Print information about the isotope */
 			Log::msg() << left << Log::ident(2) << "  Reading isotope ";
-			Log::color<Log::COLOR_BOLDWHITE>() << isotope << Log::endl;
-			/* Get the neutron table using the AceReader */
-			NeutronTable* table = dynamic_cast<NeutronTable*>(AceReader::getTable(isotope));
-			/* Create isotope */
-			AceIsotopeBase* new_isotope = isotope_factory.createIsotope(*table);
-			/* Update the map */
-			isotope_map[isotope] = new_isotope;
-			/* Push isotope into the container */
-			isotopes.push_back(new_isotope);
-			/* Delete table, we don't need it anymore */
-			delete table;
+			Log::color<Log::COLOR_BOLDWHITE>() << entry.name << Log::endl;
+			it_entry = entry_index.insert(make_pair(entry, entries.size())).first;
+			entries.push_back(entry);
 		}
+		isotope_index[isotope] = (*it_entry).second;
 	}
 
+	/* Tables are independent, so they are read and processed concurrently */
+	vector<NeutronTable*> tables(entries.size(), 0);
+	vector<const ChildGrid*> child_grids(entries.size(), 0);
+	isotopes.resize(entries.size(), 0);
+	try {
+		/* Get the neutron tables using the AceReader */
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, entries.size()), TableReader(entries, tables));
+		/* The master grid is filled in the same order as the definitions */
+		for(size_t i = 0 ; i < tables.size() ; ++i)
+			child_grids[i] = isotope_factory.pushGrid(*tables[i]);
+		/* Create isotopes */
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, entries.size()), IsotopeBuilder(isotope_factory, tables, child_grids, isotopes));
+	} catch(...) {
+		for(size_t i = 0 ; i < tables.size() ; ++i) {
+			delete tables[i];
+			delete isotopes[i];
+		}
+		isotopes.clear();
+		throw;
+	}
+
+	/* Update the map */
+	for(map<string,size_t>::const_iterator it = isotope_index.begin() ; it != isotope_index.end() ; ++it)
+		isotope_map[(*it).first] = isotopes[(*it).second];
+
 	Log::msg() << left << Log::ident(1) << " - Setting up master grid " << Log::endl;
 	/* Setup master grid */
 	master_grid->setup();
@@ -104,15 +190,15 @@ std::vector<AceIsotopeBase*> AceModule::getObject<AceIsotopeBase>(const UserId&
 
 void AceModule::print(std::ostream& out) const {
 	out << " - Master grid size :" << master_grid->size() << endl;
-	for(map<IsotopeId,AceIsotopeBase*>::const_iterator it = isotope_map.begin() ; it != isotope_map.end() ; ++it)
-		out << " - " << *(*it).second << endl;
+	for(vector<AceIsotopeBase*>::const_iterator it = isotopes.begin() ; it != isotopes.end() ; ++it)
+		out << " - " << *(*it) << endl;
 	out << endl;
 }
 
 AceModule::~AceModule() {
-	/* Delete isotopes */
-	for(map<IsotopeId,AceIsotopeBase*>::iterator it = isotope_map.begin() ; it != isotope_map.end() ; ++it)
-		delete (*it).second;
+	/* Delete isotopes (some of them can be on the map with more than one name) */
+	for(vector<AceIsotopeBase*>::iterator it = isotopes.begin() ; it != isotopes.end() ; ++it)
+		delete (*it);
 	/* Delete master grid */
 	delete master_grid;
 }
@@ -55,6 +55,16 @@ static Reaction* getInelastic(int tyr_type, int tyr_number, const AceIsotopeBase
 			" is not supported"));
 }
 
+void AceReactionFactory::checkReaction(const AceIsotopeBase* isotope, const Ace::NeutronReaction& ace_reaction) const {
+	int mt = ace_reaction.getMt();
+	/* Elastic scattering and fission are always created with the isotope */
+	if(mt == 2 || ((mt > 17) && (mt < 22)) || mt == 38) return;
+	if(ace_reaction.getTyr().getTyr() == 0)
+		throw(AceModule::AceError(isotope->getUserId(),
+				"Reaction with mt = " + toString(mt) + " doesn't produce secondary particles"));
+	GenericReaction::checkReaction(isotope, ace_reaction);
+}
+
 Reaction* AceReactionFactory::createReaction(const AceIsotopeBase* isotope, const Ace::NeutronReaction& ace_reaction) const {
 	typedef Ace::AngularDistribution AceAngular;
 	/* Get MT of the reaction to handle known cases */
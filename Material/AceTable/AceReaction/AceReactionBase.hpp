@@ -41,6 +41,8 @@ namespace AceReaction {
 		AceReactionFactory() {/* */};
 		/* Create a new surface */
 		Reaction* createReaction(const AceIsotopeBase* isotope, const Ace::NeutronReaction& ace_reaction) const;
+		/* Check that a reaction can be created, without building its tables */
+		void checkReaction(const AceIsotopeBase* isotope, const Ace::NeutronReaction& ace_reaction) const;
 		virtual ~AceReactionFactory() {/* */}
 	};
 
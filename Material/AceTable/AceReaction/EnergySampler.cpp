@@ -34,6 +34,15 @@ namespace Helios {
 
 using namespace AceReaction;
 
+bool EnergySamplerFactory::isSupported(int law) {
+	/* Same laws created below */
+	switch(law) {
+	case 1 : case 3 : case 4 : case 7 : case 9 : case 11 : case 44 : case 61 : case 66 :
+		return true;
+	}
+	return false;
+}
+
 /* Create law */
 EnergySamplerBase* EnergySamplerFactory::createLaw(const Ace::EnergyDistribution::EnergyLaw* ace_law,
 		const Ace::NeutronReaction& ace_reaction) const {
@@ -71,6 +71,8 @@ namespace AceReaction {
 		const AceIsotopeBase* isotope;
 	public:
 		EnergySamplerFactory(const AceIsotopeBase* isotope) : isotope(isotope) {/* */}
+		/* Check if an energy law can be created (without creating it) */
+		static bool isSupported(int law);
 		/* Create law */
 		EnergySamplerBase* createLaw(const Ace::EnergyDistribution::EnergyLaw* ace_law, const Ace::NeutronReaction& ace_reaction) const;
 		/* Create a new energy sampler using information parsed from the ACE cross section file */
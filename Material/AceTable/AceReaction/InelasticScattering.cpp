@@ -64,6 +64,26 @@ EnergySamplerBase* GenericReaction::buildEnergySampler(const AceIsotopeBase* iso
 	return 0;
 }
 
+void GenericReaction::checkReaction(const AceIsotopeBase* isotope, const Ace::NeutronReaction& ace_reaction) {
+	typedef Ace::AngularDistribution AceAngular;
+	typedef Ace::EnergyDistribution AceEnergy;
+	string error;
+	/* Angular distribution */
+	int kind = ace_reaction.getAngular().getKind();
+	if(kind != AceAngular::data && kind != AceAngular::isotropic && kind != AceAngular::law44)
+		error = "No angular distribution defined";
+	/* Energy laws */
+	const AceEnergy& ace_energy = ace_reaction.getEnergy();
+	if(ace_energy.getKind() == AceEnergy::data) {
+		for(vector<AceEnergy::EnergyLaw*>::const_iterator it = ace_energy.laws.begin() ; it != ace_energy.laws.end() ; ++it)
+			if(not EnergySamplerFactory::isSupported((*it)->getLaw()))
+				error = EnergySamplerBase::BadEnergySamplerCreation("Energy law " + toString((*it)->getLaw()) + " is not supported").what();
+	}
+	if(error.size())
+		throw(AceModule::AceError(isotope->getUserId(),
+				"Cannot create reaction for mt = " + toString(ace_reaction.getMt()) + " : " + error));
+}
+
 GenericReaction::GenericReaction(const AceIsotopeBase* isotope, const Ace::NeutronReaction& ace_reaction) :
 		Reaction(ace_reaction.getMt()), mu_sampler(0), energy_sampler(0) {
 	/* Build MU sampler */
@@ -60,6 +60,10 @@ namespace AceReaction {
 		/* Build Energy Sampler */
 		static EnergySamplerBase* buildEnergySampler(const AceIsotopeBase* isotope, const Ace::NeutronReaction& ace_reaction);
 
+	public:
+		/* Check that the samplers of a reaction can be built (throws the same error the constructor does) */
+		static void checkReaction(const AceIsotopeBase* isotope, const Ace::NeutronReaction& ace_reaction);
+
 	protected:
 		/*
 		 * Function to sample phase space coordinates of the particle
@@ -28,6 +28,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <sstream>
 
 #include "ACEReader.hpp"
 #include "PrintMessage.hpp"
@@ -49,49 +50,87 @@ AceReader::AceReader() {
 	constructor_table["c"] = NeutronTable::NewTable;
 }
 
-AceTable* AceReader::getTable(const std::string& table_name) {
+void AceReader::readXsdir() {
 	string filename = Conf::DATAPATH + "/xsdir";
 	ifstream is( filename.c_str() );
-	string str="";
-	if (is.is_open()) {
+	if (!is.is_open())
+		throw(ACEReaderError("Could not open the file " + filename));
 
-		while ( is.good() ) {
-			getline(is,str);
-			if (iStringCompare(str,"directory")) break;
-		}
+	xsdir_entries.clear();
+	xsdir_index.clear();
 
-		while ( !is.eof() ) {
-			is >> str;
-			/* Obtain information for construct an ACETable Object */
-			if ( str.find(table_name) != string::npos ) {
-				double A; is >> A;
-				string file_name; is >> file_name;
-				string access_route; is >> access_route;
-				int file_type; is >> file_type;
-				size_t address; is >> address;
-				size_t table_length; is >> table_length;
-				string full_path = Conf::DATAPATH + "/" + file_name;
-
-				string letter = table_name.substr(table_name.size() - 1);
-
-				/* Find that letter on the table */
-				table_type::iterator it_type = ar.constructor_table.find(letter);
-
-				if(it_type != ar.constructor_table.end())
-					/* Return the table */
-					return ar.constructor_table[(*it_type).first](str,full_path,address);
-				else {
-					printMessage(PrintCodes::PrintWarning,"ACEReader::GetTable()",
-								 "Letter  " + letter + " is not associated to any ACE table supported. Sorry :-( ");
-					return 0;
-				}
-			}
+	string str="";
+	while ( is.good() ) {
+		getline(is,str);
+		if (iStringCompare(str,"directory")) break;
+	}
+
+	/* One line for each table (a "+" at the end of the line means that the entry continues on the next one) */
+	while ( getline(is,str) ) {
+		size_t last = str.find_last_not_of(" \t\r");
+		string next;
+		while ( last != string::npos && str[last] == '+' && getline(is,next) ) {
+			str = str.substr(0,last) + " " + next;
+			last = str.find_last_not_of(" \t\r");
 		}
 
-	} else
-		throw(ACEReaderError("Could not open the file " + filename));
+		/* Obtain information for construct an ACETable Object */
+		istringstream entry(str);
+		XsdirEntry new_entry;
+		double A;
+		string file_name, access_route;
+		int file_type;
+		if (entry >> new_entry.name >> A >> file_name >> access_route >> file_type >> new_entry.address) {
+			new_entry.full_path = Conf::DATAPATH + "/" + file_name;
+			/* Keep the first appearance of a table */
+			if(xsdir_index.find(new_entry.name) == xsdir_index.end())
+				xsdir_index[new_entry.name] = xsdir_entries.size();
+			xsdir_entries.push_back(new_entry);
+		}
+	}
 
 	is.close();
+	xsdir_path = Conf::DATAPATH;
+}
+
+AceReader::XsdirEntry AceReader::findEntry(const std::string& table_name) {
+	tbb::spin_mutex::scoped_lock lock(xsdir_mutex);
+	if(xsdir_path != Conf::DATAPATH || xsdir_entries.empty())
+		readXsdir();
+
+	map<string,size_t>::const_iterator it = xsdir_index.find(table_name);
+	if(it != xsdir_index.end())
+		return xsdir_entries[(*it).second];
+
+	/* Partial names (i.e. without the library suffix) are matched with the first table that contains it */
+	for(vector<XsdirEntry>::const_iterator it_entry = xsdir_entries.begin() ; it_entry != xsdir_entries.end() ; ++it_entry)
+		if((*it_entry).name.find(table_name) != string::npos)
+			return (*it_entry);
+
 	throw(ACEReaderError("Table  " + table_name + " could not be found on xsdir. "));
+}
+
+AceReader::XsdirEntry AceReader::getEntry(const std::string& table_name) {
+	return ar.findEntry(table_name);
+}
+
+AceTable* AceReader::getTable(const std::string& table_name) {
+	/* Location of the table */
+	return getTable(ar.findEntry(table_name));
+}
+
+AceTable* AceReader::getTable(const XsdirEntry& entry) {
+	string letter = entry.name.substr(entry.name.size() - 1);
+
+	/* Find that letter on the table */
+	table_type::const_iterator it_type = ar.constructor_table.find(letter);
 
+	if(it_type != ar.constructor_table.end())
+		/* Return the table */
+		return (*it_type).second(entry.name,entry.full_path,entry.address);
+	else {
+		printMessage(PrintCodes::PrintWarning,"ACEReader::GetTable()",
+					 "Letter  " + letter + " is not associated to any ACE table supported. Sorry :-( ");
+		return 0;
+	}
 }
@@ -31,11 +31,30 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ACETable.hpp"
 #include <map>
 #include <string>
+#include <vector>
+#include <tbb/spin_mutex.h>
 
 namespace Ace {
 
 	class AceReader {
 
+	public:
+
+		/* Location of a table, as listed on the xsdir file */
+		struct XsdirEntry {
+			std::string name;
+			std::string full_path;
+			size_t address;
+			/* Order of the entries (the same table has the same name, file and address) */
+			bool operator<(const XsdirEntry& other) const {
+				if(name != other.name) return name < other.name;
+				if(full_path != other.full_path) return full_path < other.full_path;
+				return address < other.address;
+			}
+		};
+
+	private:
+
 		/* Static instance of the reader */
 		static AceReader ar;
 
@@ -47,6 +66,20 @@ namespace Ace {
 		/* Map of a letter to table constructors */
 		table_type constructor_table;
 
+		/* Entries of the xsdir file (in the same order as the file) and index by table name */
+		std::vector<XsdirEntry> xsdir_entries;
+		std::map<std::string,size_t> xsdir_index;
+		/* Directory from which the index was built */
+		std::string xsdir_path;
+		/* Protects the lazy construction of the index (tables are read concurrently) */
+		tbb::spin_mutex xsdir_mutex;
+
+		/* Parse the xsdir file (once for each DATAPATH) */
+		void readXsdir();
+
+		/* Find a table on the index */
+		XsdirEntry findEntry(const std::string& table_name);
+
 	public:
 
 		/* Exception */
@@ -62,8 +95,12 @@ namespace Ace {
 			~ACEReaderError() throw() {/* */};
 		};
 
-		/* Get a ACE table object */
+		/* Find the location of a table on the xsdir file (the name can be partial) */
+		static XsdirEntry getEntry(const std::string& table_name);
+
+		/* Get a ACE table object (can be called concurrently) */
 		static AceTable* getTable(const std::string& table_name);
+		static AceTable* getTable(const XsdirEntry& entry);
 
 		virtual ~AceReader() {/* */};
 	};
@@ -30,32 +30,45 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <iomanip>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
+#include <sstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "ACETable.hpp"
 #include "Conf.hpp"
 #include "PrintMessage.hpp"
+#include "AceScanner.hpp"
 #include "AceUtils.hpp"
 
 using namespace std;
 using namespace Ace;
 
 AceTable::AceTable(const string& _table_name, const string& full_path, size_t address, int last_table) : table_name(_table_name){
-	/* File */
-	ifstream is(full_path.c_str());
-	size_t line_number = 0;
+	/* Skip the ASCII file if this table is already on the binary cache */
+	if(!last_table && !Conf::CACHEPATH.empty())
+		if(readCache(full_path,address)) return;
+
+	/* Map the file */
+	AceFile file(full_path);
 	/* Generic dummy data */
 	string line;
 
-	if ( is.is_open() ) {
+	if ( file.isOpen() ) {
 
-		while( !is.eof() && (line_number < address-1) ) {
-			is.ignore(Conf::MAXLINESIZE,'\n');
-			line_number++;
-		}
+		/* Beginning of the table */
+		const char* table_begin = file.seekLine(address);
 
-		if( is.eof() )
+		if( table_begin == file.end() )
 			throw(AceTableError(this,"Could not find the table name on file " + full_path));
 
+		/* The header (and the rest of the file for the last table) is parsed as a stream */
+		const char* header_end = last_table ? file.end() : skipLines(table_begin, file.end(), header_lines);
+		istringstream is(string(table_begin, header_end));
+
 		/* Verify the table name */
 		is >> line;
 		if (line.find(table_name) == string::npos)
@@ -86,9 +99,11 @@ AceTable::AceTable(const string& _table_name, const string& full_path, size_t ad
 
 		if(!last_table) {
 
-			/* Get the XSS array */
+			/* Get the XSS array, right after the JXS array */
+			streamoff xss_offset = is.tellg();
 			xss.resize(nxs[0]);
-			for (int i = 0 ; i < nxs[0] ; i++) is >> xss[i];
+			if(xss_offset < 0 || !scanXss(table_begin + xss_offset, file.end(), xss))
+				throw(AceTableError(this,"The XSS array is incomplete on file " + full_path));
 
 		} else {
 			/* 741158 */
@@ -134,7 +149,173 @@ AceTable::AceTable(const string& _table_name, const string& full_path, size_t ad
 	} else
 		throw(AceTableError(this,"Could not open the file " + full_path));
 
-	is.close();
+	/* Save the table for the next runs */
+	if(!last_table && !Conf::CACHEPATH.empty())
+		writeCache(full_path,address);
+}
+
+namespace {
+
+	/* Header of the binary ACE tables */
+	const char cache_magic[4] = {'H','A','C','E'};
+	const int cache_version = 1;
+
+	/* Name of the binary file of a table */
+	string cacheFile(const string& table_name) {
+		return Conf::CACHEPATH + "/" + table_name + ".bin";
+	}
+
+	/* Size and modification time of the ASCII file, used to detect stale tables on the cache */
+	bool sourceStamp(const string& full_path, long long& size, long long& mtime) {
+		struct stat st;
+		if(stat(full_path.c_str(),&st) != 0) return false;
+		size = st.st_size;
+		mtime = st.st_mtime;
+		return true;
+	}
+
+	/* Sequential reader over a mapped binary table */
+	class CacheCursor {
+		const char* ptr;
+		const char* end;
+	public:
+		CacheCursor(const char* begin, size_t size) : ptr(begin), end(begin + size) {/* */}
+		bool get(void* value, size_t nbytes) {
+			if((size_t)(end - ptr) < nbytes) return false;
+			memcpy(value,ptr,nbytes);
+			ptr += nbytes;
+			return true;
+		}
+		template<class T>
+		bool get(T& value) {
+			return get(&value,sizeof(T));
+		}
+		bool get(string& str) {
+			long long nchar;
+			if(!get(nchar) || nchar < 0 || (size_t)(end - ptr) < (size_t)nchar) return false;
+			str.assign(ptr,nchar);
+			ptr += nchar;
+			return true;
+		}
+		bool empty() const {return ptr == end;}
+	};
+
+	template<class T>
+	void putCache(ostream& out, const T& value) {
+		out.write(reinterpret_cast<const char*>(&value),sizeof(T));
+	}
+	void putCache(ostream& out, const string& str) {
+		long long nchar = str.size();
+		putCache(out,nchar);
+		out.write(str.data(),nchar);
+	}
+
+}
+
+bool AceTable::readCache(const string& full_path, size_t address) {
+	long long src_size, src_mtime;
+	if(!sourceStamp(full_path,src_size,src_mtime)) return false;
+
+	int fd = open(cacheFile(table_name).c_str(),O_RDONLY);
+	if(fd < 0) return false;
+	struct stat st;
+	if(fstat(fd,&st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	size_t map_size = st.st_size;
+	void* map = mmap(0,map_size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+	if(map == MAP_FAILED) return false;
+
+	CacheCursor cursor(static_cast<const char*>(map),map_size);
+	bool valid = true;
+
+	/* Check that this binary table was produced from the same ASCII table */
+	char magic[4];
+	int version;
+	long long size, mtime, addr;
+	string name;
+	valid = valid && cursor.get(magic,4) && !memcmp(magic,cache_magic,4);
+	valid = valid && cursor.get(version) && version == cache_version;
+	valid = valid && cursor.get(size) && size == src_size;
+	valid = valid && cursor.get(mtime) && mtime == src_mtime;
+	valid = valid && cursor.get(addr) && addr == (long long)address;
+	valid = valid && cursor.get(name) && name == table_name;
+
+	/* Table data */
+	long long nxss = 0;
+	valid = valid && cursor.get(aweight) && cursor.get(temperature);
+	valid = valid && cursor.get(date) && cursor.get(comment);
+	valid = valid && cursor.get(iz,sizeof(iz)) && cursor.get(aw,sizeof(aw));
+	valid = valid && cursor.get(nxs,sizeof(nxs)) && cursor.get(jxs,sizeof(jxs));
+	valid = valid && cursor.get(nxss) && nxss == nxs[0] && nxss >= 0;
+	if(valid) {
+		/* One bulk copy of the XSS array from the mapped file */
+		xss.resize(nxss);
+		valid = (!nxss || cursor.get(&xss[0],nxss * sizeof(double))) && cursor.empty();
+	}
+
+	munmap(map,map_size);
+	if(!valid) xss.clear();
+	return valid;
+}
+
+void AceTable::writeCache(const string& full_path, size_t address) const {
+	long long src_size, src_mtime;
+	if(!sourceStamp(full_path,src_size,src_mtime)) return;
+
+	/*
+	 * Write on a temporary file and rename, so concurrent readers never see a partial table. The name of
+	 * the temporary file is unique, so threads and processes writing the same table don't collide.
+	 */
+	string file = cacheFile(table_name);
+	vector<char> tmp_name(file.begin(), file.end());
+	const char suffix[] = ".XXXXXX";
+	tmp_name.insert(tmp_name.end(), suffix, suffix + sizeof(suffix));
+	int fd = mkstemp(&tmp_name[0]);
+	if(fd < 0) {
+		printMessage(PrintCodes::PrintWarning,"AceTable::writeCache()",
+				     "Could not write the binary table " + file);
+		return;
+	}
+	/* The cache can be shared with other users */
+	fchmod(fd,0644);
+	close(fd);
+	string tmp(&tmp_name[0]);
+
+	ofstream out(tmp.c_str(), ios::binary | ios::trunc);
+	if(!out.is_open()) {
+		remove(tmp.c_str());
+		printMessage(PrintCodes::PrintWarning,"AceTable::writeCache()",
+				     "Could not write the binary table " + file);
+		return;
+	}
+
+	out.write(cache_magic,4);
+	putCache(out,cache_version);
+	putCache(out,src_size);
+	putCache(out,src_mtime);
+	putCache(out,(long long)address);
+	putCache(out,table_name);
+	putCache(out,aweight);
+	putCache(out,temperature);
+	putCache(out,date);
+	putCache(out,comment);
+	out.write(reinterpret_cast<const char*>(iz),sizeof(iz));
+	out.write(reinterpret_cast<const char*>(aw),sizeof(aw));
+	out.write(reinterpret_cast<const char*>(nxs),sizeof(nxs));
+	out.write(reinterpret_cast<const char*>(jxs),sizeof(jxs));
+	long long nxss = xss.size();
+	putCache(out,nxss);
+	if(nxss) out.write(reinterpret_cast<const char*>(&xss[0]),nxss * sizeof(double));
+	out.close();
+
+	if(!out || rename(tmp.c_str(),file.c_str()) != 0) {
+		remove(tmp.c_str());
+		printMessage(PrintCodes::PrintWarning,"AceTable::writeCache()",
+				     "Could not write the binary table " + file);
+	}
 }
 
 /* Print general information of the library */
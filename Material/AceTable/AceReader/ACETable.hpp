@@ -44,6 +44,8 @@ namespace Ace {
 		static const int jxs_size=32;
 		static const int iz_size=16;
 		static const int aw_size=16;
+		/* Lines of the header (names, IZ/AW, NXS and JXS arrays) */
+		static const int header_lines=12;
 
 		class ACEBlock {
 
@@ -155,6 +157,14 @@ namespace Ace {
 		/* Constructor, from full path and address on that file */
 		AceTable(const std::string& _table_name, const std::string& full_path, size_t address, int last_table = 0);
 
+		/* ---------- Binary cache of tables (on Conf::CACHEPATH) */
+
+		/* Load the table from the binary cache, returns false if there isn't a valid one for this source */
+		bool readCache(const std::string& full_path, size_t address);
+
+		/* Save the table on the binary cache (failures are not fatal) */
+		void writeCache(const std::string& full_path, size_t address) const;
+
 	public:
 
 		/* Exception */
@@ -0,0 +1,300 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstring>
+#include <cstdlib>
+#include <map>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <tbb/spin_mutex.h>
+
+#include "AceScanner.hpp"
+
+using namespace std;
+
+namespace Ace {
+
+namespace {
+
+	/* Byte offset of every AceFile::line_stride lines of a file */
+	struct LineIndex {
+		size_t file_size;
+		vector<size_t> offsets;
+		/* Building the index takes a pass over the whole file, so the other readers of the file sleep meanwhile */
+		pthread_mutex_t mutex;
+		LineIndex() : file_size(0) {pthread_mutex_init(&mutex,0);}
+		~LineIndex() {pthread_mutex_destroy(&mutex);}
+	private:
+		/* Prevent copy */
+		LineIndex(const LineIndex& other);
+		LineIndex& operator=(const LineIndex& other);
+	};
+
+	/* Lock of the index of a file during a scope */
+	class IndexLock {
+		pthread_mutex_t& mutex;
+	public:
+		IndexLock(LineIndex& index) : mutex(index.mutex) {pthread_mutex_lock(&mutex);}
+		~IndexLock() {pthread_mutex_unlock(&mutex);}
+	};
+
+	/* Index of each file read (tables are read concurrently, the map is only locked to find a file) */
+	class LineIndexMap {
+		map<string,LineIndex*> indexes;
+		tbb::spin_mutex mutex;
+	public:
+		LineIndex& get(const string& path) {
+			tbb::spin_mutex::scoped_lock lock(mutex);
+			LineIndex*& index = indexes[path];
+			if(!index) index = new LineIndex;
+			return *index;
+		}
+		~LineIndexMap() {
+			for(map<string,LineIndex*>::iterator it = indexes.begin() ; it != indexes.end() ; ++it)
+				delete (*it).second;
+		}
+	};
+	LineIndexMap line_index;
+
+	/* Exact powers of ten on a double */
+	const double exact_powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+	const int max_exact_power = 22;
+	/* Maximum significant digits that fit exactly on the mantissa of a double */
+	const int max_exact_digits = 15;
+
+	/* Below this number of values the XSS array is parsed on a single thread */
+	const size_t parallel_xss = 1 << 17;
+	/* Size of the text parsed by each task */
+	const size_t chunk_bytes = 1 << 20;
+
+	inline bool isSpace(char c) {
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+	}
+
+	inline bool isDigit(char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	inline const char* skipSpace(const char* pos, const char* end) {
+		while(pos != end && isSpace(*pos)) ++pos;
+		return pos;
+	}
+
+	/* Parse all the numbers on a range of text */
+	bool scanAll(const char* pos, const char* end, vector<double>& values) {
+		double value;
+		for(pos = skipSpace(pos,end) ; pos != end ; pos = skipSpace(pos,end)) {
+			pos = scanNumber(pos,end,value);
+			if(!pos) return false;
+			values.push_back(value);
+		}
+		return true;
+	}
+
+	/* Parse chunks of the XSS array */
+	class ChunkScanner {
+		const vector<const char*>& bounds;
+		vector<vector<double> >& values;
+		vector<char>& valid;
+	public:
+		ChunkScanner(const vector<const char*>& bounds, vector<vector<double> >& values, vector<char>& valid) :
+			bounds(bounds), values(values), valid(valid) {/* */}
+		void operator() (const tbb::blocked_range<size_t>& range) const {
+			for(size_t i = range.begin() ; i < range.end() ; ++i) {
+				/* Numbers are written with 20 characters */
+				values[i].reserve((bounds[i + 1] - bounds[i]) / 20 + 1);
+				valid[i] = scanAll(bounds[i],bounds[i + 1],values[i]);
+			}
+		}
+	};
+
+}
+
+AceFile::AceFile(const string& path) : data(0), data_size(0), path(path) {
+	int fd = open(path.c_str(),O_RDONLY);
+	if(fd < 0) return;
+	struct stat st;
+	if(fstat(fd,&st) == 0 && st.st_size > 0) {
+		void* map = mmap(0,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+		if(map != MAP_FAILED) {
+			data = static_cast<const char*>(map);
+			data_size = st.st_size;
+			madvise(map,data_size,MADV_SEQUENTIAL);
+		}
+	}
+	close(fd);
+}
+
+const char* AceFile::seekLine(size_t line) const {
+	if(line <= 1) return begin();
+	size_t start, remaining;
+	{
+		LineIndex& index = line_index.get(path);
+		IndexLock lock(index);
+		/* Build the index the first time the file is read (or if it has changed) */
+		if(index.offsets.empty() || index.file_size != data_size) {
+			index.offsets.assign(1,0);
+			index.file_size = data_size;
+			size_t nlines = 0;
+			for(const char* pos = begin() ; (pos = static_cast<const char*>(memchr(pos,'\n',end() - pos))) != 0 ; ) {
+				++pos;
+				if(++nlines % line_stride == 0) index.offsets.push_back(pos - begin());
+			}
+		}
+		size_t checkpoint = min((line - 1) / line_stride, index.offsets.size() - 1);
+		start = index.offsets[checkpoint];
+		remaining = (line - 1) - checkpoint * line_stride;
+	}
+	return skipLines(begin() + start, end(), remaining);
+}
+
+AceFile::~AceFile() {
+	if(data) munmap(const_cast<char*>(data),data_size);
+}
+
+const char* skipLines(const char* pos, const char* end, size_t nlines) {
+	for(size_t i = 0 ; i < nlines ; ++i) {
+		const char* eol = static_cast<const char*>(memchr(pos,'\n',end - pos));
+		if(!eol) return end;
+		pos = eol + 1;
+	}
+	return pos;
+}
+
+const char* scanNumber(const char* pos, const char* end, double& value) {
+	pos = skipSpace(pos,end);
+	const char* start = pos;
+
+	/* Sign */
+	bool negative = false;
+	if(pos != end && (*pos == '+' || *pos == '-')) {
+		negative = (*pos == '-');
+		++pos;
+	}
+
+	/* Mantissa, as an integer and a decimal exponent */
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool any_digit = false;
+	bool exact = true;
+	for( ; pos != end && isDigit(*pos) ; ++pos) {
+		any_digit = true;
+		if(digits < max_exact_digits) {
+			mantissa = 10 * mantissa + (*pos - '0');
+			if(mantissa) digits++;
+		} else
+			exact = false;
+	}
+	if(pos != end && *pos == '.') {
+		for(++pos ; pos != end && isDigit(*pos) ; ++pos) {
+			any_digit = true;
+			if(digits < max_exact_digits) {
+				mantissa = 10 * mantissa + (*pos - '0');
+				if(mantissa) digits++;
+				exponent--;
+			} else
+				exact = false;
+		}
+	}
+	if(!any_digit) return 0;
+
+	/* Exponent */
+	if(pos != end && (*pos == 'e' || *pos == 'E')) {
+		++pos;
+		bool negative_exponent = false;
+		if(pos != end && (*pos == '+' || *pos == '-')) {
+			negative_exponent = (*pos == '-');
+			++pos;
+		}
+		int power = 0;
+		for( ; pos != end && isDigit(*pos) ; ++pos)
+			if(power < 10000) power = 10 * power + (*pos - '0');
+		exponent += negative_exponent ? -power : power;
+	}
+
+	if(exact && exponent >= -max_exact_power && exponent <= max_exact_power) {
+		/* Both operands are exact, so a single operation gives the correctly rounded value */
+		double number = static_cast<double>(mantissa);
+		number = (exponent < 0) ? number / exact_powers[-exponent] : number * exact_powers[exponent];
+		value = negative ? -number : number;
+	} else
+		value = strtod(string(start,pos).c_str(),0);
+
+	return pos;
+}
+
+bool scanXss(const char* pos, const char* end, vector<double>& xss) {
+	size_t count = xss.size();
+
+	if(count >= parallel_xss) {
+		/* The XSS array starts on the next line, with 4 numbers per line */
+		const char* xss_end = skipLines(pos, end, 1 + (count + 3) / 4);
+
+		/* Split the text on lines */
+		size_t nchunks = (xss_end - pos) / chunk_bytes + 1;
+		vector<const char*> bounds(1,pos);
+		for(size_t i = 1 ; i < nchunks ; ++i) {
+			const char* bound = skipLines(pos + i * (xss_end - pos) / nchunks, xss_end, 1);
+			if(bound > bounds.back()) bounds.push_back(bound);
+		}
+		bounds.push_back(xss_end);
+
+		vector<vector<double> > values(bounds.size() - 1);
+		vector<char> valid(bounds.size() - 1);
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, values.size()), ChunkScanner(bounds, values, valid));
+
+		/* If the layout is not the expected one, parse the array on a single thread */
+		size_t total = 0;
+		bool all_valid = true;
+		for(size_t i = 0 ; i < values.size() ; ++i) {
+			total += values[i].size();
+			all_valid = all_valid && valid[i];
+		}
+		if(all_valid && total == count) {
+			vector<double>::iterator it = xss.begin();
+			for(size_t i = 0 ; i < values.size() ; ++i)
+				it = copy(values[i].begin(), values[i].end(), it);
+			return true;
+		}
+	}
+
+	for(size_t i = 0 ; i < count ; ++i) {
+		pos = scanNumber(pos,end,xss[i]);
+		if(!pos) return false;
+	}
+	return true;
+}
+
+} /* namespace Ace */
@@ -0,0 +1,85 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ACESCANNER_HPP_
+#define ACESCANNER_HPP_
+
+#include <string>
+#include <vector>
+
+namespace Ace {
+
+	/* Read only mapping of an ASCII ACE file */
+	class AceFile {
+		const char* data;
+		size_t data_size;
+		std::string path;
+
+		/* Prevent copy */
+		AceFile(const AceFile& other);
+		AceFile& operator=(const AceFile& other);
+
+	public:
+		/* Lines between two consecutive byte offsets on the index of a file */
+		static const size_t line_stride = 1024;
+
+		AceFile(const std::string& path);
+
+		/* Check if the file could be mapped */
+		bool isOpen() const {return data != 0;}
+
+		/* Range of the file */
+		const char* begin() const {return data;}
+		const char* end() const {return data + data_size;}
+
+		/*
+		 * Beginning of a line (the first one is 1), or end() if the file is shorter. The byte
+		 * offsets of the lines are computed once for each file and shared by all the tables on it.
+		 */
+		const char* seekLine(size_t line) const;
+
+		~AceFile();
+	};
+
+	/* Skip a number of lines, returns the beginning of the next one (or end) */
+	const char* skipLines(const char* pos, const char* end, size_t nlines);
+
+	/*
+	 * Parse the next number on [pos,end), returns the position after it or 0 if there isn't a number.
+	 * The value is the same as the one read with the operator >> of an input stream.
+	 */
+	const char* scanNumber(const char* pos, const char* end, double& value);
+
+	/*
+	 * Parse the XSS array starting at pos. Large arrays are split by lines and parsed on
+	 * several threads. Returns false if the file doesn't contain all the numbers.
+	 */
+	bool scanXss(const char* pos, const char* end, std::vector<double>& xss);
+
+} /* namespace Ace */
+
+#endif /* ACESCANNER_HPP_ */
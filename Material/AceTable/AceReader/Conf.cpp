@@ -36,6 +36,7 @@ using namespace Ace;
 /* Initialization of static members of the Conf class */
 unsigned char Ace::Conf::ShowWarnings;
 string Ace::Conf::DATAPATH;
+string Ace::Conf::CACHEPATH;
 size_t Ace::Conf::MAXLINESIZE;
 
 /* Create a global and unique instance of the configuration class */
@@ -54,5 +55,11 @@ Ace::Conf::Conf() {
 	/* Check if the DATAPATH variable is set */
 	if(datapath)
 		DATAPATH = string(datapath);
+
+	/* Get CACHEPATH variable */
+	char* cachepath = getenv("HELIOS_XS_CACHE");
+	/* Check if the CACHEPATH variable is set */
+	if(cachepath)
+		CACHEPATH = string(cachepath);
 }
 
@@ -26,6 +26,8 @@ namespace Ace {
 		static unsigned char ShowWarnings;
 		/* PATH to the xsdir file */
 		static std::string DATAPATH;
+		/* PATH to the directory of binary ACE tables (empty to disable the cache) */
+		static std::string CACHEPATH;
 		/* max characters on a line */
 		static size_t MAXLINESIZE;
 	};
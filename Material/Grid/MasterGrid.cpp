@@ -26,6 +26,7 @@
  */
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 
 #include "MasterGrid.hpp"
 #include "../../Common/Common.hpp"
@@ -36,20 +37,46 @@ namespace Helios {
 
 /* By default, 10000 points are reserved for the grid */
 size_t MasterGrid::reserve_grid = 10000;
+/* By default, 8192 equal lethargy bins on the hash table */
+size_t MasterGrid::hash_bins = 8192;
 
-MasterGrid::MasterGrid(){
+MasterGrid::MasterGrid(GridType type) : type(type), log_min(0.0), inv_delta(0.0) {
 	/* Reserve space for the grids */
 	master_grid.reserve(reserve_grid);
 };
 
+void MasterGrid::setupHash(const vector<double>& grid, vector<size_t>& hash) const {
+	/* Count the points that fall on each bin */
+	hash.assign(hash_bins + 1, 0);
+	for(vector<double>::const_iterator it = grid.begin() ; it != grid.end() ; ++it)
+		hash[bin(*it) + 1]++;
+	/* Accumulate, so each entry points to the first value of the bin */
+	for(size_t i = 0 ; i < hash_bins ; ++i)
+		hash[i + 1] += hash[i];
+}
+
 void MasterGrid::setup() {
 	/* Setup MASTER grid */
 	sort(master_grid.begin(), master_grid.end());
 	vector<double>::const_iterator it_master = unique(master_grid.begin(), master_grid.end());
 	master_grid.resize(it_master - master_grid.begin());
 
+	/* Bug catcher, the logarithmic hash only works with positive values */
+	assert(master_grid[0] > 0.0);
+
+	/* Equal lethargy bins between the limits of the master grid */
+	log_min = log(master_grid[0]);
+	inv_delta = (double)hash_bins / (log(master_grid[master_grid.size() - 1]) - log_min);
+	setupHash(master_grid, master_hash);
+
 	/* Setup child grids */
 	for(vector<ChildGrid*>::const_iterator it = child_grids.begin() ; it != child_grids.end() ; ++it) {
+		if(type == HASHED) {
+			/* Each child gets its own hash table, no pointers from the master grid */
+			setupHash((*it)->child_grid, (*it)->child_hash);
+			continue;
+		}
+
 		/* Create master array of pointers */
 		vector<size_t> master_pointers(size());
 
@@ -106,12 +133,8 @@ double MasterGrid::interpolate(pair<size_t,double>& pair_value) const {
 		/* Don't touch the index and return the factor */
 		return (energy - low_energy) / (high_energy - low_energy);
 	} else {
-		/* Search boundaries */
-		vector<double>::const_iterator begin = master_grid.begin();
-		vector<double>::const_iterator end = master_grid.end();
-
 		/* Update index */
-		pair_value.first = upper_bound(begin, end, energy) - master_grid.begin() - 1;
+		pair_value.first = search(master_grid, master_hash, energy);
 
 		/* Energy bounds */
 		double low = master_grid[pair_value.first];
@@ -147,13 +170,9 @@ void MasterGrid::setIndex(std::pair<size_t,double>& pair_value) const {
 	double high_energy = master_grid[pair_value.first + 1];
 
 	/* Check if the index is in the right place */
-	if(not (energy >= low_energy && energy <= high_energy)) {
-		/* Search boundaries */
-		vector<double>::const_iterator begin = master_grid.begin();
-		vector<double>::const_iterator end = master_grid.end();
+	if(not (energy >= low_energy && energy <= high_energy))
 		/* Update index */
-		pair_value.first = upper_bound(begin, end, energy) - master_grid.begin() - 1;
-	}
+		pair_value.first = search(master_grid, master_hash, energy);
 }
 
 size_t MasterGrid::index(const double& value, double& factor) const {
@@ -192,6 +211,7 @@ vector<double> MasterGrid::interpolate(const vector<double>& grid, const vector<
 void MasterGrid::print(ostream& out) const {
 	out << Log::ident(1) << "Master grid" << endl;
 	out << Log::ident(2) << " - Size of the master grid : " << master_grid.size() << endl;
+	out << Log::ident(2) << " - Type of lookup          : " << ((type == HASHED) ? "hashed" : "unionized") << endl;
 	out << Log::ident(1) << "Master grid : " << scientific << endl;
 	copy(master_grid.begin(), master_grid.end(), ostream_iterator<double>(out," , "));
 }
@@ -224,9 +244,15 @@ size_t ChildGrid::index(std::pair<size_t,double>& pair_value, double& factor) co
 		return child_grid.size() - 2;
 	}
 
-	/* Get index from master grid */
-	master_grid->setIndex(pair_value);
-	size_t child_index = master_pointers[pair_value.first];
+	size_t child_index;
+	if(master_grid->type == MasterGrid::HASHED)
+		/* Search on the child grid, bounded by the hash table */
+		child_index = master_grid->search(child_grid, child_hash, energy);
+	else {
+		/* Get index from master grid */
+		master_grid->setIndex(pair_value);
+		child_index = master_pointers[pair_value.first];
+	}
 	/* Energy bounds */
 	double low_energy = child_grid[child_index];
 	double high_energy = child_grid[child_index + 1];
@@ -241,8 +267,63 @@ void ChildGrid::print(std::ostream& out) const {
 	out << Log::ident(1) << "Child grid : " << scientific << endl;
 	copy(child_grid.begin(), child_grid.end(), ostream_iterator<double>(out," , "));
 	out << endl;
-	out << Log::ident(1) << "Master pointers : " << dec << endl;
-	copy(master_pointers.begin(), master_pointers.end(), ostream_iterator<size_t>(out," , "));
+	if(master_grid->type == MasterGrid::HASHED) {
+		out << Log::ident(1) << "Hash table : " << dec << endl;
+		copy(child_hash.begin(), child_hash.end(), ostream_iterator<size_t>(out," , "));
+	} else {
+		out << Log::ident(1) << "Master pointers : " << dec << endl;
+		copy(master_pointers.begin(), master_pointers.end(), ostream_iterator<size_t>(out," , "));
+	}
+}
+
+void ChildGridSet::push(const ChildGrid* child_grid) {
+	/* Sanity check */
+	assert(!master_grid || master_grid == child_grid->master_grid);
+	master_grid = child_grid->master_grid;
+	/* Save data of the grid */
+	grids.push_back(&child_grid->child_grid[0]);
+	last.push_back(child_grid->size() - 1);
+	if(master_grid->type == MasterGrid::HASHED)
+		tables.push_back(&child_grid->child_hash[0]);
+	else
+		tables.push_back(&child_grid->master_pointers[0]);
+}
+
+size_t ChildGridSet::key(std::pair<size_t,double>& pair_value) const {
+	if(master_grid->type == MasterGrid::HASHED) {
+		/* The bin on the hash table is shared by all the grids */
+		if(pair_value.second <= master_grid->master_grid[0]) return 0;
+		return master_grid->bin(pair_value.second);
+	}
+	/* Index on the master grid */
+	master_grid->setIndex(pair_value);
+	return pair_value.first;
+}
+
+void ChildGridSet::index(size_t key, double energy, size_t first, size_t count, size_t* idx, double* factor) const {
+	if(master_grid->type == MasterGrid::HASHED) {
+		/* Search the energy inside the bin of each grid */
+		for(size_t i = 0 ; i < count ; ++i) {
+			const double* grid = grids[first + i];
+			const size_t* hash = tables[first + i];
+			long position = upper_bound(grid + hash[key], grid + hash[key + 1], energy) - grid - 1;
+			/* Out of bound energies are clamped to the first and last interval */
+			idx[i] = max(0L, min(position, last[first + i] - 1));
+		}
+	} else {
+		/* Gather from the master pointers (always inside the grid) */
+		for(size_t i = 0 ; i < count ; ++i)
+			idx[i] = tables[first + i][key];
+	}
+
+	/* Interpolation factors */
+	#pragma omp simd
+	for(size_t i = 0 ; i < count ; ++i) {
+		const double* grid = grids[first + i];
+		double low = grid[idx[i]];
+		double f = (energy - low) / (grid[idx[i] + 1] - low);
+		factor[i] = (f < 0.0) ? 0.0 : ((f > 1.0) ? 1.0 : f);
+	}
 }
 
 } /* namespace Helios */
@@ -30,6 +30,8 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <cmath>
 
 namespace Helios {
 
@@ -42,18 +44,63 @@ namespace Helios {
 	 * could have CHILD grids each one with its own grid. But each CHILD grid contains
 	 * a reference to the PARENT (i.e. MASTER) and a method to map global indexes (pointing
 	 * to the MASTER grid) to local indexes (pointing to the CHILD grid).
+	 *
+	 * On a HASHED grid the CHILD grids don't keep the array of master pointers. Instead,
+	 * the energy range is divided in equal lethargy bins and each grid keeps the
+	 * index of the first point on each bin, so a search is bounded to the few points
+	 * that fall inside a single bin.
 	 */
 	class MasterGrid {
+	public:
+		/* Type of lookup used by the CHILD grids */
+		enum GridType {
+			UNIONIZED = 0, /* Array of pointers from the MASTER grid to each CHILD grid */
+			HASHED    = 1  /* Logarithmic hash table on each CHILD grid */
+		};
+	private:
 		/* --- Master Grid */
 		std::vector<double> master_grid;
 
 		/* Container of child */
 		std::vector<ChildGrid*> child_grids;
+
+		/* Type of grid */
+		GridType type;
+
+		/* --- Logarithmic hash, shared by the MASTER and the CHILD grids */
+		double log_min;
+		double inv_delta;
+		/* Index of the first point of each bin on the master grid */
+		std::vector<size_t> master_hash;
+
+		/* Fill the table with the index of the first point of each bin on the grid */
+		void setupHash(const std::vector<double>& grid, std::vector<size_t>& hash) const;
+
+		/* Get the bin of some value */
+		size_t bin(const double& value) const {
+			size_t nbin = (size_t)((std::log(value) - log_min) * inv_delta);
+			return (nbin < hash_bins) ? nbin : hash_bins - 1;
+		}
+
+		/* Search the index of a value bounded by the hash table */
+		size_t search(const std::vector<double>& grid, const std::vector<size_t>& hash, const double& value) const {
+			size_t nbin = bin(value);
+			std::vector<double>::const_iterator begin = grid.begin();
+			return std::upper_bound(begin + hash[nbin], begin + hash[nbin + 1], value) - begin - 1;
+		}
+
+		friend class ChildGrid;
+		friend class ChildGridSet;
 	public:
 		/* Number of elements to reserve for the grid */
 		static size_t reserve_grid;
+		/* Number of bins on the logarithmic hash table */
+		static size_t hash_bins;
 
-		MasterGrid();
+		MasterGrid(GridType type = UNIONIZED);
+
+		/* Type of lookup used by the child grids */
+		GridType getType() const {return type;}
 
 		/* Size of the grid */
 		size_t size() const {return master_grid.size();}
@@ -103,8 +150,10 @@ namespace Helios {
 		const MasterGrid* master_grid;
 		/* Child Grid */
 		std::vector<double> child_grid;
-		/* Master Grid pointers */
+		/* Master Grid pointers (only on an UNIONIZED grid) */
 		std::vector<size_t> master_pointers;
+		/* Index of the first point of each bin (only on a HASHED grid) */
+		std::vector<size_t> child_hash;
 
 		/* Private constructor, this can be called ONLY from a Master grid */
 		ChildGrid(const MasterGrid* master_grid, const std::vector<double>& child_grid) :
@@ -115,6 +164,7 @@ namespace Helios {
 
 		/* Friendly master */
 		friend class MasterGrid;
+		friend class ChildGridSet;
 	public:
 
 		/* Size of the CHILD grid */
@@ -132,6 +182,44 @@ namespace Helios {
 		virtual ~ChildGrid() {/* */};
 	};
 
+	/*
+	 * A set of CHILD grids of the same MASTER grid, stored as nuclide-major arrays so the
+	 * index and the interpolation factor on all the grids can be obtained in a single loop.
+	 *
+	 * The lookup is done in two steps. First a key is obtained from the energy (the index on
+	 * the MASTER grid on an UNIONIZED grid, or the bin of the hash table on a HASHED grid),
+	 * which is shared by all the CHILD grids. Then the index on each CHILD grid is obtained from
+	 * the key with a gather (UNIONIZED) or a search bounded to the bin (HASHED).
+	 */
+	class ChildGridSet {
+		/* Master Grid */
+		const MasterGrid* master_grid;
+		/* Data of each child grid */
+		std::vector<const double*> grids;
+		std::vector<long> last;
+		/* Master pointers (UNIONIZED) or hash table (HASHED) of each child grid */
+		std::vector<const size_t*> tables;
+	public:
+		ChildGridSet() : master_grid(0) {/* */}
+
+		/* Add a child grid to the set (all the grids should have the same MASTER) */
+		void push(const ChildGrid* child_grid);
+
+		/* Number of grids on the set */
+		size_t size() const {return grids.size();}
+
+		/* Set MASTER index on the pair (if the grid is UNIONIZED) and return the key of this energy */
+		size_t key(std::pair<size_t,double>& pair_value) const;
+
+		/*
+		 * Get the index and the interpolation factor on the grids [first, first + count), using
+		 * the key of the energy. The results are the same as the ones of ChildGrid::index.
+		 */
+		void index(size_t key, double energy, size_t first, size_t count, size_t* idx, double* factor) const;
+
+		~ChildGridSet() {/* */}
+	};
+
 	template<class InputIterator>
 	ChildGrid* MasterGrid::pushGrid(InputIterator first, InputIterator last) {
 		/* Push data into the common grid */
@@ -42,5 +42,14 @@ std::ostream& operator<<(std::ostream& out, const Reaction& q) {
 	return out;
 }
 
+void Isotope::setXs(Energy& energy, XsCache& cache) const {
+	cache.absorption = getAbsorptionProb(energy);
+	cache.elastic = getElasticProb(energy);
+	if(fissile) {
+		cache.fission = getFissionProb(energy);
+		cache.isotope_nu_bar = getNuBar(energy);
+	}
+}
+
 }
 
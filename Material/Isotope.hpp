@@ -30,6 +30,7 @@
 
 #include "../Common/Common.hpp"
 #include "../Transport/Particle.hpp"
+#include "XsCache.hpp"
 
 namespace Helios {
 
@@ -64,6 +65,9 @@ namespace Helios {
 		virtual void print(std::ostream& out) const {/* Nothing by default */}
 		friend std::ostream& operator<<(std::ostream& out, const Isotope& q);
 
+		/* Evaluate the reaction probabilities on the cache (by default, calling each method) */
+		virtual void setXs(Energy& energy, XsCache& cache) const;
+
 		/* Internal identification of this isotope */
 		InternalIsotopeId internal_id;
 
@@ -91,6 +95,19 @@ namespace Helios {
 		/* -- Get elastic probability */
 		virtual double getElasticProb(Energy& energy) const = 0;
 
+		/*
+		 * -- Get the reaction probabilities (and NU-bar) at the particle energy. The data is
+		 * evaluated only if the cache doesn't contain this isotope at this energy.
+		 */
+		const XsCache& getXs(Energy& energy, XsCache& cache) const {
+			if(cache.isotope != this || cache.isotope_energy != energy) {
+				setXs(energy, cache);
+				cache.isotope = this;
+				cache.isotope_energy = energy;
+			}
+			return cache;
+		}
+
 		/*
 		 * -- Fission.
 		 *
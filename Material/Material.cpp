@@ -44,4 +44,15 @@ std::ostream& operator<<(std::ostream& out, const Material& q) {
 	return out;
 }
 
+void Material::setXs(Energy& energy, XsCache& cache) const {
+	cache.mfp = getMeanFreePath(energy);
+	cache.total = 1.0 / cache.mfp;
+	cache.index = energy.first;
+	cache.factor = 0.0;
+	if(fissile) {
+		cache.nu_fission = getNuFission(energy);
+		cache.nu_bar = getNuBar(energy);
+	}
+}
+
 } /* namespace Helios */
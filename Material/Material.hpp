@@ -82,6 +82,24 @@ namespace Helios {
 		 */
 		virtual const Isotope* getIsotope(Energy& energy, Random& random) const = 0;
 
+		/*
+		 * Get the macroscopic cross sections at the particle energy. The data is evaluated
+		 * only if the cache doesn't contain this material at this energy.
+		 */
+		const XsCache& getXs(Energy& energy, XsCache& cache) const {
+			if(cache.material != this || cache.energy != energy) {
+				setXs(energy, cache);
+				cache.material = this;
+				cache.energy = energy;
+			}
+			return cache;
+		}
+
+		/* Get an isotope using the macroscopic data on the cache (by default, same as above) */
+		virtual const Isotope* getIsotope(Energy& energy, Random& random, const XsCache& cache) const {
+			return getIsotope(energy, random);
+		}
+
 		/* ---- Material properties */
 
 		/* Return the atomic density of the material */
@@ -113,6 +131,9 @@ namespace Helios {
 		Material(const Material& mat);
 		Material& operator= (const Material& other);
 
+		/* Evaluate the macroscopic cross sections on the cache (by default, calling each method) */
+		virtual void setXs(Energy& energy, XsCache& cache) const;
+
 		/* Cell id choose by the user */
 		MaterialId user_id;
 		/* Internal identification of this material */
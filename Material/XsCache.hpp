@@ -0,0 +1,83 @@
+/*
+ Copyright (c) 2012, Esteban Pellegrino
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * Neither the name of the <organization> nor the
+ names of its contributors may be used to endorse or promote products
+ derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef XSCACHE_HPP_
+#define XSCACHE_HPP_
+
+#include "../Common/Common.hpp"
+
+namespace Helios {
+
+	class Material;
+	class Isotope;
+
+	/*
+	 * Cross sections seen by a particle at some energy. The macroscopic data is evaluated
+	 * once for each (material, energy) and the microscopic data once for each (isotope, energy),
+	 * so the estimators and the sampling routines can read the same values without doing the
+	 * energy lookups again.
+	 */
+	struct XsCache {
+
+		/* -- Macroscopic data */
+
+		/* Material and energy of the cached data */
+		const Material* material;
+		Energy energy;
+		/* Mean free path and total cross section */
+		double mfp;
+		double total;
+		/* NU-fission cross section and average NU (only on fissile materials) */
+		double nu_fission;
+		double nu_bar;
+		/* Index and interpolation factor on the energy grid of the material (if any) */
+		size_t index;
+		double factor;
+		/* Partial sums of the total cross section on each group of isotopes (materials evaluated on the fly) */
+		static const size_t max_groups = 64;
+		double group_sums[max_groups];
+
+		/* -- Microscopic data of the sampled isotope */
+
+		/* Isotope and energy of the cached data */
+		const Isotope* isotope;
+		Energy isotope_energy;
+		/* Reaction probabilities */
+		double absorption;
+		double fission;
+		double elastic;
+		/* Average NU of the isotope */
+		double isotope_nu_bar;
+
+		XsCache() : material(0), energy(0,0.0), mfp(0.0), total(0.0), nu_fission(0.0), nu_bar(0.0), index(0), factor(0.0),
+				    isotope(0), isotope_energy(0,0.0), absorption(0.0), fission(0.0), elastic(0.0), isotope_nu_bar(0.0) {/* */}
+
+		~XsCache() {/* */}
+	};
+
+} /* namespace Helios */
+#endif /* XSCACHE_HPP_ */
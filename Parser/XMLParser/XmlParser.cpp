@@ -119,6 +119,7 @@ void XmlParser::rootNode(TiXmlNode* pParent, const string& filename) {
 void XmlParser::parseInputFile(const string& file) {
 	/* Open document */
 	ticpp::Document doc(file.c_str());
+	directory = file.substr(0, file.find_last_of('/') + 1);
 	try {
 		/* Load document */
 		doc.LoadFile();
@@ -59,6 +59,9 @@ namespace Helios {
 		/* Parse a file */
 		void parseInputFile(const std::string& file);
 
+		/* Directory of the file being parsed (to find the files referenced on it) */
+		std::string directory;
+
 	public:
 
 		XmlParser();
@@ -54,21 +54,44 @@ static FeatureObject* latticeAttrib(TiXmlElement* pElement) {
 	return new LatticeObject(id,type,dimension,width,universes);
 }
 
+/* Parse mesh attributes (the file is relative to the directory of the input file) */
+static FeatureObject* meshAttrib(TiXmlElement* pElement, const string& directory) {
+	/* Initialize XML attribute checker */
+	static const string required[3] = {"id","file","materials"};
+	static XmlParser::XmlAttributes meshAttrib(vector<string>(required, required + 3), vector<string>());
+
+	XmlParser::AttribMap mapAttrib = dump_attribs(pElement);
+	/* Check user input */
+	meshAttrib.checkAttributes(mapAttrib,"mesh");
+
+	/* Get attributes */
+	UniverseId id = fromString<UniverseId>(mapAttrib["id"]);
+	string file = mapAttrib["file"];
+	if(file.size() > 0 && file[0] != '/') file = directory + file;
+	vector<MaterialId> materials = getContainer<MaterialId>(mapAttrib["materials"]);
+	/* Return mesh definition */
+	return new MeshObject(id,file,materials);
+}
+
 /* Initialization of values on the surface flag */
 static map<string,Surface::SurfaceInfo> initSurfaceInfo() {
 	map<string,Surface::SurfaceInfo> values_map;
 	values_map["reflective"] = Surface::REFLECTING;
 	values_map["vacuum"] = Surface::VACUUM;
+	values_map["periodic"] = Surface::PERIODIC;
+	values_map["rotational"] = Surface::ROTATIONAL;
 	return values_map;
 }
 /* Parse surface attributes */
 static SurfaceObject* surfaceAttrib(TiXmlElement* pElement) {
 	/* Initialize XML attribute checker */
 	static const string required[3] = {"id", "type", "coeffs"};
-	static const string optional[1] = {"boundary"};
-	static XmlParser::XmlAttributes surAttrib(vector<string>(required, required + 3), vector<string>(optional, optional + 1));
+	static const string optional[2] = {"boundary", "pair"};
+	static XmlParser::XmlAttributes surAttrib(vector<string>(required, required + 3), vector<string>(optional, optional + 2));
 	/* Surface flags values */
 	XmlParser::AttributeValue<Surface::SurfaceInfo> sur_flags("boundary",Surface::NONE,initSurfaceInfo());
+	/* Surface paired with this one on periodic boundaries */
+	XmlParser::AttributeValue<string> inp_pair("pair","");
 
 	XmlParser::AttribMap mapAttrib = dump_attribs(pElement);
 	/* Check user input */
@@ -79,8 +102,9 @@ static SurfaceObject* surfaceAttrib(TiXmlElement* pElement) {
 	string type = mapAttrib["type"];
 	vector<double> coeffs = getContainer<double>(mapAttrib["coeffs"]);
 	Surface::SurfaceInfo flags = sur_flags.getValue(mapAttrib);
+	SurfaceId pair = inp_pair.getString(mapAttrib);
 	/* Return surface definition */
-	return new SurfaceObject(id,type,coeffs,flags);
+	return new SurfaceObject(id,type,coeffs,flags,pair);
 }
 
 /* Initialization of values on the surface flag */
@@ -94,8 +118,8 @@ static map<string,Cell::CellInfo> initCellInfo() {
 static CellObject* cellAttrib(TiXmlElement* pElement) {
 	/* Initialize XML attribute checker */
 	static const string required[3] = {"id"};
-	static const string optional[6] = {"material","type","fill","universe","translation","surfaces"};
-	static XmlParser::XmlAttributes cellAttrib(vector<string>(required, required + 1), vector<string>(optional, optional + 6));
+	static const string optional[8] = {"material","type","fill","universe","translation","rotation","surfaces","temperature"};
+	static XmlParser::XmlAttributes cellAttrib(vector<string>(required, required + 1), vector<string>(optional, optional + 8));
 
 	/* Cell flags values */
 	XmlParser::AttributeValue<Cell::CellInfo> cell_flags("type",Cell::NONE,initCellInfo());
@@ -105,8 +129,12 @@ static CellObject* cellAttrib(TiXmlElement* pElement) {
 	XmlParser::AttributeValue<string> inp_fill("fill","0");
 	/* Translation */
 	XmlParser::AttributeValue<string> inp_translation("translation","0 0 0");
-	/* Material */
+	/* Rotation (degrees around each axis) */
+	XmlParser::AttributeValue<string> inp_rotation("rotation","0 0 0");
+	/* Material (one for all the instances of the cell, or one for each instance) */
 	XmlParser::AttributeValue<string> inp_material("material",Material::NONE);
+	/* Temperature (same as materials) */
+	XmlParser::AttributeValue<string> inp_temperature("temperature","");
 
 	XmlParser::AttribMap mapAttrib = dump_attribs(pElement);
 	/* Check user input */
@@ -122,7 +150,10 @@ static CellObject* cellAttrib(TiXmlElement* pElement) {
 	/* Get information about universes on this cell */
 	UniverseId universe = fromString<UniverseId>(inp_universe.getString(mapAttrib));
 	UniverseId fill = fromString<UniverseId>(inp_fill.getString(mapAttrib));
-	MaterialId matid = fromString<MaterialId>(inp_material.getString(mapAttrib));
+	vector<MaterialId> materials = getContainer<MaterialId>(inp_material.getString(mapAttrib));
+	if(materials.size() == 0)
+		materials.push_back(Material::NONE);
+	vector<double> temperatures = getContainer<double>(inp_temperature.getString(mapAttrib));
 
 	/* Get the translation coefficients */
 	std::istringstream sin_trans(reduce(inp_translation.getString(mapAttrib)));
@@ -135,8 +166,19 @@ static CellObject* cellAttrib(TiXmlElement* pElement) {
 		i++;
 	}
 
+	/* Get the rotation angles */
+	std::istringstream sin_rot(reduce(inp_rotation.getString(mapAttrib)));
+	Direction rot(0,0,0);
+	i = 0;
+	while(sin_rot.good()) {
+		double c;
+		sin_rot >> c;
+		rot[i] = c;
+		i++;
+	}
+
 	/* Return surface definition */
-	return new CellObject(id,surfaces_expression,flags,universe,fill,matid,trans);
+	return new CellObject(id,surfaces_expression,flags,universe,fill,materials,temperatures,Transformation(trans,rot));
 }
 
 void XmlParser::geoNode(TiXmlNode* pParent) {
@@ -152,6 +194,8 @@ void XmlParser::geoNode(TiXmlNode* pParent) {
 				objects.push_back(cellAttrib(pChild->ToElement()));
 			else if (element_value == "lattice")
 				objects.push_back(latticeAttrib(pChild->ToElement()));
+			else if (element_value == "mesh")
+				objects.push_back(meshAttrib(pChild->ToElement(),directory));
 			else {
 				vector<string> keywords;
 				keywords.push_back(element_value);